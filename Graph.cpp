@@ -2,10 +2,27 @@
 //
 
 #include <iostream>
+#include <string>
 #include "TGr.h"
+#include "TGrBench.h"
 
-int main()
+int main(int argc, char* argv[])
 {
+    // Graph --bench: только замеры производительности
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        bench_pagerank();
+        bench_reorder();
+        bench_compression();
+        bench_workspace();
+        bench_astar();
+        bench_ch();
+        bench_centrality();
+        bench_triangles();
+        bench_views();
+        bench_memory();
+        return 0;
+    }
+
     test_vertex_operations();
     test_edge_operations();
     test_bfs();
@@ -15,6 +32,31 @@ int main()
     test_get_weight();
     test_saveGraphML();
     test_loadGraphML();
+    test_generators();
+    test_stats();
+    test_allocator();
+    test_flat_index();
+    test_storage_policies();
+    test_shared_graph();
+    test_freeze();
+    test_batch_queries();
+    test_components();
+    test_dag_paths();
+    test_analytics();
+    test_reorder();
+    test_disk_graph();
+    test_compressed();
+    test_journal();
+    test_mutation_batch();
+    test_workspace();
+    test_reachability();
+    test_astar();
+    test_ch();
+    test_async_queries();
+    test_centrality();
+    test_triangles();
+    test_views();
+    test_memory_usage();
 
     std::cout << "Hello World!\n";
 }
@@ -9,34 +9,40 @@
 #include <cassert>
 #include <sstream>
 #include <algorithm>
+#include <memory_resource>
+#include <filesystem>
 #include "TGr.h"
+#include "TGrGen.h"
+#include "TGrShared.h"
+#include <thread>
+#include <atomic>
 
 using namespace std;
 
 
 /// <summary>
-///     (AddV, DeleteV, HasVert, Size)
+/// Тестирование операций с вершинами (AddV, DeleteV, HasVert, Size)
 /// </summary>
 void test_vertex_operations() {
-    //  INF = 1000000000
+    // Используем INF = 1000000000
     DGraph<string, double> g(1000000000);
 
-    //  
+    // пустой граф
     assert(g.Size() == 0);
     assert(!g.HasVert("A"));
 
-    //   
+    // добавление одной вершины
     g.AddV("A");
     assert(g.Size() == 1);
     assert(g.HasVert("A"));
 
-    //   
+    // добавление нескольких вершин
     g.AddV("B");
     g.AddV("C");
     assert(g.Size() == 3);
     assert(g.HasVert("B") && g.HasVert("C"));
 
-    //       
+    // попытка добавить уже существующую вершину выбрасывает исключение
     try {
         g.AddV("B");
         assert(false);
@@ -45,22 +51,22 @@ void test_vertex_operations() {
 
     }
 
-    //    
+    // удаление вершины в середине
     g.DeleteV("B");
     assert(g.Size() == 2);
     assert(!g.HasVert("B"));
-    //   
+    // другие вершины сохранились
     assert(g.HasVert("A") && g.HasVert("C"));
 
 }
 
 /// <summary>
-///     (AddE, DeleteE, HasEdge, GetEdge)
+/// Тестирование операций с рёбрами (AddE, DeleteE, HasEdge, GetEdge)
 /// </summary>
 void test_edge_operations() {
     DGraph<string, double> g(1000000000);
 
-    //       =  ( )
+    // пустой граф — попытка добавить ребро = исключение (вершин нет)
     try {
         g.AddE("A", "B", 1.0);
         assert(false);
@@ -69,27 +75,27 @@ void test_edge_operations() {
 
     }
 
-    //  , ,   
+    // создаём вершины, проверяем, что ребра отсутствуют
     g.AddV("A");
     g.AddV("B");
     g.AddV("C");
     assert(!g.HasEdge("A", "B"));
     assert(!g.HasEdge("A", "C"));
 
-    //   A->B
+    // добавляем ребро A->B
     g.AddE("A", "B", 2.5);
     assert(g.HasEdge("A", "B"));
     assert(g.GetEdge("A", "B") == 2.5);
 
-    //   
+    // редактируем ребро 
     g.AddE("A", "B", 7.0);
     assert(g.GetEdge("A", "B") == 7.0);
 
-    //  
+    // удаляем ребро
     g.DeleteE("A", "B");
     assert(!g.HasEdge("A", "B"));
 
-    //      
+    // попытка получить несуществующее ребро бросает исключение
     try {
         g.GetEdge("A", "B");
         assert(false);
@@ -98,7 +104,7 @@ void test_edge_operations() {
 
     }
 
-    //       
+    // операции с отсутствующей вершиной должны бросать исключение
     try {
         g.DeleteE("X", "Y");
         assert(false);
@@ -109,12 +115,12 @@ void test_edge_operations() {
 }
 
 /// <summary>
-///  BFS
+/// Тест BFS
 /// </summary>
 void test_bfs() {
     DGraph<string, double> g(1000000000);
 
-    //   =  BFS   
+    // пустой граф = запуск BFS должен бросить исключение
     try {
         g.BFS("A");
         assert(false);
@@ -123,33 +129,33 @@ void test_bfs() {
 
     }
 
-    //  
+    // один узел
     g.AddV("A");
     auto order1 = g.BFS("A");
     assert(order1.size() == 1 && order1[0] == "A");
 
-    //  ,   
+    // несколько вершин, но без рёбер
     g.AddV("B");
     g.AddV("C");
     auto order2 = g.BFS("A");
-    // BFS     , ..  
+    // BFS должен вернуть только стартовую вершину, т.к. нет рёбер
     assert(order2.size() == 1 && order2[0] == "A");
 
-    //   A->B->C
+    // простой путь A->B->C
     g.AddE("A", "B", 1.0);
     g.AddE("B", "C", 1.0);
     auto order3 = g.BFS("A");
-    // O : A, B, C
+    // Oжидаемый порядок: A, B, C
     assert(order3.size() == 3 && order3[0] == "A" && order3[1] == "B" && order3[2] == "C");
 
-    //   A->B, A->C, B->D, C->E
+    // ветвящийся граф A->B, A->C, B->D, C->E
     g.AddV("D");
     g.AddV("E");
     g.AddE("A", "C", 1.0);
     g.AddE("B", "D", 1.0);
     g.AddE("C", "E", 1.0);
     auto order4 = g.BFS("A");
-    // BFS  : A, (B,C), (D,E)    B  C    .
+    // BFS посетит уровни: A, (B,C), (D,E) — порядок между B и C зависит от индексов вершин.
     assert(order4.size() == 5);
     assert(order4[0] == "A");
     assert(order4[1] == "B");
@@ -157,25 +163,25 @@ void test_bfs() {
     assert(order4[3] == "D");
     assert(order4[4] == "E");
 
-    //    (A->B, B->A)
+    // граф с циклом (A->B, B->A)
     DGraph<string, double> g2(1000000000);
     g2.AddV("A");
     g2.AddV("B");
     g2.AddE("A", "B", 1.0);
     g2.AddE("B", "A", 1.0);
     auto order5 = g2.BFS("A");
-    // BFS   A  B    
+    // BFS должен посетить A и B ровно по одному разу
     assert(order5.size() == 2);
     assert(order5[0] == "A" && order5[1] == "B");
 }
 
 /// <summary>
-///  DFS
+/// Тест DFS
 /// </summary>
 void test_dfs() {
     DGraph<string, double> g(1000000000);
 
-    //   = 
+    // пустой граф = ошибка
     try {
         g.DFS("A");
         assert(false);
@@ -184,25 +190,25 @@ void test_dfs() {
 
     }
 
-    //  
+    // один узел
     g.AddV("A");
     auto o1 = g.DFS("A");
     assert(o1.size() == 1 && o1[0] == "A");
 
-    //    
+    // несколько вершин без рёбер
     g.AddV("B");
     g.AddV("C");
     auto o2 = g.DFS("A");
     assert(o2.size() == 1 && o2[0] == "A");
 
-    //   A->B->C
+    // простой путь A->B->C
     g.AddE("A", "B", 1.0);
     g.AddE("B", "C", 1.0);
     auto o3 = g.DFS("A");
     // A, B, C
     assert(o3.size() == 3 && o3[0] == "A" && o3[1] == "B" && o3[2] == "C");
 
-    //  
+    // ветвящийся граф
     g.AddV("D");
     g.AddV("E");
     g.AddE("A", "C", 1.0);
@@ -216,7 +222,7 @@ void test_dfs() {
     assert(o4[3] == "B");
     assert(o4[4] == "D");
 
-    //    A->B, B->A
+    // граф с циклом A->B, B->A
     DGraph<string, double> g2(1000000000);
     g2.AddV("A");
     g2.AddV("B");
@@ -227,14 +233,14 @@ void test_dfs() {
 }
 
 /// <summary>
-///  GetNeighbors
+/// Тест GetNeighbors
 /// </summary>
 void test_get_neighbors() {
 
     const double INF = 1000000000;
     DGraph<string, double> g(INF);
 
-    //   = GetNeighbors    ( )
+    // пустой граф = GetNeighbors должен бросить исключение (вершины нет)
     try {
         auto r = g.GetNeighbors("A");
         assert(false);
@@ -243,26 +249,26 @@ void test_get_neighbors() {
 
     }
 
-    //     -> neighbors 
+    // граф из одной вершины -> neighbors пуст
     g.AddV("A");
     {
         auto n = g.GetNeighbors("A");
         assert(n.empty());
     }
 
-    //  ,    -> neighbors 
+    // несколько вершин, но нет рёбер -> neighbors пуст
     g.AddV("B");
     g.AddV("C");
     {
         auto n = g.GetNeighbors("A");
         assert(n.empty());
-        //     
+        // Также проверить для другой вершины
         auto nb = g.GetNeighbors("B");
         assert(nb.empty());
     }
 
-    //    
-    //  200 ,   0->1..10
+    // большой разреженный граф 
+    // добавим 200 вершин, установим ребра 0->1..10
     DGraph<int, double> big(INF);
     const int N = 200;
     for (int i = 0; i < N; ++i)
@@ -272,27 +278,27 @@ void test_get_neighbors() {
 
     {
         auto neigh0 = big.GetNeighbors(0);
-        //   10 : 1..10
+        // Ожидаем ровно 10 соседей: 1..10
         assert(neigh0.size() == 10);
         for (int i = 1; i <= 10; ++i) {
-            //  big    int,   
+            // в big вершины представлены как int, поэтому проверяем присутствие
             assert(find(neigh0.begin(), neigh0.end(), i) != neigh0.end());
         }
-        // ,         (, 50)
+        // Уверимся, что почти все другие вершины не имеют соседей (например, 50)
         auto neigh50 = big.GetNeighbors(50);
         assert(neigh50.empty());
     }
 }
 
 /// <summary>
-///  GetWeight
+/// Тест GetWeight
 /// </summary>
 void test_get_weight() {
 
     const double INF = 1000000000;
     DGraph<string, double> g(INF);
 
-    //   = GetWeight   
+    // пустой граф = GetWeight должен бросить исключение
     try {
         double w = g.GetWeight("A", "B");
         assert(false);
@@ -301,7 +307,7 @@ void test_get_weight() {
 
     }
 
-    //     = GetWeight(A,A)   ( )
+    // граф из одной вершины = GetWeight(A,A) должно бросать (ребро отсутствует)
     g.AddV("A");
     try {
         double w = g.GetWeight("A", "A");
@@ -311,7 +317,7 @@ void test_get_weight() {
 
     }
 
-    //    A->B
+    // простое направленное ребро A->B
     g.AddV("B");
     g.AddE("A", "B", 3.5);
     {
@@ -319,10 +325,10 @@ void test_get_weight() {
         assert(w == 3.5);
     }
 
-    //     C->A
+    // есть только обратное ребро C->A
     g.AddV("C");
     g.AddE("C", "A", 2.0);
-    // GetWeight(A,C)    A->C =  
+    // GetWeight(A,C) — нет ребра A->C = бросит исключение
     try {
         double w = g.GetWeight("A", "C");
         assert(false);
@@ -331,13 +337,13 @@ void test_get_weight() {
 
     }
 
-    // GetWeight(C,A)  2.0
+    // GetWeight(C,A) вернёт 2.0
     {
         double w = g.GetWeight("C", "A");
         assert(w == 2.0);
     }
 
-    //   X <-> Y:  
+    // двунаправленное ребро X <-> Y: веса различны
     g.AddV("X");
     g.AddV("Y");
     g.AddE("X", "Y", 1.0);
@@ -348,7 +354,7 @@ void test_get_weight() {
         assert(wxy == 1.0 && wyx == 4.0);
     }
 
-    //  GetWeight    =  
+    // попытка GetWeight для несуществующей вершины = бросит ислючение
     try {
         g.GetWeight("test", "A");
         assert(false);
@@ -357,7 +363,7 @@ void test_get_weight() {
 
     }
 
-    //  :    
+    // большой граф: проверим корректность для цепочки
     DGraph<int, double> big(INF);
     const int M = 100;
     for (int i = 0; i < M; ++i)
@@ -365,7 +371,7 @@ void test_get_weight() {
     for (int i = 0; i < M - 1; ++i)
         big.AddE(i, i + 1, (double)i + 0.5);
 
-    //   
+    // проверка нескольких значений
     for (int i = 0; i < 99; ++i) {
         double w = big.GetWeight(i, i + 1);
         assert(w == (double)i + 0.5);
@@ -373,13 +379,13 @@ void test_get_weight() {
 }
 
 /// <summary>
-///  BellmanFord
+/// Тест BellmanFord
 /// </summary>
 void test_bellman_ford() {
     const double INF = 1000000000;
 
 
-    //   =       
+    // пустой граф = вызов с несуществующей вершиной должен бросить исключение
     {
         DGraph<string, double> g(INF);
         try {
@@ -391,34 +397,34 @@ void test_bellman_ford() {
         }
     }
 
-    //         = 0
+    // граф из одной вершины — расстояние до себя = 0
     {
         DGraph<string, double> g(INF);
         g.AddV("A");
         auto res = g.BellmanFord("A");
-        //        0
+        // должно быть ровно одна вершина и расстояние 0
         assert(res.size() == 1);
         assert(res[0] == 0.0);
     }
 
-    //  ,       0,  INF
+    // несколько вершин, но нет рёбер — только стартовая 0, остальные INF
     {
         DGraph<string, double> g(INF);
         g.AddV("A");
         g.AddV("B");
         g.AddV("C");
-        //  
+        // нет рёбер
         auto res = g.BellmanFord("A");
         assert(res.size() == 3);
-        // :  0 -> "A" ( ) = 0
+        // проверяем: индекс 0 -> "A" (добавлена первой) = 0
         assert(res[0] == 0.0);
-        //     (INF)
+        // остальные должны быть недостижимы (INF)
         assert((res[1]) == INF);
         assert((res[2]) == INF);
     }
 
-    //  ,    
-    // : A->B:5, A->C:2, C->B:-3 => A->B  C = -1
+    // отрицательные веса, но без отрицательного цикла
+    // Пример: A->B:5, A->C:2, C->B:-3 => A->B через C = -1
     {
         DGraph<string, double> g(INF);
         g.AddV("A");
@@ -428,14 +434,14 @@ void test_bellman_ford() {
         g.AddE("A", "C", 2.0);
         g.AddE("C", "B", -3.0);
         auto res = g.BellmanFord("A");
-        // : A = 0, C = 2, B = -1
+        // Ожидаем: A = 0, C = 2, B = -1
         assert(res.size() == 3);
         assert(res[0] == 0.0);    // A
         assert(res[2] == 2.0);    // C
-        assert(res[1] == -1.0);   // B  C: -1
+        assert(res[1] == -1.0);   // B через C: -1
     }
 
-    //    =    
+    // обнаружение отрицательного цикла = метод должен бросить исключение
     {
         DGraph<string, double> g(INF);
         g.AddV("A");
@@ -453,7 +459,7 @@ void test_bellman_ford() {
         }
     }
 
-    //      
+    // смесь достижимых и недостижимых вершин 
     {
         DGraph<int, double> g(INF);
         g.AddV(0);
@@ -462,16 +468,16 @@ void test_bellman_ford() {
         g.AddV(3);
         g.AddE(0, 1, 1.0);
         g.AddE(1, 2, 1.0);
-        //  3 
+        // вершина 3 изолирована
         auto res = g.BellmanFord(0);
         assert(res.size() == 4);
-        assert(res[0] == 0.0);   // 
+        assert(res[0] == 0.0);   // старт
         assert(res[1] == 1.0);
         assert(res[2] == 2.0);
-        assert((res[3]) == INF); // 
+        assert((res[3]) == INF); // недостижима
     }
 
-    //      N  
+    // большой граф — цепочка из N вершин 
     {
         DGraph<int, double> g(INF);
         const int N = 200;
@@ -481,7 +487,7 @@ void test_bellman_ford() {
             g.AddE(i, i + 1, 1.0);
         auto res = g.BellmanFord(0);
         assert(res.size() == N);
-        //   
+        // проверяем несколько точек
         assert(res[0] == 0.0);
         assert(res[1] == 1.0);
         assert(res[10] == 10.0);
@@ -490,12 +496,12 @@ void test_bellman_ford() {
 }
 
 /// <summary>
-///  saveGraphML
+/// Тест saveGraphML
 /// </summary>
 void test_saveGraphML() {
     const double INF = 1000000000;
 
-    //   
+    // пустой граф 
     {
         string fname = "test_save_empty.graphml";
         remove(fname.c_str());
@@ -503,7 +509,7 @@ void test_saveGraphML() {
         DGraph<string, double> g(INF);
         g.saveGraphML(fname);
 
-        //      graphml header
+        // Файл должен существовать и содержать graphml header
         ifstream f(fname);
         assert(f.is_open());
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
@@ -513,7 +519,7 @@ void test_saveGraphML() {
         assert(content.find("<graph") != string::npos);
     }
 
-    //   
+    // один узел 
     {
         string fname = "test_save_one_node.graphml";
         remove(fname.c_str());
@@ -527,12 +533,12 @@ void test_saveGraphML() {
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
         f.close();
 
-        //   node n0  label A
+        // Должен присутствовать node n0 и label A
         assert(content.find("node id=\"n0\"") != string::npos);
         assert(content.find("A") != string::npos);
     }
 
-    //     
+    // несколько вершин без рёбер 
     {
         string fname = "test_save_nodes_no_edges.graphml";
         remove(fname.c_str());
@@ -548,7 +554,7 @@ void test_saveGraphML() {
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
         f.close();
 
-        //    "<node"
+        // Проверим количество появлений "<node"
         size_t pos = 0;
         int nodeCount = 0;
         while ((pos = content.find("<node", pos)) != string::npos) {
@@ -557,11 +563,11 @@ void test_saveGraphML() {
         }
         assert(nodeCount == 3);
 
-        //       <edge> (  )
+        // В файле не должно быть тегов <edge> (поскольку нет рёбер)
         assert(content.find("<edge") == string::npos);
     }
 
-    //      
+    // граф с рёбрами и весами 
     {
         string fname = "test_save_edges.graphml";
         remove(fname.c_str());
@@ -577,14 +583,14 @@ void test_saveGraphML() {
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
         f.close();
 
-        //   edge  source n0 target n1   5.5
+        // Ожидаем наличие edge с source n0 target n1 и вес 5.5
         assert(content.find("<edge") != string::npos);
         assert(content.find("source=\"n0\"") != string::npos);
         assert(content.find("target=\"n1\"") != string::npos);
         assert(content.find("5.5") != string::npos);
     }
 
-    //   
+    // большой граф 
     {
         string fname = "test_save_large.graphml";
         remove(fname.c_str());
@@ -597,25 +603,25 @@ void test_saveGraphML() {
             g.AddE(i, i + 1, 1.0);
         g.saveGraphML(fname);
 
-        //    
+        // Открываем файл обычным способом
         ifstream f(fname);
         assert(f.is_open());
 
-        //    
+        // Читаем содержимое в строку
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
 
         f.close();
 
-        //   
+        // Проверка размера 
         assert(content.length() > 1000);
 
-        //    
+        //  Проверки узлов 
         assert(content.find("<node id=\"n0\"") != string::npos);
         assert(content.find("<node id=\"n10\"") != string::npos);
         assert(content.find("<node id=\"n50\"") != string::npos);
         assert(content.find("<node id=\"n99\"") != string::npos);
 
-        //    
+        //  Проверки рёбер 
         assert(content.find("<edge isDirected=\"true\" source=\"n0\" target=\"n1\"") != string::npos);
         assert(content.find("<edge isDirected=\"true\" source=\"n10\" target=\"n11\"") != string::npos);
         assert(content.find("<edge isDirected=\"true\" source=\"n50\" target=\"n51\"") != string::npos);
@@ -623,7 +629,7 @@ void test_saveGraphML() {
     }
 
 
-    //   (save ) 
+    // перезапись файла (save дважды) 
     {
         string fname = "test_save_overwrite.graphml";
         remove(fname.c_str());
@@ -632,7 +638,7 @@ void test_saveGraphML() {
         g.AddV("X");
         g.saveGraphML(fname);
 
-        //       
+        // Сохраняем другой граф в тот же файл
         DGraph<string, double> g2(INF);
         g2.AddV("Y");
         g2.saveGraphML(fname);
@@ -642,7 +648,7 @@ void test_saveGraphML() {
         string content((istreambuf_iterator<char>(f)), istreambuf_iterator<char>());
         f.close();
 
-        // ,     
+        // Проверяем, что записался именно новый граф
         assert(content.find("name = \"Y\"") != string::npos);
         assert(content.find("name = \"X\"") == string::npos);
 
@@ -650,12 +656,12 @@ void test_saveGraphML() {
 }
 
 /// <summary>
-///  loadGraphML
+/// Тест loadGraphML
 /// </summary>
 void test_loadGraphML() {
     const double INF = 1000000000;
 
-    //   =)
+    // несуществующий файл =ошибка)
     {
         string fname = "this_file_does_not_exist.graphml";
         remove(fname.c_str());
@@ -670,7 +676,7 @@ void test_loadGraphML() {
         }
     }
 
-    //   
+    // пустой файл 
     {
         string fname = "test_load_empty.graphml";
         {
@@ -684,7 +690,7 @@ void test_loadGraphML() {
         remove(fname.c_str());
     }
 
-    //   
+    // один узел 
     {
         string fname = "test_load_one_node.graphml";
         ofstream f(fname);
@@ -704,7 +710,7 @@ void test_loadGraphML() {
         remove(fname.c_str());
     }
 
-    //      
+    // несколько вершин без рёбер  
     {
         string fname = "test_load_nodes_no_edges.graphml";
         ofstream f(fname);
@@ -726,7 +732,7 @@ void test_loadGraphML() {
         remove(fname.c_str());
     }
 
-    //      
+    // файл с рёбрами и весами 
     {
         string fname = "test_load_edges.graphml";
         ofstream f(fname);
@@ -750,7 +756,7 @@ void test_loadGraphML() {
         remove(fname.c_str());
     }
 
-    //   
+    // большой файл 
     {
         string fname = "test_load_large.graphml";
         ofstream f(fname);
@@ -780,4 +786,2349 @@ void test_loadGraphML() {
 
         remove(fname.c_str());
     }
+}
+
+/// <summary>
+/// Тест генераторов графов (TGrGen.h)
+/// </summary>
+void test_generators() {
+    const double INF = 1000000000;
+
+    // цепочка: n-1 рёбер, расстояния по BellmanFord равны номеру вершины
+    {
+        auto edges = GenChain<double>(50);
+        assert(edges.size() == 49);
+        auto g = GenBuild(50, edges, INF);
+        auto dist = g.BellmanFord(0);
+        assert(dist[49] == 49.0);
+    }
+
+    // решётка 3x4: 2 * (3 * 3 + 4 * 2) рёбер в обе стороны
+    {
+        auto edges = GenGrid<double>(3, 4);
+        assert(edges.size() == 34);
+        auto g = GenBuild(12, edges, INF);
+        assert(g.HasEdge(0, 1) && g.HasEdge(1, 0) && g.HasEdge(0, 4));
+        assert(!g.HasEdge(3, 4));
+        assert(g.BFS(0).size() == 12);
+    }
+
+    // одинаковое зерно даёт одинаковый граф при любом числе потоков
+    {
+        GenWeights<double> w;
+        w.minW = 1.0;
+        w.maxW = 10.0;
+        GenOptions one;
+        one.seed = 42;
+        one.threads = 1;
+        GenOptions four = one;
+        four.threads = 4;
+
+        auto er1 = GenErdosRenyi(10000, 0.001, false, w, one);
+        auto er4 = GenErdosRenyi(10000, 0.001, false, w, four);
+        assert(!er1.empty() && er1 == er4);
+        for (const auto& e : er1)
+            assert(e.from != e.to && e.weight >= 1.0 && e.weight <= 10.0);
+
+        auto rm1 = GenRMAT(12, 8, 0.57, 0.19, 0.19, w, one);
+        auto rm4 = GenRMAT(12, 8, 0.57, 0.19, 0.19, w, four);
+        assert(rm1.size() == (size_t(8) << 12) && rm1 == rm4);
+
+        GenOptions other = one;
+        other.seed = 43;
+        assert(GenRMAT(12, 8, 0.57, 0.19, 0.19, w, other) != rm1);
+
+        GenSortUnique(rm1);
+        for (size_t i = 1; i < rm1.size(); ++i)
+            assert(rm1[i - 1].from < rm1[i].from || (rm1[i - 1].from == rm1[i].from && rm1[i - 1].to < rm1[i].to));
+    }
+
+    // Барабаши–Альберт: m рёбер от каждой новой вершины, без повторов
+    {
+        auto edges = GenBarabasiAlbert<int>(300, 3);
+        assert(edges.size() == size_t(297) * 3);
+        GenSortUnique(edges);
+        assert(edges.size() == size_t(297) * 3);
+    }
+
+    // отрицательные веса через потенциалы: отрицательные рёбра есть, отрицательных циклов нет
+    {
+        GenWeights<double> w;
+        w.minW = 1.0;
+        w.maxW = 5.0;
+        w.potential = 20.0;
+        auto edges = GenErdosRenyi(60, 0.1, false, w);
+        bool negative = false;
+        for (const auto& e : edges)
+            negative = negative || e.weight < 0;
+        assert(negative);
+        auto g = GenBuild(60, edges, INF);
+        auto dist = g.BellmanFord(0);
+        assert(dist.size() == 60);
+    }
+}
+
+/// <summary>
+/// Тест счётчиков статистики (GetStats, ResetStats, SetTraceCallback)
+/// </summary>
+void test_stats() {
+    DGraph<string, double> g(1000000000);
+    g.AddV("A");
+    g.AddV("B");
+    g.AddV("C");
+    g.AddE("A", "B", 1.0);
+    g.AddE("B", "C", 1.0);
+    g.ResetStats();
+
+    int traced = 0;
+    g.SetTraceCallback([&traced](const char* op, const DGraphStats& call) {
+        assert(op != nullptr && call.calls == 1);
+        ++traced;
+    });
+
+    g.BFS("A");
+    g.BellmanFord("A");
+    DGraphStats s = g.GetStats();
+
+#ifdef DGRAPH_STATS
+    assert(traced == 2);
+    assert(s.calls == 2);
+    // BFS: 3 вершины по 3 элемента строки; BellmanFord: 2 прохода + проверка по 9 элементов
+    assert(s.edgesScanned == 9 + 27);
+    assert(s.queuePushes == 3);
+    assert(s.relaxations == 2);
+    assert(s.indexProbes >= 2);
+    assert(s.scratchArrays > 0);
+
+    g.ResetStats();
+    s = g.GetStats();
+    assert(s.calls == 0 && s.edgesScanned == 0);
+#else
+    // без DGRAPH_STATS счётчики не собираются
+    assert(traced == 0);
+    assert(s.calls == 0 && s.edgesScanned == 0 && s.relaxations == 0);
+#endif
+}
+
+/// <summary>
+/// Ресурс памяти, считающий выделения (для test_allocator)
+/// </summary>
+class CountingResource : public pmr::memory_resource {
+public:
+    size_t allocations = 0;
+    size_t bytes = 0;
+
+    explicit CountingResource(pmr::memory_resource* upstream) : upstream(upstream) {}
+
+private:
+    pmr::memory_resource* upstream;
+
+    void* do_allocate(size_t n, size_t align) override {
+        ++allocations;
+        bytes += n;
+        return upstream->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, size_t n, size_t align) override {
+        upstream->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(const pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+};
+
+/// <summary>
+/// Тест графа с пользовательским распределителем памяти (PmrDGraph)
+/// </summary>
+void test_allocator() {
+    const double INF = 1000000000;
+
+    // граф в арене: все выделения идут через ресурс
+    {
+        CountingResource counter(pmr::new_delete_resource());
+        pmr::monotonic_buffer_resource arena(&counter);
+
+        PmrDGraph<int, double> g(INF, pmr::polymorphic_allocator<char>(&arena));
+        assert(g.GetAllocator().resource() == &arena);
+        const int N = 50;
+        for (int i = 0; i < N; ++i)
+            g.AddV(i);
+        for (int i = 0; i < N - 1; ++i)
+            g.AddE(i, i + 1, 1.0);
+        assert(counter.allocations > 0);
+
+        auto order = g.BFS(0);
+        assert(order.size() == N);
+        auto dfs = g.DFS(0);
+        assert(dfs.size() == N);
+        auto dist = g.BellmanFord(0);
+        assert(dist[N - 1] == double(N - 1));
+
+        g.DeleteV(10);
+        assert(g.Size() == N - 1 && !g.HasEdge(9, 11));
+    }
+
+    // граф по умолчанию и pmr-граф ведут себя одинаково
+    {
+        pmr::monotonic_buffer_resource arena;
+        PmrDGraph<string, double> a(INF, pmr::polymorphic_allocator<char>(&arena));
+        DGraph<string, double> b(INF);
+        for (const char* v : { "A", "B", "C", "D" }) {
+            a.AddV(v);
+            b.AddV(v);
+        }
+        a.AddE("A", "B", 2.0);
+        b.AddE("A", "B", 2.0);
+        a.AddE("A", "C", 1.0);
+        b.AddE("A", "C", 1.0);
+        a.AddE("C", "D", 5.0);
+        b.AddE("C", "D", 5.0);
+        assert(a.BFS("A") == b.BFS("A"));
+        assert(a.DFS("A") == b.DFS("A"));
+        assert(a.BellmanFord("A") == b.BellmanFord("A"));
+        assert(a.GetNeighbors("C") == b.GetNeighbors("C"));
+    }
+}
+
+/// <summary>
+/// Тест плоского индекса вершин и интернирования строк (TGrIndex.h)
+/// </summary>
+void test_flat_index() {
+    const double INF = 1000000000;
+
+    // FlatIndex: вставка, поиск, удаление с перестройкой
+    {
+        vector<int> keys;
+        FlatIndex<int> index;
+        const int N = 5000;
+        for (int i = 0; i < N; ++i) {
+            keys.push_back(i * 7919);
+            index.Insert(keys.back(), i, keys);
+        }
+        assert(index.Size() == N);
+        for (int i = 0; i < N; ++i)
+            assert(index.Find(i * 7919, keys) == i);
+        assert(index.Find(-1, keys) == -1);
+        assert(index.Find(7918, keys) == -1);
+
+        // удаляем чётные, нечётные должны находиться
+        for (int i = 0; i < N; i += 2)
+            assert(index.Erase(keys[i], keys));
+        assert(!index.Erase(keys[0], keys));
+        assert(index.Size() == N / 2);
+        for (int i = 0; i < N; ++i)
+            assert(index.Find(keys[i], keys) == (i % 2 ? i : -1));
+
+        index.ShrinkToFit(keys);
+        for (int i = 1; i < N; i += 2)
+            assert(index.Find(keys[i], keys) == i);
+    }
+
+    // граф с большим числом вершин и удалением из середины
+    {
+        DGraph<string, double> g(INF);
+        for (int i = 0; i < 300; ++i)
+            g.AddV("v" + to_string(i));
+        g.AddE("v0", "v299", 1.0);
+        g.DeleteV("v150");
+        assert(g.Size() == 299);
+        assert(!g.HasVert("v150"));
+        for (int i = 0; i < 300; ++i)
+            assert(g.HasVert("v" + to_string(i)) == (i != 150));
+        assert(g.GetWeight("v0", "v299") == 1.0);
+    }
+
+    // пул строк: одинаковое содержимое - один и тот же IStr
+    {
+        InternPool pool;
+        IStr a = pool.Intern("Moscow");
+        IStr b = pool.Intern(string("Mos") + "cow");
+        IStr c = pool.Intern("Kazan");
+        assert(a == b && a != c);
+        assert(a.view() == "Moscow" && string(c.c_str()) == "Kazan");
+        assert(pool.Size() == 2);
+        assert(pool.Find("Kazan") == c);
+        assert(!pool.Find("Omsk"));
+
+        // много строк: указатели остаются действительными при росте пула
+        vector<IStr> all;
+        for (int i = 0; i < 20000; ++i)
+            all.push_back(pool.Intern("city" + to_string(i)));
+        assert(a.view() == "Moscow");
+        for (int i = 0; i < 20000; i += 997)
+            assert(all[i].view() == "city" + to_string(i));
+
+        // граф с интернированными вершинами
+        DGraph<IStr, double> g(INF);
+        g.AddV(a);
+        g.AddV(c);
+        g.AddV(pool.Intern("Omsk"));
+        g.AddE(pool.Intern("Moscow"), pool.Intern("Kazan"), 800.0);
+        g.AddE(pool.Intern("Kazan"), pool.Intern("Omsk"), 1900.0);
+        assert(g.HasEdge(a, c));
+        auto dist = g.BellmanFord(a);
+        assert(dist[2] == 2700.0);
+        auto order = g.BFS(a);
+        assert(order.size() == 3 && order[2].view() == "Omsk");
+    }
+}
+
+/// <summary>
+/// Сравнение графа с другой политикой хранения с эталонным (DenseSentinel)
+/// </summary>
+template <typename G>
+static void check_same_as_dense(const DGraph<int, double>& ref, const G& g) {
+    assert(g.Size() == ref.Size());
+    for (int u = 0; u < ref.Size(); ++u) {
+        for (int v = 0; v < ref.Size(); ++v) {
+            assert(g.HasEdge(u, v) == ref.HasEdge(u, v));
+            if (ref.HasEdge(u, v))
+                assert(g.GetWeight(u, v) == ref.GetWeight(u, v));
+        }
+    }
+    for (int s = 0; s < ref.Size(); s += 7) {
+        assert(g.BFS(s) == ref.BFS(s));
+        assert(g.DFS(s) == ref.DFS(s));
+        assert(g.BellmanFord(s) == ref.BellmanFord(s));
+        assert(g.GetNeighbors(s) == ref.GetNeighbors(s));
+    }
+}
+
+/// <summary>
+/// Тест политик хранения DGraph (DenseSentinel, DenseBitmap, AdjacencyList, Unweighted, 64-битный индекс)
+/// </summary>
+void test_storage_policies() {
+    const double INF = 1000000000;
+
+    GenWeights<double> w;
+    w.minW = 1.0;
+    w.maxW = 9.0;
+    GenOptions opt;
+    opt.seed = 7;
+    const int N = 130;
+    auto edges = GenErdosRenyi(N, 0.05, true, w, opt);
+
+    DGraph<int, double> dense(INF);
+    DGraph<int, double, allocator<char>, DenseBitmap> bitmap(INF);
+    DGraph<int, double, allocator<char>, AdjacencyList> lists(INF);
+    DGraph<int, double, allocator<char>, AdjacencyList, int64_t> lists64(INF);
+    for (int i = 0; i < N; ++i) {
+        dense.AddV(i);
+        bitmap.AddV(i);
+        lists.AddV(i);
+        lists64.AddV(i);
+    }
+    for (const auto& e : edges) {
+        dense.AddE(e.from, e.to, e.weight);
+        bitmap.AddE(e.from, e.to, e.weight);
+        lists.AddE(e.from, e.to, e.weight);
+        lists64.AddE(e.from, e.to, e.weight);
+    }
+    check_same_as_dense(dense, bitmap);
+    check_same_as_dense(dense, lists);
+    check_same_as_dense(dense, lists64);
+
+    // удаление рёбер и вершин (в том числе на границе 64-битного слова)
+    for (int v : { 64, 3, 100 }) {
+        dense.DeleteV(v);
+        bitmap.DeleteV(v);
+        lists.DeleteV(v);
+        lists64.DeleteV(v);
+    }
+    for (const auto& e : edges) {
+        if (e.from % 5 == 0 && dense.HasVert(e.from) && dense.HasVert(e.to)) {
+            dense.DeleteE(e.from, e.to);
+            bitmap.DeleteE(e.from, e.to);
+            lists.DeleteE(e.from, e.to);
+            lists64.DeleteE(e.from, e.to);
+        }
+    }
+    for (int u = 0; u < N; ++u) {
+        if (!dense.HasVert(u))
+            continue;
+        for (int v = 0; v < N; ++v) {
+            if (!dense.HasVert(v))
+                continue;
+            assert(bitmap.HasEdge(u, v) == dense.HasEdge(u, v));
+            assert(lists.HasEdge(u, v) == dense.HasEdge(u, v));
+            assert(lists64.HasEdge(u, v) == dense.HasEdge(u, v));
+        }
+    }
+    assert(bitmap.BFS(0) == dense.BFS(0) && lists.DFS(0) == dense.DFS(0));
+    assert(lists64.BellmanFord(0) == dense.BellmanFord(0));
+
+    // невзвешенный граф достижимости: только битовая карта
+    {
+        DGraph<string, Unweighted, allocator<char>, DenseBitmap> g(Unweighted{});
+        g.AddV("A");
+        g.AddV("B");
+        g.AddV("C");
+        g.AddE("A", "B", Unweighted{});
+        g.AddE("B", "C", Unweighted{});
+        assert(g.HasEdge("A", "B") && !g.HasEdge("B", "A"));
+        auto order = g.BFS("A");
+        assert(order.size() == 3 && order[2] == "C");
+        g.DeleteE("A", "B");
+        assert(g.BFS("A").size() == 1);
+        g.DeleteV("A");
+        assert(g.HasEdge("B", "C"));
+    }
+    {
+        DGraph<int, Unweighted, allocator<char>, AdjacencyList> g(Unweighted{});
+        for (int i = 0; i < 10; ++i)
+            g.AddV(i);
+        for (int i = 0; i < 9; ++i)
+            g.AddE(i, i + 1, Unweighted{});
+        assert(g.DFS(0).size() == 10);
+        assert(g.GetNeighbors(5).size() == 2);
+    }
+}
+
+/// <summary>
+/// Тест одновременного чтения снимков и публикации изменений (SharedDGraph)
+/// </summary>
+void test_shared_graph() {
+    const double INF = 1000000000;
+
+    DGraph<int, double> initial(INF);
+    initial.AddV(0);
+    SharedDGraph<DGraph<int, double>> shared(initial);
+
+    // снимок не меняется после публикации
+    auto before = shared.Snapshot();
+    {
+        auto w = shared.BeginWrite();
+        w.AddV(1);
+        w.AddE(0, 1, 1.0);
+        // до публикации читатели видят старую версию
+        assert(shared.Snapshot()->Size() == 1);
+        assert(w.Publish() == 2);
+    }
+    assert(before->Size() == 1 && shared.Snapshot()->Size() == 2);
+
+    // исключение внутри Update - версия не публикуется
+    try {
+        shared.Update([](DGraph<int, double>& g) { g.AddV(0); });
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    assert(shared.Version() == 2);
+
+    // читатели обходят граф, пока писатель наращивает цепочку 0->1->...->k;
+    // каждый снимок должен быть целостным: BFS из 0 достигает всех вершин снимка
+    atomic<bool> done(false);
+    atomic<int> reads(0);
+    vector<thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([&]() {
+            SharedDGraph<DGraph<int, double>>::Reader r(shared);
+            while (!done.load()) {
+                const DGraph<int, double>& g = r.Get();
+                auto order = g.BFS(0);
+                assert(static_cast<int>(order.size()) == g.Size());
+                auto dist = g.BellmanFord(0);
+                assert(dist[g.Size() - 1] == double(g.Size() - 1));
+                ++reads;
+            }
+        });
+    }
+
+    for (int k = 2; k < 60; k += 3) {
+        shared.Update([k](DGraph<int, double>& g) {
+            for (int v = k; v < k + 3; ++v) {
+                g.AddV(v);
+                g.AddE(v - 1, v, 1.0);
+            }
+        });
+    }
+    while (reads.load() < 20)
+        this_thread::yield();
+    done = true;
+    for (auto& th : readers)
+        th.join();
+
+    assert(shared.Snapshot()->Size() == 62);
+    assert(shared.Snapshot()->HasEdge(60, 61));
+}
+
+/// <summary>
+/// Тест замороженного графа (Freeze, FrozenDGraph)
+/// </summary>
+void test_freeze() {
+    const double INF = 1000000000;
+
+    // запросы замороженного графа совпадают с исходным
+    GenOptions opt;
+    opt.seed = 11;
+    const int N = 120;
+    auto edges = GenErdosRenyi(N, 0.04, true, GenWeights<double>(), opt);
+    auto g = GenBuild(N, edges, INF);
+    auto f = g.Freeze();
+
+    assert(f.Size() == g.Size());
+    assert(f.EdgeCount() == edges.size());
+    for (int u = 0; u < N; ++u) {
+        assert(f.HasVert(u));
+        for (int v = 0; v < N; ++v) {
+            assert(f.HasEdge(u, v) == g.HasEdge(u, v));
+            if (g.HasEdge(u, v))
+                assert(f.GetWeight(u, v) == g.GetWeight(u, v));
+        }
+        assert(f.GetNeighbors(u) == g.GetNeighbors(u));
+    }
+    for (int s = 0; s < N; s += 5) {
+        assert(f.BFS(s) == g.BFS(s));
+        assert(f.DFS(s) == g.DFS(s));
+        assert(f.BellmanFord(s) == g.BellmanFord(s));
+    }
+    assert(!f.HasVert(N) && !f.HasEdge(0, N));
+
+    // ошибки как у DGraph
+    try {
+        f.BFS(-1);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // отрицательный цикл обнаруживается
+    {
+        DGraph<string, double> c(INF);
+        c.AddV("A");
+        c.AddV("B");
+        c.AddV("C");
+        c.AddE("A", "B", 1.0);
+        c.AddE("B", "C", -2.0);
+        c.AddE("C", "A", -1.0);
+        auto fc = c.Freeze();
+        try {
+            fc.BellmanFord("A");
+            assert(false);
+        }
+        catch (const runtime_error&) {
+
+        }
+        assert(fc.GetNeighbors("A") == c.GetNeighbors("A"));
+        // граф-источник можно менять, замороженная копия не меняется
+        c.DeleteE("A", "B");
+        assert(fc.HasEdge("A", "B"));
+    }
+
+    // замороженный граф из списков смежности; общий доступ из нескольких потоков
+    {
+        DGraph<int, double, allocator<char>, AdjacencyList> lg(INF);
+        for (int i = 0; i < N; ++i)
+            lg.AddV(i);
+        for (const auto& e : edges)
+            lg.AddE(e.from, e.to, e.weight);
+        const auto shared = lg.Freeze();
+        auto expected = shared.BFS(0);
+        vector<thread> readers;
+        atomic<int> ok(0);
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&]() {
+                for (int i = 0; i < 50; ++i)
+                    if (shared.BFS(0) == expected && shared.HasEdge(edges[i].from, edges[i].to))
+                        ++ok;
+            });
+        }
+        for (auto& th : readers)
+            th.join();
+        assert(ok == 200);
+    }
+}
+
+/// <summary>
+/// Тест пакетных запросов
+/// </summary>
+void test_batch_queries() {
+    const double INF = 1000000000;
+    ThreadPool pool(3);
+    assert(pool.Workers() == 3);
+
+    // пакетный Форд-Беллман совпадает с последовательными вызовами
+    GenOptions opt;
+    opt.seed = 5;
+    const int N = 150;
+    auto edges = GenErdosRenyi(N, 0.03, false, GenWeights<double>(), opt);
+    auto g = GenBuild(N, edges, INF);
+    vector<int> sources;
+    for (int s = 0; s < N; s += 3)
+        sources.push_back(s);
+    auto bf = g.BatchBellmanFord(sources, pool);
+    assert(bf.rows == sources.size() && bf.cols == static_cast<size_t>(N));
+    assert(bf.Complete());
+    for (size_t i = 0; i < sources.size(); ++i) {
+        vector<double> d = g.BellmanFord(sources[i]);
+        assert(equal(d.begin(), d.end(), bf.Row(i)));
+    }
+
+    // пакетный BFS: число рёбер пути, -1 - недостижима
+    DGraph<string, int> h(0);
+    h.AddV("A");
+    h.AddV("B");
+    h.AddV("C");
+    h.AddV("D");
+    h.AddE("A", "B", 5);
+    h.AddE("B", "C", 5);
+    h.AddE("A", "C", 5);
+    vector<string> hs = { "A", "C", "X" };
+    auto hops = h.BatchBFS(hs, pool);
+    assert(hops.status[0] == QueryStatus::Done && hops.status[1] == QueryStatus::Done);
+    assert(hops.At(0, 0) == 0 && hops.At(0, 1) == 1 && hops.At(0, 2) == 1 && hops.At(0, 3) == -1);
+    assert(hops.At(1, 2) == 0 && hops.At(1, 0) == -1);
+    // неизвестный источник не прерывает пакет
+    assert(hops.status[2] == QueryStatus::Failed && !hops.Complete());
+
+    // отрицательный цикл отмечается в строке
+    {
+        DGraph<string, double> c(INF);
+        c.AddV("A");
+        c.AddV("B");
+        c.AddV("Z");
+        c.AddE("A", "B", 1.0);
+        c.AddE("B", "A", -2.0);
+        vector<string> cs = { "A", "Z" };
+        auto r = c.BatchBellmanFord(cs, pool);
+        assert(r.status[0] == QueryStatus::Failed);
+        assert(r.status[1] == QueryStatus::Done && r.At(1, 2) == 0 && r.At(1, 0) == INF);
+    }
+
+    // отмена и крайний срок
+    atomic<bool> cancel(true);
+    QueryControl ctl;
+    ctl.cancel = &cancel;
+    auto cancelled = g.BatchBFS(sources, pool, ctl);
+    for (QueryStatus st : cancelled.status)
+        assert(st == QueryStatus::Cancelled);
+
+    QueryControl late;
+    late.Within(chrono::milliseconds(-1));
+    auto timedOut = g.BatchBellmanFord(sources, pool, late);
+    for (QueryStatus st : timedOut.status)
+        assert(st == QueryStatus::Timeout);
+
+    // пул переиспользуется, вложенный ParallelFor не блокируется
+    atomic<int> sum(0);
+    pool.ParallelFor(0, 8, 1, [&](size_t, unsigned) {
+        pool.ParallelFor(0, 8, 2, [&](size_t j, unsigned slot) {
+            assert(slot <= pool.Workers());
+            sum += static_cast<int>(j);
+        });
+    });
+    assert(sum == 8 * 28);
+
+    // два внешних потока на одном пуле: внутри каждого вызова номера рабочих областей
+    // не используются одновременно несколькими участниками
+    {
+        atomic<int> clashes(0);
+        BatchResult<int> expect = g.BatchBFS(sources, pool);
+        vector<BatchResult<int>> got(2);
+        vector<thread> callers;
+        for (int t = 0; t < 2; ++t)
+            callers.emplace_back([&, t]() {
+                for (int k = 0; k < 20; ++k) {
+                    vector<atomic<int>> busy(pool.Workers() + 1);
+                    pool.ParallelFor(0, 64, 1, [&](size_t, unsigned slot) {
+                        if (busy[slot].exchange(1))
+                            ++clashes;
+                        this_thread::yield();
+                        busy[slot] = 0;
+                    });
+                    got[t] = g.BatchBFS(sources, pool);
+                }
+            });
+        for (thread& t : callers)
+            t.join();
+        assert(clashes == 0);
+        for (const BatchResult<int>& r : got)
+            assert(r.data == expect.data);
+    }
+
+    // исключение из задачи доходит до вызывающего
+    try {
+        pool.ParallelFor(0, 4, 1, [](size_t i, unsigned) {
+            if (i == 2)
+                throw runtime_error("ошибка");
+        });
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+}
+
+/// <summary>
+/// Тест сильно и слабо связных компонент
+/// </summary>
+void test_components() {
+    const double INF = 1000000000;
+    ThreadPool pool(3);
+
+    // два цикла, соединённых ребром, и изолированная вершина
+    DGraph<string, double> g(INF);
+    for (string v : { "A", "B", "C", "D", "E", "F" })
+        g.AddV(v);
+    g.AddE("A", "B", 1.0);
+    g.AddE("B", "C", 1.0);
+    g.AddE("C", "A", 1.0);
+    g.AddE("C", "D", 1.0);
+    g.AddE("D", "E", 1.0);
+    g.AddE("E", "D", 1.0);
+    auto scc = g.StronglyConnectedComponents();
+    assert(scc.Count() == 3);
+    assert(scc.id == vector<int>({ 0, 0, 0, 1, 1, 2 }));
+    assert(scc.sizes == vector<size_t>({ 3, 2, 1 }));
+    auto wcc = g.WeaklyConnectedComponents();
+    assert(wcc.id == vector<int>({ 0, 0, 0, 0, 0, 1 }));
+    assert(wcc.sizes == vector<size_t>({ 5, 1 }));
+    assert(g.StronglyConnectedComponents(pool).id == scc.id);
+    assert(g.WeaklyConnectedComponents(pool).id == wcc.id);
+
+    // случайные графы: сверка с попарной достижимостью через BFS
+    GenOptions opt;
+    opt.seed = 21;
+    const int N = 90;
+    auto edges = GenErdosRenyi(N, 0.018, true, GenWeights<double>(), opt);
+    auto r = GenBuild(N, edges, INF);
+    vector<vector<char>> reach(N, vector<char>(N, 0));
+    for (int u = 0; u < N; ++u)
+        for (int v : r.BFS(u))
+            reach[u][v] = 1;
+    auto rs = r.StronglyConnectedComponents();
+    for (int u = 0; u < N; ++u)
+        for (int v = 0; v < N; ++v)
+            assert((rs.id[u] == rs.id[v]) == (reach[u][v] && reach[v][u]));
+    assert(r.StronglyConnectedComponents(pool).id == rs.id);
+
+    auto rw = r.WeaklyConnectedComponents(pool);
+    for (int u = 0; u < N; ++u)
+        for (int v : r.GetNeighbors(u))
+            assert(rw.id[u] == rw.id[v]);
+    size_t total = 0;
+    for (size_t sz : rw.sizes)
+        total += sz;
+    assert(total == static_cast<size_t>(N));
+    assert(r.WeaklyConnectedComponents().id == rw.id);
+
+    // параллельный forward-backward с мелким порогом совпадает с Тарьяном
+    opt.seed = 22;
+    auto big = GenRMAT<double>(11, 3, 0.57, 0.19, 0.19, GenWeights<double>(), opt);
+    GenSortUnique(big);
+    const int BN = 1 << 11;
+    vector<size_t> offs(BN + 1, 0);
+    vector<int> targs;
+    for (const auto& e : big)
+        ++offs[e.from + 1];
+    for (int i = 0; i < BN; ++i)
+        offs[i + 1] += offs[i];
+    for (const auto& e : big)
+        targs.push_back(e.to);
+    auto t = SccTarjan(offs, targs);
+    auto fb = SccForwardBackward(offs, targs, pool, 8);
+    assert(fb.id == t.id && fb.sizes == t.sizes);
+}
+
+/// <summary>
+/// Тест топологической сортировки и кратчайших путей в ацикличном графе
+/// </summary>
+void test_dag_paths() {
+    const double INF = 1000000000;
+
+    DGraph<string, double> g(INF);
+    for (string v : { "A", "B", "C", "D", "E" })
+        g.AddV(v);
+    g.AddE("A", "B", 2.0);
+    g.AddE("A", "C", 4.0);
+    g.AddE("B", "C", -3.0);
+    g.AddE("C", "D", 1.0);
+    g.AddE("E", "D", 7.0);
+    assert(g.IsAcyclic());
+
+    vector<string> topo = g.TopologicalSort();
+    assert(topo == vector<string>({ "A", "E", "B", "C", "D" }));
+
+    // отрицательные веса допустимы, результат совпадает с BellmanFord
+    vector<double> d = g.DagShortestPaths("A");
+    assert(d == g.BellmanFord("A"));
+    assert(d[2] == -1.0 && d[3] == 0.0 && d[4] == INF);
+    PathMethod m;
+    assert(g.ShortestPathsAuto("A", &m) == d && m == PathMethod::Dag);
+
+    // цикл: кэш свойств сбрасывается изменением
+    g.AddE("D", "A", 10.0);
+    assert(!g.IsAcyclic());
+    try {
+        g.TopologicalSort();
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    try {
+        g.DagShortestPaths("A");
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    assert(g.ShortestPathsAuto("A", &m) == g.BellmanFord("A") && m == PathMethod::BellmanFord);
+
+    // неотрицательные веса с циклом: Дейкстра
+    g.AddE("B", "C", 3.0);
+    assert(g.ShortestPathsAuto("A", &m) == g.BellmanFord("A") && m == PathMethod::Dijkstra);
+    g.DeleteE("D", "A");
+    assert(g.IsAcyclic());
+    assert(g.ShortestPathsAuto("E", &m) == g.BellmanFord("E") && m == PathMethod::Dag);
+
+    // Дейкстра отказывается работать с отрицательными весами
+    g.AddE("C", "E", -1.0);
+    try {
+        g.Dijkstra("A");
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // случайный ацикличный граф: рёбра только от меньшего индекса к большему
+    GenOptions opt;
+    opt.seed = 35;
+    const int N = 100;
+    GenWeights<double> ws;
+    ws.minW = -5;
+    ws.maxW = 20;
+    auto edges = GenErdosRenyi(N, 0.05, false, ws, opt);
+    edges.erase(remove_if(edges.begin(), edges.end(),
+        [](const GenEdge<double>& e) { return e.from >= e.to; }), edges.end());
+    auto r = GenBuild(N, edges, INF);
+    vector<int> order = r.TopologicalSort();
+    vector<int> pos(N);
+    for (int i = 0; i < N; ++i)
+        pos[order[i]] = i;
+    for (const auto& e : edges)
+        assert(pos[e.from] < pos[e.to]);
+    for (int s = 0; s < N; s += 7)
+        assert(r.DagShortestPaths(s) == r.BellmanFord(s));
+
+    // копия графа сохраняет кэш, изменение копии не затрагивает оригинал
+    auto c = r;
+    c.AddE(edges[0].to, edges[0].from, 1.0);
+    assert(!c.IsAcyclic() && r.IsAcyclic());
+}
+
+/// <summary>
+/// Тест PageRank, персонализированного PageRank и центральности Каца
+/// </summary>
+void test_analytics() {
+    const double INF = 1000000000;
+    ThreadPool pool(3);
+
+    // цикл: все ранги равны
+    DGraph<string, double> c(INF);
+    for (string v : { "A", "B", "C", "D" })
+        c.AddV(v);
+    c.AddE("A", "B", 1.0);
+    c.AddE("B", "C", 1.0);
+    c.AddE("C", "D", 1.0);
+    c.AddE("D", "A", 1.0);
+    auto pr = c.PageRank(pool);
+    assert(pr.converged && pr.scores.size() == 4);
+    for (double x : pr.scores)
+        assert(fabs(x - 0.25) < 1e-9);
+
+    // случайный граф с висячими вершинами: сверка с простой реализацией
+    GenOptions opt;
+    opt.seed = 36;
+    const int N = 80;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 9;
+    auto edges = GenErdosRenyi(N, 0.05, false, ws, opt);
+    auto g = GenBuild(N, edges, INF);
+    vector<int> outdeg(N, 0);
+    for (const auto& e : edges)
+        ++outdeg[e.from];
+
+    const double d = 0.85;
+    vector<double> x(N, 1.0 / N);
+    for (int it = 0; it < 200; ++it) {
+        double lost = 0;
+        for (int u = 0; u < N; ++u)
+            if (outdeg[u] == 0)
+                lost += x[u];
+        vector<double> nx(N, (1 - d + d * lost) / N);
+        for (const auto& e : edges)
+            nx[e.to] += d * x[e.from] / outdeg[e.from];
+        x = nx;
+    }
+    AnalyticsOptions ao;
+    ao.tolerance = 1e-12;
+    ao.maxIterations = 500;
+    auto r = g.PageRank(pool, ao);
+    assert(r.converged && r.iterations > 1 && r.edges == edges.size());
+    double total = 0;
+    for (int v = 0; v < N; ++v) {
+        assert(fabs(r.scores[v] - x[v]) < 1e-9);
+        total += r.scores[v];
+    }
+    assert(fabs(total - 1.0) < 1e-9);
+
+    // результат не зависит от числа потоков
+    ThreadPool one(1);
+    auto r1 = g.PageRank(one, ao);
+    for (int v = 0; v < N; ++v)
+        assert(fabs(r1.scores[v] - r.scores[v]) < 1e-12);
+
+    // персонализированный PageRank сосредоточен вокруг источника
+    auto ppr = g.PersonalizedPageRank({ 0 }, pool, ao);
+    assert(ppr.converged);
+    for (int v = 1; v < N; ++v)
+        assert(ppr.scores[0] >= ppr.scores[v]);
+    try {
+        g.PersonalizedPageRank({ N }, pool);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // взвешенное произведение A^T x
+    auto eng = g.Analytics(pool, true);
+    vector<double> in(N), out, expect(N, 0.0);
+    for (int v = 0; v < N; ++v)
+        in[v] = v + 1;
+    for (const auto& e : edges)
+        expect[e.to] += e.weight * in[e.from];
+    eng.Multiply(in, out);
+    for (int v = 0; v < N; ++v)
+        assert(fabs(out[v] - expect[v]) < 1e-9);
+
+    // Кац на цепочке A->B->C: 1, 1 + a, 1 + a + a^2
+    DGraph<string, double> p(INF);
+    p.AddV("A");
+    p.AddV("B");
+    p.AddV("C");
+    p.AddE("A", "B", 1.0);
+    p.AddE("B", "C", 1.0);
+    auto k = p.KatzCentrality(0.5, pool);
+    assert(k.converged);
+    assert(fabs(k.scores[0] - 1.0) < 1e-9 && fabs(k.scores[1] - 1.5) < 1e-9 && fabs(k.scores[2] - 1.75) < 1e-9);
+    // на цикле alpha = 2 расходится
+    assert(!c.KatzCentrality(2.0, pool).converged);
+}
+
+/// <summary>
+/// Проверка перенумерации: рёбра и веса сохраняются, расстояния переставляются по to
+/// </summary>
+template <typename G>
+static void check_reorder(const G& before, ReorderStrategy strategy) {
+    G g = before;
+    vector<int> to = g.Reorder(strategy);
+    int n = g.Size();
+    assert(static_cast<int>(to.size()) == n);
+    vector<char> used(n, 0);
+    for (int t : to) {
+        assert(t >= 0 && t < n && !used[t]);
+        used[t] = 1;
+    }
+    for (int u = 0; u < n; ++u) {
+        assert(g.HasVert(u));
+        for (int v = 0; v < n; ++v) {
+            assert(g.HasEdge(u, v) == before.HasEdge(u, v));
+            if (g.HasEdge(u, v))
+                assert(g.GetWeight(u, v) == before.GetWeight(u, v));
+        }
+    }
+    for (int s = 0; s < n; s += 9) {
+        vector<double> a = before.BellmanFord(s), b = g.BellmanFord(s);
+        for (int v = 0; v < n; ++v)
+            assert(b[to[v]] == a[v]);
+        vector<int> x = before.BFS(s), y = g.BFS(s);
+        sort(x.begin(), x.end());
+        sort(y.begin(), y.end());
+        assert(x == y);
+    }
+}
+
+/// <summary>
+/// Тест перенумерации вершин
+/// </summary>
+void test_reorder() {
+    const double INF = 1000000000;
+
+    // сетка с перемешанными номерами вершин
+    const int R = 8, C = 9, N = R * C;
+    GenOptions opt;
+    opt.seed = 37;
+    auto edges = GenGrid(R, C, true, GenWeights<double>(), opt);
+    vector<int> label(N);
+    for (int i = 0; i < N; ++i)
+        label[i] = i;
+    mt19937 rng(37);
+    shuffle(label.begin(), label.end(), rng);
+    DGraph<int, double> g(INF);
+    DGraph<int, double, allocator<char>, AdjacencyList> l(INF);
+    DGraph<int, double, allocator<char>, DenseBitmap> b(INF);
+    for (int i = 0; i < N; ++i) {
+        g.AddV(i);
+        l.AddV(i);
+        b.AddV(i);
+    }
+    for (const auto& e : edges) {
+        g.AddE(label[e.from], label[e.to], e.weight);
+        l.AddE(label[e.from], label[e.to], e.weight);
+        b.AddE(label[e.from], label[e.to], e.weight);
+    }
+
+    for (ReorderStrategy st : { ReorderStrategy::ReverseCuthillMcKee, ReorderStrategy::DegreeDescending,
+        ReorderStrategy::BfsOrder }) {
+        check_reorder(g, st);
+        check_reorder(l, st);
+        check_reorder(b, st);
+    }
+
+    // ширина ленты (наибольшая разность индексов концов ребра) у RCM много меньше, чем у случайного порядка;
+    // индекс вершины x до перенумерации равен x
+    auto bandwidth = [&](const vector<int>& to) {
+        int w = 0;
+        for (const auto& e : edges)
+            w = max(w, abs(to[label[e.from]] - to[label[e.to]]));
+        return w;
+    };
+    vector<int> identity(N);
+    for (int i = 0; i < N; ++i)
+        identity[i] = i;
+    auto r = g;
+    int rcm = bandwidth(r.Reorder(ReorderStrategy::ReverseCuthillMcKee));
+    assert(rcm <= 2 * min(R, C) && rcm < bandwidth(identity));
+
+    // по убыванию степени: внутренние вершины сетки впереди
+    auto d = g;
+    vector<int> byDegree = d.Reorder(ReorderStrategy::DegreeDescending);
+    for (int x = 0; x < N; ++x)
+        if (byDegree[x] == 0)
+            assert(g.GetNeighbors(x).size() == 4);
+}
+
+/// <summary>
+/// Тест графа во внешней памяти
+/// </summary>
+void test_disk_graph() {
+    const double INF = 1000000000;
+    const string path = "test_edges.tgre";
+
+    GenOptions opt;
+    opt.seed = 38;
+    const int N = 300;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 50;
+    auto edges = GenErdosRenyi(N, 0.01, false, ws, opt);
+    auto g = GenBuild(N, edges, INF);
+    g.SaveEdgeFile(path);
+
+    {
+        // кэш из 4 страниц по 256 байт - много меньше файла
+        DiskGraph<double> d(path, 1024, 256);
+        assert(d.Size() == N && d.EdgeCount() == edges.size());
+        assert(d.Cache().CapacityBytes() == 1024 && d.Cache().FileBytes() > 8 * 1024);
+
+        // произвольный доступ к строке
+        for (int u = 0; u < N; u += 17) {
+            vector<int> nb;
+            d.ForEachOut(u, [&](int v, double w) {
+                assert(w == g.GetWeight(u, v));
+                nb.push_back(v);
+            });
+            size_t cnt = 0;
+            for (int v = 0; v < N; ++v)
+                cnt += g.HasEdge(u, v);
+            assert(nb.size() == cnt && is_sorted(nb.begin(), nb.end()));
+        }
+
+        // полувнешние алгоритмы совпадают с DGraph
+        ThreadPool pool(1);
+        for (int s = 0; s < N; s += 37) {
+            vector<int> hops = d.BFS(s);
+            auto ref = g.BatchBFS(vector<int>({ s }), pool);
+            assert(equal(hops.begin(), hops.end(), ref.Row(0)));
+            assert(d.BellmanFord(s, INF) == g.BellmanFord(s));
+            assert(d.LastPasses() >= 1);
+        }
+        assert(d.Cache().ResidentBytes() <= d.Cache().CapacityBytes());
+        assert(d.Cache().Misses() > 0 && d.Cache().BytesRead() > d.Cache().FileBytes());
+
+        try {
+            d.BFS(N);
+            assert(false);
+        }
+        catch (const runtime_error&) {
+
+        }
+    }
+
+    // отрицательный цикл
+    {
+        EdgeFileWriter<double> w(path, 3);
+        w.Add(0, 1, 1.0);
+        w.Add(1, 2, -3.0);
+        w.Add(2, 0, 1.0);
+        // источник меньше предыдущего
+        try {
+            w.Add(1, 0, 1.0);
+            assert(false);
+        }
+        catch (const runtime_error&) {
+
+        }
+        w.Close();
+        DiskGraph<double> d(path);
+        try {
+            d.BellmanFord(0, INF);
+            assert(false);
+        }
+        catch (const runtime_error&) {
+
+        }
+        assert(d.BFS(0) == vector<int>({ 0, 1, 2 }));
+    }
+
+    // чужой формат не открывается
+    try {
+        DiskGraph<float> d(path);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    remove(path.c_str());
+}
+
+/// <summary>
+/// Тест сжатого графа
+/// </summary>
+void test_compressed() {
+    const double INF = 1000000000;
+
+    GenOptions opt;
+    opt.seed = 39;
+    const int N = 200;
+    GenWeights<double> ws;
+    ws.minW = -10;
+    ws.maxW = 30;
+    auto edges = GenErdosRenyi(N, 0.03, true, ws, opt);
+    auto g = GenBuild(N, edges, INF);
+
+    CompressOptions exact;
+    auto c = g.Compress(exact);
+    assert(c.Size() == N && c.EdgeCount() == edges.size());
+    for (int u = 0; u < N; ++u) {
+        for (int v = 0; v < N; ++v) {
+            assert(c.HasEdge(u, v) == g.HasEdge(u, v));
+            if (g.HasEdge(u, v))
+                assert(c.GetWeight(u, v) == g.GetWeight(u, v));
+        }
+        assert(c.GetNeighbors(u) == g.GetNeighbors(u));
+    }
+    for (int s = 0; s < N; s += 11) {
+        assert(c.BFS(s) == g.BFS(s));
+        assert(c.DFS(s) == g.DFS(s));
+    }
+    try {
+        c.BFS(N);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // без входящих рёбер GetNeighbors медленнее, но даёт тот же результат
+    CompressOptions small;
+    small.reverse = false;
+    small.weights = WeightMode::Quantized;
+    auto q = g.Compress(small);
+    assert(q.MemoryBytes() < c.MemoryBytes());
+    for (int u = 0; u < N; u += 7)
+        assert(q.GetNeighbors(u) == g.GetNeighbors(u));
+    // квантованные веса приближённые
+    for (const auto& e : edges)
+        assert(fabs(q.GetWeight(e.from, e.to) - g.GetWeight(e.from, e.to)) <= 40.0 / 65535);
+
+    CompressOptions none;
+    none.weights = WeightMode::Dropped;
+    auto d = g.Compress(none);
+    assert(d.Weights() == WeightMode::Dropped && d.BFS(0) == g.BFS(0));
+    try {
+        d.GetWeight(edges[0].from, edges[0].to);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // разреженный граф после перенумерации: меньше 2 байт на ребро без весов
+    auto grid = GenGrid(40, 40, true, GenWeights<int>(), opt);
+    DGraph<int, int, allocator<char>, AdjacencyList> l(0);
+    for (int i = 0; i < 1600; ++i)
+        l.AddV(i);
+    for (const auto& e : grid)
+        l.AddE(e.from, e.to, e.weight);
+    CompressOptions targetsOnly;
+    targetsOnly.weights = WeightMode::Dropped;
+    targetsOnly.reverse = false;
+    auto cg = l.Compress(targetsOnly);
+    assert(cg.BytesPerEdge() < 4.0);
+    assert(cg.BFS(0) == l.BFS(0) && cg.GetNeighbors(41) == l.GetNeighbors(41));
+
+    // невзвешенный граф
+    DGraph<string, Unweighted, allocator<char>, DenseBitmap> u(Unweighted{});
+    u.AddV("A");
+    u.AddV("B");
+    u.AddE("B", "A", Unweighted{});
+    auto cu = u.Compress();
+    assert(cu.HasEdge("B", "A") && !cu.HasEdge("A", "B") && cu.Weights() == WeightMode::Dropped);
+}
+
+void test_journal() {
+    const double INF = 1000000000;
+    const string base = "test_journal";
+    auto cleanup = [&]() {
+        for (const auto& entry : filesystem::directory_iterator("."))
+            if (entry.path().filename().string().rfind(base, 0) == 0)
+                filesystem::remove(entry.path());
+    };
+    auto same = [](const DGraph<string, double>& a, const DGraph<string, double>& b) {
+        if (a.Size() != b.Size())
+            return false;
+        for (int i = 0; i < a.Size(); ++i) {
+            const string& v = a.VertexAt(i);
+            if (!b.HasVert(v))
+                return false;
+            for (int k = 0; k < a.Size(); ++k) {
+                const string& w = a.VertexAt(k);
+                if (a.HasEdge(v, w) != b.HasEdge(v, w) || (a.HasEdge(v, w) && a.GetEdge(v, w) != b.GetEdge(v, w)))
+                    return false;
+            }
+        }
+        return true;
+    };
+    cleanup();
+
+    DGraph<string, double> g(INF);
+    {
+        GraphJournal<string, double> j(base);
+        j.Recover(g);
+        assert(g.Size() == 0);
+        for (int i = 0; i < 20; ++i)
+            g.AddV("v" + to_string(i));
+        for (int i = 0; i < 20; ++i)
+            g.AddE("v" + to_string(i), "v" + to_string((i * 7 + 3) % 20), i + 0.5);
+        g.DeleteE("v1", "v10");
+        g.DeleteV("v5");
+        g.AddE("v0", "v1", 2.25); // перезапись веса
+
+        // ошибочные изменения в журнал не попадают
+        uint64_t before = j.Records();
+        try {
+            g.AddE("v0", "нет", 1);
+            assert(false);
+        }
+        catch (const runtime_error&) {
+
+        }
+        assert(j.Records() == before && before == 20 + 20 + 3);
+
+        // копия графа не пишет в журнал
+        DGraph<string, double> copy = g;
+        copy.AddV("x");
+        assert(j.Records() == before);
+
+        j.Sync();
+        assert(j.Syncs() >= 1 && j.BytesWritten() > 0);
+    }
+
+    // восстановление только по журналу
+    DGraph<string, double> r(INF);
+    {
+        GraphJournal<string, double> j(base);
+        j.Recover(r);
+        assert(same(g, r));
+        assert(r.IndexOf("v5") < 0 && r.GetEdge("v0", "v1") == 2.25);
+
+        // уплотнение: снимок, новый журнал, дальнейшие изменения идут в него
+        j.Compact(r);
+        r.AddV("new");
+        r.AddE("new", "v0", 7);
+        j.WaitCompaction();
+        assert(j.Generation() == 1);
+        assert(filesystem::exists(base + ".snap.1") && !filesystem::exists(base + ".log.0"));
+    }
+
+    // снимок + журнал; оборванная последняя запись отбрасывается
+    {
+        ofstream torn(base + ".log.1", ios::binary | ios::app);
+        torn.write("\x10\x00\x00\x00garbage", 11);
+    }
+    size_t tornSize = static_cast<size_t>(filesystem::file_size(base + ".log.1"));
+    DGraph<string, double> r2(INF);
+    {
+        GraphJournal<string, double> j(base);
+        j.Recover(r2);
+        assert(same(r, r2) && r2.GetEdge("new", "v0") == 7);
+        assert(filesystem::file_size(base + ".log.1") == tornSize - 11);
+
+        // Clear тоже журналируется
+        r2.Clear();
+        r2.AddV("only");
+    }
+    DGraph<string, double> r3(INF);
+    {
+        GraphJournal<string, double> j(base);
+        j.Recover(r3);
+        assert(r3.Size() == 1 && r3.HasVert("only"));
+    }
+
+    // целочисленный граф, запись каждой операции
+    {
+        JournalOptions opt;
+        opt.syncEachRecord = true;
+        DGraph<int, int, allocator<char>, AdjacencyList> a(0);
+        {
+            GraphJournal<int, int> j(base + "_int", opt);
+            j.Recover(a);
+            a.AddV(1);
+            a.AddV(2);
+            a.AddE(1, 2, -4);
+            assert(j.Syncs() == 3);
+        }
+        DGraph<int, int, allocator<char>, AdjacencyList> b(0);
+        GraphJournal<int, int> j(base + "_int", opt);
+        j.Recover(b);
+        assert(b.Size() == 2 && b.GetEdge(1, 2) == -4);
+    }
+
+    // ошибка записи (журнал на /dev/full) не теряется: Sync выбрасывает её каждый раз,
+    // следующие изменения отклоняются до применения к графу
+    if (filesystem::exists("/dev/full")) {
+        DGraph<int, int, allocator<char>, AdjacencyList> f(0);
+        GraphJournal<int, int> j(base + "_full");
+        j.Recover(f);
+        f.AddV(1);
+        filesystem::create_symlink("/dev/full", base + "_full.log.1");
+        j.Compact(f);
+        j.WaitCompaction();
+        f.AddV(2);
+        for (int k = 0; k < 2; ++k) {
+            bool thrown = false;
+            try {
+                j.Sync();
+            }
+            catch (const runtime_error&) {
+                thrown = true;
+            }
+            assert(thrown);
+        }
+        bool rejected = false;
+        try {
+            f.AddV(3);
+        }
+        catch (const runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected && f.HasVert(2) && !f.HasVert(3));
+
+        // снимок, не дошедший до диска, не заменяет прежние снимок и журнал
+        DGraph<int, int, allocator<char>, AdjacencyList> s(0);
+        {
+            GraphJournal<int, int> js(base + "_snap");
+            js.Recover(s);
+            s.AddV(1);
+            s.AddV(2);
+            filesystem::create_symlink("/dev/full", base + "_snap.snap.1.tmp");
+            js.Compact(s);
+            js.WaitCompaction();
+            assert(!filesystem::exists(base + "_snap.snap.1") && filesystem::exists(base + "_snap.log.0"));
+            s.AddE(1, 2, 5);
+        }
+        DGraph<int, int, allocator<char>, AdjacencyList> s2(0);
+        GraphJournal<int, int> js(base + "_snap");
+        js.Recover(s2);
+        assert(s2.Size() == 2 && s2.GetEdge(1, 2) == 5);
+    }
+
+    // новый журнал при уплотнении не открылся: изменения не теряются молча
+    {
+        DGraph<int, int, allocator<char>, AdjacencyList> o(0);
+        GraphJournal<int, int> j(base + "_open");
+        j.Recover(o);
+        o.AddV(1);
+        filesystem::create_directory(base + "_open.log.1");
+        bool thrown = false;
+        try {
+            j.Compact(o);
+        }
+        catch (const runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+        thrown = false;
+        try {
+            o.AddV(2);
+        }
+        catch (const runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown && !o.HasVert(2));
+        thrown = false;
+        try {
+            j.Sync();
+        }
+        catch (const runtime_error&) {
+            thrown = true;
+        }
+        assert(thrown);
+    }
+    cleanup();
+}
+
+/// <summary>
+/// Пакет против последовательных AddV/AddE/DeleteE/DeleteV для политики хранения S
+/// </summary>
+template <typename S>
+static void check_batch(ThreadPool* pool) {
+    const double INF = 1000000000;
+    const int N = 200, NEW = 20;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 9;
+    GenOptions opt;
+    opt.seed = 41;
+    auto edges = GenErdosRenyi(N, 0.03, false, ws, opt);
+    DGraph<int, double, allocator<char>, S> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    auto ref = g;
+
+    mt19937 rng(41);
+    MutationBatch<int, double> batch;
+    vector<int> doomed = { 3, 77, 150, N + 5, 77 };
+    for (int d : doomed)
+        batch.DeleteV(d); // удаляются после всех остальных операций пакета
+    for (int i = 0; i < NEW; ++i) {
+        batch.AddV(N + i);
+        ref.AddV(N + i);
+    }
+    vector<pair<int, int>> seen;
+    for (int k = 0; k < 3000; ++k) {
+        pair<int, int> e(rng() % (N + NEW), rng() % (N + NEW));
+        if (!seen.empty() && rng() % 4 == 0)
+            e = seen[rng() % seen.size()]; // повторы одного ребра
+        seen.push_back(e);
+        if (rng() % 3 == 0) {
+            batch.DeleteE(e.first, e.second);
+            ref.DeleteE(e.first, e.second);
+        }
+        else {
+            double w = 1 + rng() % 100;
+            batch.AddE(e.first, e.second, w);
+            ref.AddE(e.first, e.second, w);
+        }
+    }
+    // существующие рёбра, часть из которых удаляется
+    for (size_t i = 0; i < edges.size(); i += 5) {
+        batch.DeleteE(edges[i].from, edges[i].to);
+        ref.DeleteE(edges[i].from, edges[i].to);
+    }
+    ref.DeleteV(3);
+    ref.DeleteV(77);
+    ref.DeleteV(150);
+    ref.DeleteV(N + 5);
+
+    g.Apply(batch, pool);
+    assert(g.Size() == ref.Size() && g.Size() == N + NEW - 4);
+    for (int i = 0; i < g.Size(); ++i) {
+        int u = g.VertexAt(i);
+        assert(u == ref.VertexAt(i) && g.IndexOf(u) == i);
+        for (int k = 0; k < g.Size(); ++k) {
+            int v = g.VertexAt(k);
+            assert(g.HasEdge(u, v) == ref.HasEdge(u, v));
+            if (ref.HasEdge(u, v))
+                assert(g.GetWeight(u, v) == ref.GetWeight(u, v));
+        }
+    }
+    assert(g.BFS(0) == ref.BFS(0) && g.BellmanFord(1) == ref.BellmanFord(1));
+}
+
+void test_mutation_batch() {
+    ThreadPool pool(4);
+    check_batch<DenseSentinel>(nullptr);
+    check_batch<DenseSentinel>(&pool);
+    check_batch<DenseBitmap>(&pool);
+    check_batch<AdjacencyList>(nullptr);
+    check_batch<AdjacencyList>(&pool);
+
+    // ошибочный пакет не меняет граф
+    DGraph<string, int, allocator<char>, AdjacencyList> g(0);
+    g.AddV("A");
+    g.AddV("B");
+    g.AddE("A", "B", 1);
+    MutationBatch<string, int> bad;
+    bad.AddV("C");
+    bad.AddE("A", "C", 2);
+    bad.AddE("B", "D", 3);
+    try {
+        g.Apply(bad);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    assert(g.Size() == 2 && !g.HasVert("C"));
+
+    bad.Clear();
+    assert(bad.Empty());
+    bad.AddV("A");
+    try {
+        g.Apply(bad);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // добавление и удаление вершины в одном пакете, пустой пакет; кэш свойств сбрасывается
+    assert(g.IsAcyclic());
+    MutationBatch<string, int> ok;
+    ok.AddV("C");
+    ok.AddE("C", "A", 5);
+    ok.AddE("B", "A", 4);
+    ok.DeleteV("C");
+    g.Apply(ok);
+    g.Apply(MutationBatch<string, int>());
+    assert(g.Size() == 2 && !g.HasVert("C") && g.GetEdge("B", "A") == 4 && g.GetEdge("A", "B") == 1);
+    assert(!g.IsAcyclic());
+}
+
+void test_workspace() {
+    const double INF = 1000000000;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 20;
+    GenOptions opt;
+    opt.seed = 42;
+    const int N = 150;
+    auto edges = GenErdosRenyi(N, 0.02, true, ws, opt);
+    DGraph<int, double> g(INF);
+    DGraph<int, double, allocator<char>, AdjacencyList> l(INF);
+    for (int i = 0; i < N; ++i) {
+        g.AddV(i);
+        l.AddV(i);
+    }
+    for (const auto& e : edges) {
+        g.AddE(e.from, e.to, e.weight);
+        l.AddE(e.from, e.to, e.weight);
+    }
+
+    // одна рабочая область на много запросов к двум графам
+    TraversalWorkspace<double> w;
+    vector<int> out;
+    for (int s = 0; s < N; s += 3) {
+        g.BFS(s, w, out);
+        assert(out == g.BFS(s));
+        l.DFS(s, w, out);
+        assert(out == l.DFS(s));
+
+        vector<double> ref = g.BellmanFord(s);
+        l.BellmanFord(s, w);
+        for (int v = 0; v < N; ++v) {
+            assert(w.Reached(v) == (ref[v] != INF));
+            if (w.Reached(v))
+                assert(fabs(w.Dist(v) - ref[v]) < 1e-9);
+        }
+        assert(w.Order()[0] == s);
+    }
+
+    // после первого запроса память не растёт
+    size_t bytes = w.MemoryBytes();
+    for (int s = 0; s < N; ++s)
+        g.BFS(s, w);
+    assert(w.MemoryBytes() == bytes && w.Capacity() == static_cast<size_t>(N));
+
+    // меньший граф после большего, отрицательные веса и отрицательный цикл
+    DGraph<string, int, allocator<char>, AdjacencyList> small(0);
+    TraversalWorkspace<int> wi;
+    for (string v : { "A", "B", "C", "D" })
+        small.AddV(v);
+    small.AddE("A", "B", 4);
+    small.AddE("A", "C", 1);
+    small.AddE("C", "B", -2);
+    small.AddE("B", "D", 1);
+    small.BellmanFord("A", wi);
+    assert(wi.Dist(small.IndexOf("B")) == -1 && wi.Dist(small.IndexOf("D")) == 0);
+    small.BFS("C", wi);
+    assert(wi.Order().size() == 3 && !wi.Reached(small.IndexOf("A")));
+    small.AddE("D", "C", -1);
+    try {
+        small.BellmanFord("A", wi);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    try {
+        small.BFS("Z", wi);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+}
+
+void test_reachability() {
+    const double INF = 1000000000;
+    GenOptions opt;
+    opt.seed = 43;
+    const int N = 400;
+    // разреженный граф: много мелких SCC и длинные цепочки достижимости
+    auto edges = GenErdosRenyi(N, 1.2 / N, false, GenWeights<double>(), opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+
+    vector<size_t> offs;
+    vector<int> targs;
+    offs.assign(N + 1, 0);
+    for (int u = 0; u < N; ++u)
+        g.ForEachOut(u, [&](int v, double) { targs.push_back(v); ++offs[u + 1]; });
+    for (int u = 0; u < N; ++u)
+        offs[u + 1] += offs[u];
+
+    ThreadPool pool(4);
+    ReachOptions labelsOnly;
+    labelsOnly.maxBitsetBytes = 0;
+    ReachabilityIndex<int> closure(offs, targs);
+    ReachabilityIndex<int> closureP(offs, targs, &pool);
+    ReachabilityIndex<int> labels(offs, targs, nullptr, labelsOnly);
+    ReachabilityIndex<int> labelsP(offs, targs, &pool, labelsOnly);
+    assert(closure.UsesClosure() && !labels.UsesClosure());
+    assert(closure.Components() == g.StronglyConnectedComponents().Count());
+    assert(labels.MemoryBytes() < closure.MemoryBytes());
+
+    for (int s = 0; s < N; s += 7) {
+        vector<char> reached(N, 0);
+        for (int v : g.BFS(s))
+            reached[v] = 1;
+        for (int v = 0; v < N; ++v) {
+            bool r = reached[v] != 0;
+            assert(closure.CanReach(s, v) == r && closureP.CanReach(s, v) == r);
+            assert(labels.CanReach(s, v) == r && labelsP.CanReach(s, v) == r);
+            assert(g.CanReach(s, v) == r);
+        }
+    }
+
+    // индекс сохраняется при изменениях, не меняющих достижимость
+    auto idx = g.Reachability();
+    int a = -1, b = -1;
+    for (int v = 1; v < N && a < 0; ++v)
+        if (g.CanReach(0, v) && !g.HasEdge(0, v)) {
+            a = 0;
+            b = v;
+        }
+    assert(a == 0);
+    g.AddE(a, b, 1);
+    g.AddV(N);
+    assert(g.Reachability() == idx && !g.CanReach(0, N) && g.CanReach(N, N));
+
+    // новое ребро расширяет достижимость: индекс перестраивается
+    g.AddE(b, N, 1);
+    assert(g.Reachability() != idx && g.CanReach(0, N));
+    idx = g.Reachability();
+    g.DeleteE(b, N);
+    assert(g.Reachability() != idx && !g.CanReach(0, N));
+
+    // плотное хранилище, цикл
+    DGraph<string, int> d(0);
+    for (string v : { "A", "B", "C", "D" })
+        d.AddV(v);
+    d.AddE("A", "B", 1);
+    d.AddE("B", "C", 1);
+    d.AddE("C", "A", 1);
+    assert(d.CanReach("C", "B") && !d.CanReach("A", "D") && d.Reachability()->Components() == 2);
+    try {
+        d.CanReach("A", "Z");
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+}
+
+void test_astar() {
+    const double INF = 1000000000;
+    GenOptions opt;
+    opt.seed = 44;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 10;
+    const int R = 20, C = 20, N = R * C;
+    auto edges = GenGrid(R, C, true, ws, opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    // односторонний тупик: вершина N достижима, но из неё нет пути
+    g.AddV(N);
+    g.AddE(0, N, 1);
+
+    ThreadPool pool(4);
+    auto avoid = g.Landmarks(8, LandmarkSelection::Avoid, &pool);
+    auto far = g.Landmarks(8, LandmarkSelection::Farthest);
+    auto rnd = g.Landmarks(4, LandmarkSelection::Random, &pool, 7);
+    assert(avoid.Landmarks().size() == 8 && avoid.MemoryBytes() >= 2 * 8 * (N + 1) * sizeof(double));
+
+    size_t plain = 0, alt = 0;
+    mt19937 rng(44);
+    for (int q = 0; q < 60; ++q) {
+        int s = rng() % N, t = rng() % N;
+        vector<double> ref = g.Dijkstra(s);
+        AStarStats a, b;
+        vector<int> path;
+        double d = g.AStar(s, t, avoid, &a, &path);
+        assert(fabs(d - ref[t]) < 1e-9);
+        assert(fabs(g.AStar(s, t, far) - ref[t]) < 1e-9 && fabs(g.AStar(s, t, rnd) - ref[t]) < 1e-9);
+        assert(fabs(g.AStar(s, t, &b) - ref[t]) < 1e-9);
+
+        // путь: существующие рёбра, сумма весов равна расстоянию
+        assert(path.front() == s && path.back() == t);
+        double len = 0;
+        for (size_t i = 0; i + 1 < path.size(); ++i)
+            len += g.GetEdge(path[i], path[i + 1]);
+        assert(fabs(len - d) < 1e-9);
+        plain += b.settled;
+        alt += a.settled;
+    }
+    assert(alt < plain);
+
+    // недостижимая цель отсекается оценкой
+    AStarStats st;
+    vector<int> path;
+    assert(g.AStar(N, 5, avoid, &st, &path) == INF && path.empty());
+    assert(g.AStar(1, N, avoid) == g.Dijkstra(1)[N]);
+    assert(g.AStar(0, N, avoid, &st) == 1);
+
+    // ориентиры от другого графа, отрицательные веса
+    g.AddV(N + 1);
+    try {
+        g.AStar(0, 1, avoid);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    g.AddE(N + 1, 0, -1);
+    try {
+        g.Landmarks(2);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+}
+
+void test_ch() {
+    const double INF = 1000000000;
+    const string file = "test_ch.bin";
+    GenOptions opt;
+    opt.seed = 45;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 10;
+    ThreadPool pool(4);
+
+    // сетка и случайный граф (с недостижимыми парами и параллельными рёбрами)
+    const int R = 15, C = 15, N = R * C;
+    auto grid = GenGrid(R, C, true, ws, opt);
+    auto sparse = GenErdosRenyi(120, 0.02, true, ws, opt);
+    vector<pair<int, vector<GenEdge<double>>>> cases = { { N, grid }, { 120, sparse } };
+    for (auto& c : cases) {
+        DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+        for (int i = 0; i < c.first; ++i)
+            g.AddV(i);
+        for (const auto& e : c.second)
+            g.AddE(e.from, e.to, e.weight);
+        auto seq = g.Contract();
+        auto par = g.Contract(&pool);
+        assert(seq.Size() == static_cast<size_t>(c.first) && seq.ArcCount() >= seq.ShortcutCount());
+
+        mt19937 rng(45);
+        for (int s = 0; s < c.first; s += 7) {
+            vector<double> ref = g.Dijkstra(s);
+            for (int q = 0; q < 20; ++q) {
+                int t = rng() % c.first;
+                vector<int> path;
+                double d = g.ShortestPath(s, t, par, &path);
+                assert(fabs(d - ref[t]) < 1e-9 && fabs(g.ShortestPath(s, t, seq) - ref[t]) < 1e-9);
+                if (ref[t] == INF) {
+                    assert(path.empty());
+                    continue;
+                }
+                // путь раскрыт до исходных рёбер
+                assert(path.front() == s && path.back() == t);
+                double len = 0;
+                for (size_t i = 0; i + 1 < path.size(); ++i)
+                    len += g.GetEdge(path[i], path[i + 1]);
+                assert(fabs(len - d) < 1e-9);
+            }
+        }
+
+        // сохранение и загрузка
+        par.Save(file);
+        auto loaded = ContractionHierarchy<double, int>::Load(file);
+        assert(loaded.Size() == par.Size() && loaded.ArcCount() == par.ArcCount());
+        for (int q = 0; q < 50; ++q) {
+            int s = rng() % c.first, t = rng() % c.first;
+            vector<int> a, b;
+            assert(g.ShortestPath(s, t, loaded, &a) == g.ShortestPath(s, t, par, &b) && a == b);
+        }
+    }
+
+    // повреждённый файл и файл для других типов
+    {
+        ofstream f(file, ios::binary | ios::trunc);
+        f << "TGRC";
+    }
+    try {
+        ContractionHierarchy<double, int>::Load(file);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    DGraph<int, float> small(1000);
+    small.AddV(0);
+    small.AddV(1);
+    small.AddE(0, 1, 2);
+    small.Contract().Save(file);
+    try {
+        ContractionHierarchy<double, int>::Load(file);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+
+    // рёбра пишутся без байтов выравнивания: заголовок 40, INF, ранги, смещения, рёбра по 16 байт
+    DGraph<int, double> two(1000);
+    two.AddV(0);
+    two.AddV(1);
+    two.AddE(0, 1, 2);
+    two.AddE(1, 0, 3);
+    two.Contract().Save(file);
+    assert(filesystem::file_size(file) == 40 + 8 + 2 * 4 + 2 * 3 * sizeof(size_t) + 2 * 16);
+    string image;
+    {
+        ifstream in(file, ios::binary);
+        image.assign(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+    }
+    // огромное число вершин в заголовке, ребро к несуществующей вершине, ранги не перестановка
+    auto corrupt = [&](size_t at, uint64_t value, size_t bytes) {
+        string bad = image;
+        memcpy(&bad[at], &value, bytes);
+        {
+            ofstream out(file, ios::binary | ios::trunc);
+            out.write(bad.data(), bad.size());
+        }
+        try {
+            ContractionHierarchy<double, int>::Load(file);
+            return false;
+        }
+        catch (const runtime_error&) {
+            return true;
+        }
+    };
+    assert(corrupt(16, uint64_t(1) << 60, 8));
+    assert(corrupt(40 + 8 + 8 + 3 * sizeof(size_t), 7, 4));
+    assert(corrupt(40 + 8, 1, 4));
+    assert(!corrupt(0, 0x43524754, 4));
+    filesystem::remove(file);
+
+    // иерархия от другого графа, отрицательные веса
+    auto ch = small.Contract();
+    assert(small.ShortestPath(0, 1, ch) == 2 && small.ShortestPath(1, 0, ch) == 1000);
+    small.AddV(2);
+    try {
+        small.ShortestPath(0, 1, ch);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    small.AddE(2, 0, -1);
+    try {
+        small.Contract();
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+}
+
+void test_async_queries() {
+    const double INF = 1000000000;
+    GenOptions opt;
+    opt.seed = 46;
+    auto edges = GenErdosRenyi(300, 0.02, false, GenWeights<double>(), opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+    for (int i = 0; i < 300; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    ThreadPool pool(2);
+
+    // полный ответ совпадает с блокирующими вызовами
+    auto bfs = g.BFSAsync(0, pool);
+    auto bf = g.BellmanFordAsync(0, pool);
+    auto order = bfs.get();
+    auto dist = bf.get();
+    assert(order.Complete() && order.value == g.BFS(0));
+    assert(dist.Complete() && dist.value == g.BellmanFord(0));
+
+    // любой исполнитель с Submit, в том числе выполняющий задачу сразу
+    struct Inline {
+        void Submit(function<void()> f) {
+            f();
+        }
+    } inl;
+    assert(g.BFSAsync(5, inl).get().value == g.BFS(5));
+
+    // ошибки: нет вершины - исключение из get(), отрицательный цикл - Failed
+    auto missing = g.BellmanFordAsync(1000, pool);
+    try {
+        missing.get();
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    DGraph<int, double> neg(INF);
+    neg.AddV(0);
+    neg.AddV(1);
+    neg.AddE(0, 1, 1);
+    neg.AddE(1, 0, -2);
+    assert(neg.BellmanFordAsync(0, pool).get().status == QueryStatus::Failed);
+
+    // отмена до начала
+    atomic<bool> cancel(true);
+    QueryControl stop;
+    stop.cancel = &cancel;
+    auto none = g.BFSAsync(0, pool, stop).get();
+    assert(none.status == QueryStatus::Cancelled && none.value.empty());
+
+    // долгий запрос на плотном хранилище: цепочка, обратная порядку индексов,
+    // требует V проходов по O(V ^ 2)
+    const int N = 1500;
+    DGraph<int, double> chain(INF);
+    for (int i = 0; i < N; ++i)
+        chain.AddV(i);
+    for (int i = 0; i + 1 < N; ++i)
+        chain.AddE(i + 1, i, 1);
+
+    QueryControl late;
+    late.Within(chrono::milliseconds(20));
+    auto t0 = chrono::steady_clock::now();
+    auto timed = chain.BellmanFordAsync(N - 1, pool, late).get();
+    assert(timed.status == QueryStatus::Timeout);
+    assert(chrono::steady_clock::now() - t0 < chrono::seconds(2));
+
+    // отмена во время выполнения; частичные расстояния - длины настоящих путей
+    cancel = false;
+    auto running = chain.BellmanFordAsync(N - 1, pool, stop);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    cancel = true;
+    auto part = running.get();
+    assert(part.status == QueryStatus::Cancelled && part.value[N - 1] == 0);
+    for (int i = 0; i < N; ++i)
+        assert(part.value[i] == INF || part.value[i] == N - 1 - i);
+}
+
+void test_centrality() {
+    const double INF = 1000000000;
+    ThreadPool pool(3);
+
+    // ромб: два равных кратчайших пути 0 - 3
+    DGraph<int, double> d(INF);
+    for (int i = 0; i < 4; ++i)
+        d.AddV(i);
+    d.AddE(0, 1, 1);
+    d.AddE(0, 2, 1);
+    d.AddE(1, 3, 1);
+    d.AddE(2, 3, 1);
+    auto bd = d.Betweenness(pool);
+    assert(bd.exact && bd.sources == 4);
+    assert(bd.scores[0] == 0 && bd.scores[1] == 0.5 && bd.scores[2] == 0.5 && bd.scores[3] == 0);
+
+    // случайный граф: перебор всех пар по матрице расстояний
+    const int N = 60;
+    GenOptions opt;
+    opt.seed = 47;
+    GenWeights<double> gw;
+    gw.minW = 1;
+    gw.maxW = 5;
+    auto edges = GenErdosRenyi(N, 0.06, false, gw, opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    // целые веса: суммы точны, равные пути действительно равны
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, floor(e.weight));
+
+    for (bool weighted : { false, true }) {
+        vector<vector<double>> dist(N), sigma(N, vector<double>(N, 0));
+        for (int s = 0; s < N; ++s) {
+            dist[s] = g.Dijkstra(s);
+            if (!weighted) {
+                auto hops = g.BatchBFS(vector<int>{ s }, pool);
+                for (int v = 0; v < N; ++v)
+                    dist[s][v] = hops.At(0, v) < 0 ? INF : hops.At(0, v);
+            }
+            vector<int> order(N);
+            for (int v = 0; v < N; ++v)
+                order[v] = v;
+            sort(order.begin(), order.end(), [&](int a, int b) { return dist[s][a] < dist[s][b]; });
+            sigma[s][s] = 1;
+            for (int v : order)
+                for (int u = 0; u < N; ++u)
+                    if (v != s && dist[s][v] < INF && g.HasEdge(u, v)
+                        && dist[s][u] + (weighted ? g.GetEdge(u, v) : 1.0) == dist[s][v])
+                        sigma[s][v] += sigma[s][u];
+        }
+        vector<double> bc(N, 0), cl(N, 0), hc(N, 0);
+        for (int v = 0; v < N; ++v) {
+            for (int s = 0; s < N; ++s)
+                for (int t = 0; t < N; ++t)
+                    if (s != v && t != v && s != t && dist[s][t] < INF
+                        && dist[s][v] + dist[v][t] == dist[s][t])
+                        bc[v] += sigma[s][v] * sigma[v][t] / sigma[s][t];
+            double sum = 0, r = 0;
+            for (int u = 0; u < N; ++u)
+                if (u != v && dist[v][u] < INF) {
+                    sum += dist[v][u];
+                    r += 1;
+                    hc[v] += 1.0 / dist[v][u] / (N - 1);
+                }
+            cl[v] = sum > 0 ? r / (N - 1) * r / sum : 0;
+        }
+
+        auto engine = g.Centrality(pool, weighted);
+        auto b = engine.Betweenness();
+        auto c = engine.Closeness();
+        auto h = engine.Harmonic();
+        for (int v = 0; v < N; ++v) {
+            assert(fabs(b.scores[v] - bc[v]) < 1e-9);
+            assert(fabs(c.scores[v] - cl[v]) < 1e-12 && fabs(h.scores[v] - hc[v]) < 1e-12);
+        }
+
+        // выборка из всех вершин - точный ответ
+        CentralityOptions all;
+        all.samples = N;
+        auto same = engine.Betweenness(all);
+        assert(same.exact);
+        for (int v = 0; v < N; ++v)
+            assert(fabs(same.scores[v] - b.scores[v]) < 1e-9);
+    }
+
+    // выборка по допустимой погрешности
+    const int M = 300;
+    auto big = GenBuild(M, GenErdosRenyi(M, 0.01, false, GenWeights<double>(), opt), INF);
+    CentralityOptions approx;
+    approx.epsilon = 0.2;
+    size_t k = CentralityEngine<int>::SampleSize(M, 0.2, approx.delta);
+    assert(k < static_cast<size_t>(M));
+    auto exactB = big.Betweenness(pool);
+    auto exactH = big.HarmonicCentrality(pool);
+    auto estB = big.Betweenness(pool, false, approx);
+    auto estH = big.HarmonicCentrality(pool, false, approx);
+    assert(!estB.exact && estB.sources == k && estH.sources == k);
+    for (int v = 0; v < M; ++v) {
+        assert(fabs(estB.scores[v] - exactB.scores[v]) <= 0.2 * M * (M - 2));
+        assert(fabs(estH.scores[v] - exactH.scores[v]) <= 0.2);
+    }
+    auto estC = big.Closeness(pool, false, approx);
+    assert(estC.scores.size() == static_cast<size_t>(M));
+
+    // веса должны быть положительны
+    d.AddE(3, 0, 0);
+    try {
+        d.Betweenness(pool, true);
+        assert(false);
+    }
+    catch (const runtime_error&) {
+
+    }
+    assert(d.Betweenness(pool).scores.size() == 4);
+}
+
+void test_triangles() {
+    const double INF = 1000000000;
+    ThreadPool pool(3);
+
+    // треугольник в разных направлениях, петля, повторное ребро и висячая вершина
+    DGraph<int, double> s(INF);
+    for (int i = 0; i < 5; ++i)
+        s.AddV(i);
+    s.AddE(0, 1, 1);
+    s.AddE(2, 1, 1);
+    s.AddE(0, 2, 1);
+    s.AddE(2, 0, 1);
+    s.AddE(1, 1, 1);
+    s.AddE(2, 3, 1);
+    assert(s.CountTriangles(pool) == 1);
+    auto cs = s.ClusteringCoefficients(pool);
+    assert(cs[0] == 1 && cs[1] == 1 && fabs(cs[2] - 1.0 / 3) < 1e-12 && cs[3] == 0 && cs[4] == 0);
+
+    // степенной граф: перебор по матрице смежности
+    const int N = 400;
+    GenOptions opt;
+    opt.seed = 48;
+    auto edges = GenBarabasiAlbert(N, 6, GenWeights<double>(), opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    vector<vector<char>> adj(N, vector<char>(N, 0));
+    for (const auto& e : edges)
+        if (e.from != e.to)
+            adj[e.from][e.to] = adj[e.to][e.from] = 1;
+    vector<uint64_t> ref(N, 0);
+    uint64_t total = 0;
+    for (int a = 0; a < N; ++a)
+        for (int b = a + 1; b < N; ++b)
+            if (adj[a][b])
+                for (int c = b + 1; c < N; ++c)
+                    if (adj[a][c] && adj[b][c]) {
+                        ++total;
+                        ++ref[a];
+                        ++ref[b];
+                        ++ref[c];
+                    }
+    assert(total > 0);
+
+    TriangleOptions variants[3];
+    variants[1].simd = false;
+    variants[2].bitmapDegree = 2;
+    for (const TriangleOptions& o : variants) {
+        auto t = g.Triangles(pool, o);
+        assert(t.Count() == total && t.PerVertex() == ref);
+    }
+    assert(g.CountTriangles(pool) == total);
+    auto cc = g.ClusteringCoefficients(pool);
+    for (int v = 0; v < N; ++v) {
+        double d = 0;
+        for (int u = 0; u < N; ++u)
+            d += adj[v][u];
+        double expect = d >= 2 ? 2.0 * ref[v] / (d * (d - 1)) : 0.0;
+        assert(fabs(cc[v] - expect) < 1e-12);
+    }
+
+    // пересечение блоками: совпадения на границах блоков и в хвостах
+    vector<int> a, b;
+    for (int i = 0; i < 200; ++i) {
+        if (i % 3 == 0)
+            a.push_back(i);
+        if (i % 5 == 0 || i > 190)
+            b.push_back(i);
+    }
+    vector<int> simd, scalar;
+    tri_detail::Intersect(a.data(), a.size(), b.data(), b.size(), true, [&](int x) { simd.push_back(x); });
+    set_intersection(a.begin(), a.end(), b.begin(), b.end(), back_inserter(scalar));
+    assert(simd == scalar);
+}
+
+void test_views() {
+    const double INF = 1000000000;
+    const int N = 60;
+    GenOptions opt;
+    opt.seed = 49;
+    GenWeights<double> gw;
+    gw.minW = 1;
+    gw.maxW = 10;
+    auto edges = GenErdosRenyi(N, 0.08, false, gw, opt);
+    DGraph<int, double> g(INF);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i * 10);
+    for (const auto& e : edges)
+        g.AddE(e.from * 10, e.to * 10, floor(e.weight));
+
+    // видимы вершины, не кратные 30, и рёбра веса меньше 6; эталон строится явно
+    vector<int> keep;
+    for (int i = 0; i < N; ++i)
+        if (i % 3 != 0)
+            keep.push_back(i * 10);
+    auto cheap = [](const int&, const int&, const double& w) { return w < 6; };
+    auto view = g.View().Induced(keep).Filter(cheap);
+    for (int reversed = 0; reversed < 2; ++reversed) {
+        auto v = reversed ? view.Reverse() : view;
+        DGraph<int, double, allocator<char>, AdjacencyList> ref(INF);
+        for (int x : keep)
+            ref.AddV(x);
+        for (int a : keep)
+            for (int b : keep)
+                if (g.HasEdge(a, b) && g.GetWeight(a, b) < 6) {
+                    if (reversed)
+                        ref.AddE(b, a, g.GetWeight(a, b));
+                    else
+                        ref.AddE(a, b, g.GetWeight(a, b));
+                }
+        auto m = v.Materialize<DGraph<int, double, allocator<char>, AdjacencyList>>();
+        assert(v.Size() == ref.Size() && m.Size() == ref.Size());
+        for (int i = 0; i < ref.Size(); ++i)
+            assert(m.VertexAt(i) == ref.VertexAt(i));
+        for (int a : keep) {
+            assert(v.BFS(a) == ref.BFS(a) && v.DFS(a) == ref.DFS(a));
+            assert(v.GetNeighbors(a) == ref.GetNeighbors(a) && m.GetNeighbors(a) == ref.GetNeighbors(a));
+            for (int b : keep) {
+                assert(v.HasEdge(a, b) == ref.HasEdge(a, b) && m.HasEdge(a, b) == ref.HasEdge(a, b));
+                if (ref.HasEdge(a, b))
+                    assert(v.GetWeight(a, b) == ref.GetWeight(a, b) && m.GetWeight(a, b) == ref.GetWeight(a, b));
+            }
+        }
+        for (int s = 0; s < 6; ++s) {
+            int a = keep[s * 5];
+            auto dv = v.BellmanFord(a);
+            auto dr = ref.BellmanFord(a);
+            for (int x : keep)
+                assert(dv[g.IndexOf(x)] == dr[ref.IndexOf(x)]);
+            for (int i = 0; i < N; i += 3)
+                assert(dv[i] == INF);
+        }
+    }
+
+    // без маски и условия представление совпадает с графом
+    auto all = g.View();
+    assert(all.Size() == g.Size() && all.BFS(0) == g.BFS(0) && all.DFS(0) == g.DFS(0));
+    assert(all.GetNeighbors(50) == g.GetNeighbors(50));
+
+    // маска по индексам пересекается с уже заданной, скрытая вершина недоступна
+    vector<bool> bitmap(N, true);
+    bitmap[1] = false;
+    auto narrow = view.Induced(bitmap);
+    assert(narrow.Size() == view.Size() - 1 && !narrow.HasVert(10) && !narrow.HasVert(0) && narrow.HasVert(20));
+    bool thrown = false;
+    try {
+        narrow.BFS(10);
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    thrown = false;
+    try {
+        g.View().Induced(vector<int>{ 5 });
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+
+    // отрицательный цикл виден только при пропускающем его условии
+    DGraph<int, double> c(INF);
+    for (int i = 0; i < 3; ++i)
+        c.AddV(i);
+    c.AddE(0, 1, 1);
+    c.AddE(1, 2, -3);
+    c.AddE(2, 0, 1);
+    thrown = false;
+    try {
+        c.View().Reverse().BellmanFord(0);
+    }
+    catch (const runtime_error&) {
+        thrown = true;
+    }
+    assert(thrown);
+    auto d = c.View().Filter([](const int& a, const int&, const double&) { return a != 2; }).Reverse().BellmanFord(2);
+    assert(d[0] == -2 && d[1] == -3 && d[2] == 0);
+}
+
+/// <summary>
+/// Удаление большинства вершин и рёбер, затем Compact: лишняя память освобождается, граф не меняется
+/// </summary>
+template <typename G, typename W>
+static void check_compaction(W inf, W weight) {
+    const int N = 300;
+    G g(inf);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (int i = 0; i < N; ++i)
+        for (int j = 1; j <= 8; ++j)
+            g.AddE(i, (i * 7 + j) % N, weight);
+    GraphMemory full = g.MemoryUsage();
+    assert(full.keys >= N * sizeof(int) && full.index > 0 && full.adjacency > 0 && full.caches == 0);
+    assert(full.Total() == full.keys + full.index + full.adjacency + full.weights);
+
+    for (int i = 0; i < N; ++i)
+        if (i % 10 != 0)
+            g.DeleteV(i);
+    for (int i = 0; i < N; i += 20)
+        for (int j = 0; j < N; j += 10)
+            if (g.HasEdge(i, j))
+                g.DeleteE(i, j);
+    vector<vector<int>> bfs;
+    for (int i = 0; i < N; i += 10)
+        bfs.push_back(g.BFS(i));
+    g.CanReach(0, 10);
+    GraphMemory before = g.MemoryUsage();
+    assert(before.caches > 0 && before.slack > 0 && before.Waste() > 0.25);
+
+    assert(g.Compact());
+    GraphMemory after = g.MemoryUsage();
+    assert(after.slack == 0 && after.Waste() == 0.0 && after.Total() < before.Total());
+    assert(after.caches == before.caches);
+    assert(!g.Compact());
+    assert(g.Size() == N / 10);
+    for (int i = 0; i < N; i += 10)
+        assert(g.HasVert(i) && g.BFS(i) == bfs[i / 10]);
+    g.AddV(N);
+    g.AddE(N, 0, weight);
+    assert(g.HasEdge(N, 0) && g.GetNeighbors(0).back() == N);
+}
+
+void test_memory_usage() {
+    check_compaction<DGraph<int, double>>(1e9, 2.5);
+    check_compaction<DGraph<int, double, allocator<char>, DenseBitmap>>(1e9, 2.5);
+    check_compaction<DGraph<int, double, allocator<char>, AdjacencyList>>(1e9, 2.5);
+    check_compaction<DGraph<int, Unweighted, allocator<char>, DenseBitmap>>(Unweighted(), Unweighted());
+    check_compaction<DGraph<int, Unweighted, allocator<char>, AdjacencyList>>(Unweighted(), Unweighted());
+
+    // веса: у невзвешенного графа не хранятся
+    DGraph<int, Unweighted, allocator<char>, AdjacencyList> u(Unweighted{});
+    DGraph<int, double, allocator<char>, AdjacencyList> w(0.0);
+    for (int i = 0; i < 10; ++i) {
+        u.AddV(i);
+        w.AddV(i);
+    }
+    for (int i = 1; i < 10; ++i) {
+        u.AddE(0, i, Unweighted());
+        w.AddE(0, i, 1.0);
+    }
+    assert(u.MemoryUsage().weights == 0 && w.MemoryUsage().weights >= 9 * sizeof(double));
+
+    // пустой граф после ShrinkToFit не держит памяти
+    DGraph<int, double> e(1e9);
+    for (int i = 0; i < 50; ++i)
+        e.AddV(i);
+    e.Clear();
+    e.ShrinkToFit();
+    GraphMemory m = e.MemoryUsage();
+    assert(m.Total() == 0 && m.slack == 0);
 }
\ No newline at end of file
@@ -10,345 +10,2371 @@
 #include <iomanip>
 #include <fstream>
 #include <sstream>
+#include <memory>
+#include <memory_resource>
+#include "TGrIndex.h"
+#include "TGrStorage.h"
+#include "TGrFrozen.h"
+#include "TGrCompressed.h"
+#include "TGrPool.h"
+#include "TGrComponents.h"
+#include "TGrAnalytics.h"
+#include "TGrExternal.h"
+#include "TGrJournal.h"
+#include "TGrBatch.h"
+#include "TGrWorkspace.h"
+#include "TGrReach.h"
+#include "TGrLandmarks.h"
+#include "TGrCH.h"
+#include "TGrCentrality.h"
+#include "TGrTriangles.h"
+#include "TGrView.h"
+#include <atomic>
+#include <chrono>
+#include <future>
+
+#ifdef DGRAPH_STATS
+#include <functional>
+#endif
 
 using namespace std;
 
 /// <summary>
-///       
+/// Счётчики работы DGraph.
+/// Собираются только при сборке с DGRAPH_STATS, иначе все поля равны 0,
+/// а код подсчёта не попадает в бинарник.
 /// </summary>
-/// <typeparam name="T"> </typeparam>
-/// <typeparam name="W">  </typeparam>
-template <typename T, typename W>
+struct DGraphStats {
+    /// <summary>
+    /// количество вызовов обходов и поиска путей
+    /// </summary>
+    unsigned long long calls = 0;
+
+    /// <summary>
+    /// просмотрено элементов смежности
+    /// </summary>
+    unsigned long long edgesScanned = 0;
+
+    /// <summary>
+    /// успешных релаксаций расстояния
+    /// </summary>
+    unsigned long long relaxations = 0;
+
+    /// <summary>
+    /// добавлений в очередь / стек
+    /// </summary>
+    unsigned long long queuePushes = 0;
+
+    /// <summary>
+    /// обращений к indexMap
+    /// </summary>
+    unsigned long long indexProbes = 0;
+
+    /// <summary>
+    /// рабочих и результирующих массивов, заведённых вызовом (по одному на массив;
+    /// перевыделения при росте массивов и выделения внутри контейнеров не считаются)
+    /// </summary>
+    unsigned long long scratchArrays = 0;
+
+    /// <summary>
+    /// время выполнения, нс
+    /// </summary>
+    unsigned long long elapsedNs = 0;
+};
+
+#ifdef DGRAPH_STATS
+
+/// <summary>
+/// Накопитель статистики графа. Счётчики атомарные, поэтому const-методы
+/// можно вызывать из нескольких потоков.
+/// </summary>
+class DGraphStatsSink {
+public:
+    atomic<unsigned long long> calls{ 0 }, edgesScanned{ 0 }, relaxations{ 0 }, queuePushes{ 0 },
+        indexProbes{ 0 }, scratchArrays{ 0 }, elapsedNs{ 0 };
+
+    /// <summary>
+    /// вызывается после каждого обхода: имя операции и счётчики этого вызова
+    /// </summary>
+    function<void(const char*, const DGraphStats&)> trace;
+
+    DGraphStatsSink() {}
+
+    // копия графа начинает со своих нулевых счётчиков
+    DGraphStatsSink(const DGraphStatsSink& o) : trace(o.trace) {}
+    DGraphStatsSink& operator=(const DGraphStatsSink& o) {
+        trace = o.trace;
+        return *this;
+    }
+
+    void Add(const DGraphStats& s) {
+        calls.fetch_add(s.calls, memory_order_relaxed);
+        edgesScanned.fetch_add(s.edgesScanned, memory_order_relaxed);
+        relaxations.fetch_add(s.relaxations, memory_order_relaxed);
+        queuePushes.fetch_add(s.queuePushes, memory_order_relaxed);
+        indexProbes.fetch_add(s.indexProbes, memory_order_relaxed);
+        scratchArrays.fetch_add(s.scratchArrays, memory_order_relaxed);
+        elapsedNs.fetch_add(s.elapsedNs, memory_order_relaxed);
+    }
+
+    DGraphStats Get() const {
+        DGraphStats s;
+        s.calls = calls.load(memory_order_relaxed);
+        s.edgesScanned = edgesScanned.load(memory_order_relaxed);
+        s.relaxations = relaxations.load(memory_order_relaxed);
+        s.queuePushes = queuePushes.load(memory_order_relaxed);
+        s.indexProbes = indexProbes.load(memory_order_relaxed);
+        s.scratchArrays = scratchArrays.load(memory_order_relaxed);
+        s.elapsedNs = elapsedNs.load(memory_order_relaxed);
+        return s;
+    }
+
+    void Reset() {
+        calls = edgesScanned = relaxations = queuePushes = indexProbes = scratchArrays = elapsedNs = 0;
+    }
+};
+
+/// <summary>
+/// Счётчики одного вызова: копятся на стеке и сбрасываются в накопитель в деструкторе
+/// </summary>
+class DGraphStatsScope {
+public:
+    DGraphStats call;
+
+    DGraphStatsScope(DGraphStatsSink& sink, const char* op)
+        : sink(sink), op(op), start(chrono::steady_clock::now()) {
+        call.calls = 1;
+    }
+
+    ~DGraphStatsScope() {
+        call.elapsedNs = static_cast<unsigned long long>(
+            chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count());
+        sink.Add(call);
+        if (sink.trace)
+            sink.trace(op, call);
+    }
+
+private:
+    DGraphStatsSink& sink;
+    const char* op;
+    chrono::steady_clock::time_point start;
+};
+
+// начало измеряемого вызова
+#define DGRAPH_SCOPE(op) DGraphStatsScope statsScope_(statsSink, op)
+// счётчик текущего вызова
+#define DGRAPH_COUNT(field, n) (statsScope_.call.field += (n))
+// счётчик вне измеряемого вызова
+#define DGRAPH_COUNT_TOTAL(field, n) (statsSink.field.fetch_add((n), memory_order_relaxed))
+
+#else
+
+#define DGRAPH_SCOPE(op) ((void)0)
+#define DGRAPH_COUNT(field, n) ((void)0)
+#define DGRAPH_COUNT_TOTAL(field, n) ((void)0)
+
+#endif
+
+/// <summary>
+/// Состояние ответа на запрос
+/// </summary>
+enum class QueryStatus : unsigned char {
+    Done,       // ответ полный
+    Cancelled,  // запрос отменён через флаг отмены
+    Timeout,    // истёк крайний срок
+    Failed      // вершина не найдена или обнаружен отрицательный цикл
+};
+
+/// <summary>
+/// Управление долгими запросами: необязательный флаг отмены и крайний срок.
+/// Проверяется между шагами алгоритма, поэтому остановка происходит не мгновенно,
+/// а в течение одного прохода.
+/// </summary>
+struct QueryControl {
+    /// <summary>
+    /// флаг отмены, выставляемый другим потоком (nullptr - без отмены)
+    /// </summary>
+    const atomic<bool>* cancel = nullptr;
+
+    /// <summary>
+    /// крайний срок выполнения
+    /// </summary>
+    chrono::steady_clock::time_point deadline = chrono::steady_clock::time_point::max();
+
+    /// <summary>
+    /// Задать крайний срок относительно текущего момента
+    /// </summary>
+    template <typename Rep, typename Period>
+    QueryControl& Within(chrono::duration<Rep, Period> d) {
+        deadline = chrono::steady_clock::now() + chrono::duration_cast<chrono::steady_clock::duration>(d);
+        return *this;
+    }
+
+    /// <summary>
+    /// Done - можно продолжать, иначе причина остановки
+    /// </summary>
+    QueryStatus Check() const {
+        if (cancel && cancel->load(memory_order_relaxed))
+            return QueryStatus::Cancelled;
+        if (deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= deadline)
+            return QueryStatus::Timeout;
+        return QueryStatus::Done;
+    }
+};
+
+/// <summary>
+/// Лениво вычисляемое значение, производное от графа (свойства, индексы).
+/// Хранит неизменяемый объект через shared_ptr с атомарным доступом, поэтому
+/// константные методы графа могут заполнять кэш из нескольких потоков,
+/// а копирование графа безопасно при одновременном чтении.
+/// </summary>
+template <typename X>
+class LazyCache {
+public:
+    LazyCache() {}
+    LazyCache(const LazyCache& o) : ptr(atomic_load(&o.ptr)) {}
+    LazyCache& operator=(const LazyCache& o) {
+        atomic_store(&ptr, atomic_load(&o.ptr));
+        return *this;
+    }
+
+    /// <summary>
+    /// Значение из кэша или make(), если кэш пуст.
+    /// При гонке make() может выполниться дважды, результат одинаков.
+    /// </summary>
+    template <typename F>
+    shared_ptr<const X> Get(F make) const {
+        shared_ptr<const X> cached = atomic_load(&ptr);
+        if (!cached) {
+            cached = make();
+            atomic_store(&ptr, cached);
+        }
+        return cached;
+    }
+
+    /// <summary>
+    /// Текущее значение без вычисления (nullptr, если кэш пуст)
+    /// </summary>
+    shared_ptr<const X> Peek() const {
+        return atomic_load(&ptr);
+    }
+
+    /// <summary>
+    /// Замена значения (только при монопольном доступе к графу)
+    /// </summary>
+    void Set(shared_ptr<const X> x) {
+        ptr = move(x);
+    }
+
+    /// <summary>
+    /// Сброс (только при монопольном доступе к графу)
+    /// </summary>
+    void Reset() {
+        ptr.reset();
+    }
+
+private:
+    mutable shared_ptr<const X> ptr;
+};
+
+/// <summary>
+/// Указатель на получателя изменений графа (журнал). Не переносится при копировании
+/// и присваивании: копия графа начинает без журнала, а граф сохраняет свой.
+/// </summary>
+template <typename X>
+class ObserverSlot {
+public:
+    ObserverSlot() {}
+    ObserverSlot(const ObserverSlot&) {}
+    ObserverSlot& operator=(const ObserverSlot&) {
+        return *this;
+    }
+
+    X* ptr = nullptr;
+};
+
+/// <summary>
+/// Алгоритм, выбранный ShortestPathsAuto
+/// </summary>
+enum class PathMethod : unsigned char {
+    Dag,         // релаксация в топологическом порядке, O(V + E)
+    Dijkstra,    // неотрицательные веса, O((V + E) log V)
+    BellmanFord  // общий случай, O(V * E)
+};
+
+/// <summary>
+/// Способ перенумерации вершин для DGraph::Reorder
+/// </summary>
+enum class ReorderStrategy : unsigned char {
+    ReverseCuthillMcKee, // обратный Катхилл-Макки: соседи получают близкие номера, узкая лента матрицы
+    DegreeDescending,    // по убыванию степени: частые вершины в начале, в одних строках кэша
+    BfsOrder             // порядок обхода в ширину от вершины наибольшей степени
+};
+
+/// <summary>
+/// Результат пакетного запроса: непрерывная матрица rows x cols по строкам.
+/// Строка i - ответ для i-го источника по индексам вершин, status[i] - его состояние.
+/// </summary>
+/// <typeparam name="V">тип элемента (расстояние или число рёбер)</typeparam>
+template <typename V>
+struct BatchResult {
+    size_t rows = 0;
+    size_t cols = 0;
+    vector<V> data;
+    vector<QueryStatus> status;
+
+    const V* Row(size_t i) const {
+        return data.data() + i * cols;
+    }
+
+    V* Row(size_t i) {
+        return data.data() + i * cols;
+    }
+
+    const V& At(size_t i, size_t j) const {
+        return data[i * cols + j];
+    }
+
+    /// <summary>
+    /// Все ли строки получены полностью
+    /// </summary>
+    bool Complete() const {
+        for (QueryStatus st : status)
+            if (st != QueryStatus::Done)
+                return false;
+        return true;
+    }
+};
+
+/// <summary>
+/// Результат одиночного запроса с управлением (QueryControl).
+/// При status != Done value содержит частичный ответ на момент остановки.
+/// </summary>
+/// <typeparam name="V">тип ответа</typeparam>
+template <typename V>
+struct QueryResult {
+    QueryStatus status = QueryStatus::Done;
+    V value;
+
+    /// <summary>
+    /// Ответ получен полностью
+    /// </summary>
+    bool Complete() const {
+        return status == QueryStatus::Done;
+    }
+};
+
+/// <summary>
+/// Память графа по составляющим, байт (DGraph::MemoryUsage)
+/// </summary>
+struct GraphMemory {
+    /// <summary>
+    /// массив вершин (sizeof(T) на вершину, без памяти, на которую ссылаются сами ключи)
+    /// </summary>
+    size_t keys = 0;
+
+    /// <summary>
+    /// хеш-индекс вершин
+    /// </summary>
+    size_t index = 0;
+
+    /// <summary>
+    /// структура хранилища рёбер: заголовки строк, битовые карты, приёмники списков
+    /// </summary>
+    size_t adjacency = 0;
+
+    /// <summary>
+    /// веса рёбер
+    /// </summary>
+    size_t weights = 0;
+
+    /// <summary>
+    /// кэшированные свойства и индекс достижимости
+    /// </summary>
+    size_t caches = 0;
+
+    /// <summary>
+    /// выделено сверх необходимого (ёмкость сверх размера, лишние слоты индекса);
+    /// входит в остальные поля и освобождается ShrinkToFit
+    /// </summary>
+    size_t slack = 0;
+
+    size_t Total() const {
+        return keys + index + adjacency + weights + caches;
+    }
+
+    /// <summary>
+    /// Доля лишней памяти от 0 до 1
+    /// </summary>
+    double Waste() const {
+        size_t total = Total();
+        return total ? static_cast<double>(slack) / static_cast<double>(total) : 0.0;
+    }
+};
+
+/// <summary>
+/// Реализация ориентированного графа на основе матрицы смежности
+/// (или другого хранилища, выбранного политикой S во время компиляции)
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер (Unweighted - без весов)</typeparam>
+/// <typeparam name="A">распределитель памяти для вершин, матрицы, индекса и рабочих массивов обходов</typeparam>
+/// <typeparam name="S">политика хранения рёбер: DenseSentinel, DenseBitmap, AdjacencyList</typeparam>
+/// <typeparam name="I">тип индекса вершины (int, int64_t)</typeparam>
+template <typename T, typename W, typename A = allocator<char>, typename S = DenseSentinel, typename I = int>
 class DGraph {
+public:
+
+    /// <summary>
+    /// распределитель A, перепривязанный к типу U
+    /// </summary>
+    template <typename U>
+    using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+
+    /// <summary>
+    /// тип хранилища рёбер
+    /// </summary>
+    using Storage = typename S::template Storage<W, I, A>;
+
+    /// <summary>
+    /// типы вершин, весов и индексов (для представлений и алгоритмов над графом)
+    /// </summary>
+    using Vertex = T;
+    using Weight = W;
+    using Index = I;
+
 private:
 
     /// <summary>
-    ///  
+    /// список вершин
+    /// </summary>
+    vector<T, Alloc<T>> vertices;
+
+    /// <summary>
+    /// хранилище рёбер; для DenseSentinel - матрица смежности, adj[i][j] = вес ребра, направленного из i в j
+    /// </summary>
+    Storage adj;
+
+    /// <summary>
+    /// отображение вершины в индекс: плоская хеш-таблица, хранящая только индексы,
+    /// сами ключи берутся из vertices
+    /// </summary>
+    FlatIndex<T, I, Alloc<char>> indexMap;
+
+    /// <summary>
+    /// обозначение "нет ребра"
+    /// </summary>
+    W INF;
+
+#ifdef DGRAPH_STATS
+    /// <summary>
+    /// накопленная статистика (только с DGRAPH_STATS)
+    /// </summary>
+    mutable DGraphStatsSink statsSink;
+#endif
+
+    /// <summary>
+    /// Свойства графа, вычисляемые один раз до следующего изменения
+    /// </summary>
+    struct Shape {
+        /// <summary>
+        /// граф ацикличен
+        /// </summary>
+        bool acyclic = false;
+
+        /// <summary>
+        /// все веса неотрицательны
+        /// </summary>
+        bool nonNegative = true;
+
+        /// <summary>
+        /// топологический порядок индексов (если acyclic)
+        /// </summary>
+        vector<I> topo;
+    };
+
+    /// <summary>
+    /// кэш свойств графа
+    /// </summary>
+    LazyCache<Shape> shape;
+
+    /// <summary>
+    /// индекс достижимости (Reachability)
+    /// </summary>
+    LazyCache<ReachabilityIndex<I>> reach;
+
+    /// <summary>
+    /// журнал изменений (AttachJournal)
+    /// </summary>
+    ObserverSlot<MutationObserver<T, W>> journal;
+
+    /// <summary>
+    /// Сброс кэшированных свойств; вызывается каждым изменяющим методом
+    /// </summary>
+    void Touch() {
+        shape.Reset();
+        reach.Reset();
+    }
+
+    template <typename X>
+    static bool Negative(const X& w) {
+        return w < X();
+    }
+
+    static bool Negative(const Unweighted&) {
+        return false;
+    }
+
+    template <typename X>
+    static double AsDouble(const X& w) {
+        return static_cast<double>(w);
+    }
+
+    static double AsDouble(const Unweighted&) {
+        return 1.0;
+    }
+
+    /// <summary>
+    /// Свойства графа: алгоритм Кана и проверка знаков весов за один проход
+    /// </summary>
+    shared_ptr<const Shape> GetShape() const {
+        return shape.Get([this]() { return ComputeShape(); });
+    }
+
+    shared_ptr<const Shape> ComputeShape() const {
+        auto sh = make_shared<Shape>();
+        I n = static_cast<I>(vertices.size());
+        vector<I> indeg(n, 0);
+        for (I u = 0; u < n; ++u)
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                ++indeg[v];
+                if (Negative(w))
+                    sh->nonNegative = false;
+            });
+
+        sh->topo.reserve(n);
+        for (I v = 0; v < n; ++v)
+            if (indeg[v] == 0)
+                sh->topo.push_back(v);
+        for (size_t head = 0; head < sh->topo.size(); ++head)
+            adj.ForEachOut(sh->topo[head], [&](I v, const W&) {
+                if (--indeg[v] == 0)
+                    sh->topo.push_back(v);
+            });
+        sh->acyclic = sh->topo.size() == static_cast<size_t>(n);
+        if (!sh->acyclic)
+            sh->topo.clear();
+        return sh;
+    }
+
+    /// <summary>
+    /// Форд-Беллман от индекса s с записью в готовую строку dist (размер V).
+    /// Проверяет ctl после каждого прохода и останавливается, если проход ничего не улучшил.
+    /// </summary>
+    QueryStatus RelaxFrom(I s, W* dist, const QueryControl& ctl) const {
+        I n = static_cast<I>(vertices.size());
+        fill(dist, dist + n, INF);
+        dist[s] = 0;
+        for (I k = 0; k < n - 1; ++k) {
+            QueryStatus st = ctl.Check();
+            if (st != QueryStatus::Done)
+                return st;
+            bool changed = false;
+            for (I u = 0; u < n; ++u) {
+                if (dist[u] == INF)
+                    continue;
+                adj.ForEachOut(u, [&](I v, const W& w) {
+                    if (dist[v] > dist[u] + w) {
+                        dist[v] = dist[u] + w;
+                        changed = true;
+                    }
+                });
+            }
+            if (!changed)
+                return QueryStatus::Done;
+        }
+        bool negative = false;
+        for (I u = 0; u < n && !negative; ++u) {
+            if (dist[u] == INF)
+                continue;
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                if (dist[v] > dist[u] + w)
+                    negative = true;
+            });
+        }
+        return negative ? QueryStatus::Failed : QueryStatus::Done;
+    }
+
+    /// <summary>
+    /// BFS от индекса s: hops[v] - число рёбер кратчайшего пути, -1 - недостижима.
+    /// q - рабочая очередь потока, переиспользуется между запросами.
+    /// </summary>
+    QueryStatus HopsFrom(I s, int* hops, vector<I>& q, const QueryControl& ctl) const {
+        I n = static_cast<I>(vertices.size());
+        fill(hops, hops + n, -1);
+        q.clear();
+        q.push_back(s);
+        hops[s] = 0;
+        for (size_t head = 0; head < q.size(); ++head) {
+            if ((head & 1023) == 1023) {
+                QueryStatus st = ctl.Check();
+                if (st != QueryStatus::Done)
+                    return st;
+            }
+            I u = q[head];
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (hops[v] < 0) {
+                    hops[v] = hops[u] + 1;
+                    q.push_back(v);
+                }
+            });
+        }
+        return QueryStatus::Done;
+    }
+
+    /// <summary>
+    /// Рёбра в упакованном виде CSR: приёмники вершины u - targets[offsets[u] .. offsets[u + 1])
+    /// по возрастанию индекса, веса (если нужны) - параллельно в weights
+    /// </summary>
+    void BuildCsr(vector<size_t>& offsets, vector<I>& targets, vector<W>* weights = nullptr) const {
+        I n = static_cast<I>(vertices.size());
+        offsets.assign(static_cast<size_t>(n) + 1, 0);
+        targets.clear();
+        if (weights)
+            weights->clear();
+        for (I u = 0; u < n; ++u) {
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                targets.push_back(v);
+                if (weights)
+                    weights->push_back(w);
+            });
+            offsets[u + 1] = targets.size();
+        }
+    }
+
+    /// <summary>
+    /// Общая схема пакетного запроса: индексы источников ищутся заранее,
+    /// затем строки раздаются пулу по одной; run(s, row, slot) заполняет строку.
+    /// </summary>
+    template <typename V, typename F>
+    BatchResult<V> RunBatch(const T* sources, size_t count, ThreadPool& pool,
+        const QueryControl& ctl, V fillValue, F run) const {
+        BatchResult<V> res;
+        res.rows = count;
+        res.cols = vertices.size();
+        res.data.assign(res.rows * res.cols, fillValue);
+        res.status.assign(count, QueryStatus::Failed);
+
+        vector<I> idx(count);
+        for (size_t i = 0; i < count; ++i)
+            idx[i] = indexMap.Find(sources[i], vertices);
+
+        pool.ParallelFor(0, count, 1, [&](size_t i, unsigned slot) {
+            if (idx[i] < 0)
+                return;
+            QueryStatus st = ctl.Check();
+            res.status[i] = st != QueryStatus::Done ? st : run(idx[i], res.Row(i), slot);
+        });
+        return res;
+    }
+
+    /// <summary>
+    /// Объём работы (в просмотренных элементах строк) между проверками QueryControl
+    /// </summary>
+    static constexpr size_t CONTROL_STRIDE = size_t(1) << 14;
+
+    /// <summary>
+    /// Выполнение f() на исполнителе: результат или исключение f передаётся через future
+    /// </summary>
+    template <typename Executor, typename F>
+    static future<decltype(declval<F&>()())> RunAsync(Executor& executor, F f) {
+        using R = decltype(f());
+        auto task = make_shared<packaged_task<R()>>(move(f));
+        future<R> res = task->get_future();
+        executor.Submit([task]() { (*task)(); });
+        return res;
+    }
+
+    /// <summary>
+    /// A* с оценкой bound(v, t) (INF - цель недостижима из v).
+    /// Рабочие массивы - на поток (TraversalWorkspace): подготовка запроса O(1).
+    /// </summary>
+    template <typename Bound>
+    W AStarSearch(const T& from, const T& to, Bound bound, AStarStats* stats, vector<T>* path) const {
+        DGRAPH_SCOPE("AStar");
+        DGRAPH_COUNT(indexProbes, 2);
+        I s = indexMap.Find(from, vertices);
+        I t = indexMap.Find(to, vertices);
+        if (s < 0 || t < 0)
+            throw runtime_error("AStar: вершина не найдена");
+        if (!GetShape()->nonNegative)
+            throw runtime_error("AStar: ребро отрицательного веса");
+
+        // Visit - расстояние известно, Enqueue - вершина окончательно обработана, Hops - предок
+        static thread_local TraversalWorkspace<W, I> ws;
+        ws.Begin(vertices.size());
+        AStarStats st;
+        vector<pair<W, I>> heap;
+        auto later = [](const pair<W, I>& a, const pair<W, I>& b) { return a.first > b.first; };
+        if (path)
+            path->clear();
+
+        W result = INF;
+        W hs = bound(s, t);
+        if (hs != INF) {
+            ws.Visit(s);
+            ws.DistRef(s) = W();
+            ws.Hops(s) = -1;
+            heap.emplace_back(hs, s);
+        }
+        else
+            ++st.pruned;
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            I u = heap.back().second;
+            heap.pop_back();
+            if (!ws.Enqueue(u))
+                continue; // устаревшая запись
+            ++st.settled;
+            W d = ws.DistRef(u);
+            if (u == t) {
+                result = d;
+                break;
+            }
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                W nd = d + w;
+                bool fresh = ws.Visit(v);
+                if (!fresh && !(nd < ws.DistRef(v)))
+                    return;
+                W h = bound(v, t);
+                if (h == INF) {
+                    ++st.pruned;
+                    ws.DistRef(v) = nd;
+                    ws.Enqueue(v); // больше не рассматривается
+                    return;
+                }
+                ws.DistRef(v) = nd;
+                ws.Hops(v) = u;
+                heap.emplace_back(nd + h, v);
+                push_heap(heap.begin(), heap.end(), later);
+                ++st.relaxed;
+                DGRAPH_COUNT(relaxations, 1);
+                DGRAPH_COUNT(queuePushes, 1);
+            });
+        }
+
+        if (path && result != INF) {
+            for (I v = t; v >= 0; v = ws.Hops(v))
+                path->push_back(vertices[v]);
+            reverse(path->begin(), path->end());
+        }
+        if (stats)
+            *stats = st;
+        return result;
+    }
+
+public:
+
+    /// <summary>
+    /// Конструктор по умолчанию
+    /// </summary>
+    /// <param name="InVal">обозначение "нет ребра"</param>
+    DGraph(W InVal) : adj(InVal, A()), INF(InVal) {}
+
+    /// <summary>
+    /// Конструктор с распределителем памяти.
+    /// Например, с pmr::polymorphic_allocator поверх monotonic_buffer_resource
+    /// граф целиком живёт в арене и освобождается вместе с ней.
+    /// </summary>
+    /// <param name="InVal">обозначение "нет ребра"</param>
+    /// <param name="alloc">распределитель памяти</param>
+    DGraph(W InVal, const A& alloc)
+        : vertices(Alloc<T>(alloc)), adj(InVal, alloc),
+          indexMap(Alloc<char>(alloc)), INF(InVal) {}
+
+    /// <summary>
+    /// Распределитель памяти графа
+    /// </summary>
+    A GetAllocator() const {
+        return A(vertices.get_allocator());
+    }
+
+    /// <summary>
+    /// Размер графа
+    /// </summary>
+    /// <returns>количество вершин в графе</returns>
+    int Size() const {
+        return static_cast<int>(vertices.size());
+    }
+
+    /// <summary>
+    /// Накопленная статистика обходов и поиска путей.
+    /// Без DGRAPH_STATS всегда нулевая.
+    /// </summary>
+    /// <returns>суммарные счётчики с момента создания или ResetStats</returns>
+    DGraphStats GetStats() const {
+#ifdef DGRAPH_STATS
+        return statsSink.Get();
+#else
+        return DGraphStats();
+#endif
+    }
+
+    /// <summary>
+    /// Обнуление накопленной статистики
+    /// </summary>
+    void ResetStats() {
+#ifdef DGRAPH_STATS
+        statsSink.Reset();
+#endif
+    }
+
+    /// <summary>
+    /// Установка обработчика, вызываемого после каждого BFS, DFS, BellmanFord, GetNeighbors
+    /// со счётчиками этого вызова. Без DGRAPH_STATS обработчик не вызывается.
+    /// </summary>
+    /// <param name="trace">обработчик (имя операции, счётчики вызова)</param>
+    template <typename F>
+    void SetTraceCallback(F trace) {
+#ifdef DGRAPH_STATS
+        statsSink.trace = trace;
+#else
+        (void)trace;
+#endif
+    }
+
+    /// Проверяет, существует ли вершина
+
+    /// <summary>
+    /// Проверка существования вершины
+    /// </summary>
+    /// <param name="v">Вершина графа</param>
+    /// <returns>True - существует, False - не существует</returns>
+    bool HasVert(const T& v) const {
+        DGRAPH_COUNT_TOTAL(indexProbes, 1);
+        return indexMap.Find(v, vertices) >= 0;
+    }
+
+    /// Проверяет, существует ли ребро между двумя вершинами
+
+    /// <summary>
+    /// Проверка существования ребра между двумя вершинами
+    /// </summary>
+    /// <param name="from">1 вершина</param>
+    /// <param name="to">2 вершина</param>
+    /// <returns>True - существует, False - не существует</returns>
+    bool HasEdge(const T& from, const T& to) const {
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            return false;
+        return adj.Has(u, v);
+    }
+
+
+    /// <summary>
+    /// Вес ребра
+    /// </summary>
+    /// <param name="from">1 вершина</param>
+    /// <param name="to">2 вершина</param>
+    /// <exception cref="runtime_error - вершина не существует или ребро не существует">
+    /// </exception>
+    /// <returns>Вес ребра между двумя вершинами</returns>
+    W GetEdge(const T& from, const T& to) const {
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            throw runtime_error("getEdge: вершина не найдена"); // Бросаем исключение ошибки времени выполнения
+        if (!adj.Has(u, v))
+            throw runtime_error("getEdge: ребро не существует"); // Бросаем исключение ошибки времени выполнения
+        return adj.Get(u, v);
+    }
+
+
+    /// <summary>
+    /// Добавление вершины
+    /// Сложность: O(V ^ 2)
+    /// </summary>
+    /// <param name="value">Значение вершины</param>
+    /// <exception cref="runtime_error - вершина уже существует">
+    /// </exception>
+    void AddV(const T& value) {
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        if (indexMap.Find(value, vertices) >= 0) { // если вершина существует
+            throw runtime_error("Вершина уже существует");
+        }
+        if (journal.ptr)
+            journal.ptr->OnAddV(value);
+
+        // Добавляем её в список вершин и карту индексов.
+        vertices.push_back(value);
+        indexMap.Insert(value, static_cast<I>(vertices.size() - 1), vertices);
+
+        // Расширяем матрицу смежности: добавляем новый столбец и строку.
+        adj.AddVertex();
+
+        // новая вершина изолирована: достижимость остальных не меняется
+        auto kept = reach.Peek();
+        Touch();
+        reach.Set(kept);
+    }
+    
+    /// <summary>
+    /// Удаление вершины
+    /// Сложность: O(V^2)
+    /// </summary>
+    /// <param name="value">Значение вершины</param>
+    /// <exception cref="runtime_error - вершина не существует">
+    /// </exception>
+    void DeleteV(const T& value) {
+        DGRAPH_COUNT_TOTAL(indexProbes, 1);
+        I idx = indexMap.Find(value, vertices);
+        if (idx < 0) { // если вершина не существует
+            throw runtime_error("Вершина не найдена");
+        }
+        if (journal.ptr)
+            journal.ptr->OnDeleteV(value);
+
+        // Удаляем вершину 
+        vertices.erase(vertices.begin() + idx);
+
+        // Удаляем соответствующие строку и столбец из матрицы смежности
+        adj.EraseVertex(idx);
+
+        // Перестраиваем indexMap
+        indexMap.Rebuild(vertices, vertices.size());
+        Touch();
+    }
+
+    /// <summary>
+    /// Добавление или редактирование ребра 
+    /// Сложность: O(1)
+    /// </summary>
+    /// <param name="from">1 вершина</param>
+    /// <param name="to">2 вершина</param>
+    /// <param name="weight">Вес ребра</param>
+    /// <exception cref="runtime_error - одна из вершин не существует">
+    /// </exception>
+    void AddE(const T& from, const T& to, W weight) {
+
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            throw runtime_error("Одна из вершин не найдена");
+        if (journal.ptr)
+            journal.ptr->OnAddE(from, to, weight);
+
+        adj.Set(u, v, weight); // создаём или перезаписываем ребро из u в v
+
+        // ребро между уже достижимыми вершинами не меняет достижимость
+        auto kept = reach.Peek();
+        Touch();
+        if (kept && kept->CanReach(u, v))
+            reach.Set(kept);
+    }
+    
+    /// <summary>
+    /// Удаление ребра 
+    /// Сложность: O(1)
+    /// </summary>
+    /// <param name="from">1 веершина</param>
+    /// <param name="to">2 вершина</param>
+    /// <exception cref="runtime_error - одна из вершин не существует">
+    /// </exception>
+    void DeleteE(const T& from, const T& to) {
+
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0) // если одна из вершин не существует
+            throw runtime_error("Одна из вершин не найдена");
+        if (journal.ptr)
+            journal.ptr->OnDeleteE(from, to);
+
+        // удаление отсутствующего ребра граф не меняет
+        if (!adj.Has(u, v))
+            return;
+        adj.Reset(u, v); // перезаписываем ребро из u в v на значение бесконечности
+        Touch();
+    }
+
+    /// <summary>
+    /// Удаление всех вершин и рёбер
+    /// </summary>
+    void Clear() {
+        if (journal.ptr)
+            journal.ptr->OnClear();
+        vertices.clear();
+        adj.Clear();
+        indexMap.Clear();
+        Touch();
+    }
+
+    /// <summary>
+    /// Занимаемая память по составляющим
+    /// Сложность: O(V) для списков и матриц (по строке на вершину)
+    /// </summary>
+    GraphMemory MemoryUsage() const {
+        GraphMemory m;
+        m.keys = vertices.capacity() * sizeof(T);
+        m.index = indexMap.MemoryBytes();
+        StorageMemory sm = adj.Memory();
+        m.adjacency = sm.adjacency;
+        m.weights = sm.weights;
+        if (auto sh = shape.Peek())
+            m.caches += sizeof(Shape) + sh->topo.capacity() * sizeof(I);
+        if (auto r = reach.Peek())
+            m.caches += r->MemoryBytes();
+        m.slack = (vertices.capacity() - vertices.size()) * sizeof(T) + indexMap.SlackBytes() + sm.slack;
+        return m;
+    }
+
+    /// <summary>
+    /// Освобождение лишней памяти: ёмкость массива вершин и строк хранилища сокращается
+    /// до размера, индекс перестраивается под текущее число вершин (без удалённых слотов).
+    /// Содержимое, индексы вершин и кэши не меняются.
+    /// Сложность: O(V + память хранилища)
+    /// </summary>
+    void ShrinkToFit() {
+        vertices.shrink_to_fit();
+        adj.ShrinkToFit();
+        indexMap.ShrinkToFit(vertices);
+    }
+
+    /// <summary>
+    /// ShrinkToFit, если доля лишней памяти (MemoryUsage().Waste()) больше порога.
+    /// Удобно вызывать периодически после серий DeleteV / DeleteE.
+    /// </summary>
+    /// <param name="maxWaste">порог доли лишней памяти</param>
+    /// <returns>True - память сокращена</returns>
+    bool Compact(double maxWaste = 0.25) {
+        if (MemoryUsage().Waste() <= maxWaste)
+            return false;
+        ShrinkToFit();
+        return true;
+    }
+
+    /// <summary>
+    /// Вершина по внутреннему индексу
+    /// </summary>
+    /// <param name="i">индекс, 0 &lt;= i &lt; Size()</param>
+    const T& VertexAt(I i) const {
+        return vertices[i];
+    }
+
+    /// <summary>
+    /// Внутренний индекс вершины
+    /// </summary>
+    /// <param name="v">вершина</param>
+    /// <returns>индекс или -1, если вершины нет</returns>
+    I IndexOf(const T& v) const {
+        DGRAPH_COUNT_TOTAL(indexProbes, 1);
+        return indexMap.Find(v, vertices);
+    }
+
+    /// <summary>
+    /// Перебор исходящих рёбер вершины с индексом u: f(индекс соседа, вес)
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        adj.ForEachOut(u, f);
+    }
+
+    /// <summary>
+    /// Есть ли ребро между вершинами с индексами u -> v
+    /// </summary>
+    bool HasEdgeAt(I u, I v) const {
+        return adj.Has(u, v);
+    }
+
+    /// <summary>
+    /// Вес ребра u -> v по индексам; ребро должно существовать (HasEdgeAt)
+    /// </summary>
+    W EdgeAt(I u, I v) const {
+        return adj.Get(u, v);
+    }
+
+    /// <summary>
+    /// Обозначение "нет ребра" / недостижимой вершины
+    /// </summary>
+    const W& Inf() const {
+        return INF;
+    }
+
+    /// <summary>
+    /// Представление всего графа без копирования хранилища: далее Induced, Filter, Reverse,
+    /// обходы и Materialize. Граф должен жить дольше представления и не изменяться.
+    /// </summary>
+    GraphView<DGraph> View() const {
+        return GraphView<DGraph>(*this);
+    }
+
+    /// <summary>
+    /// Подключение журнала: далее каждое изменение графа (AddV, DeleteV, AddE, DeleteE, Clear)
+    /// передаётся журналу до применения. Журнал должен жить дольше подключения.
+    /// Копии графа журнал не наследуют.
+    /// </summary>
+    /// <param name="j">журнал (например, GraphJournal) или nullptr</param>
+    void AttachJournal(MutationObserver<T, W>* j) {
+        journal.ptr = j;
+    }
+
+    /// <summary>
+    /// Отключение журнала
+    /// </summary>
+    void DetachJournal() {
+        journal.ptr = nullptr;
+    }
+
+    /// <summary>
+    /// Применение пакета изменений (см. MutationBatch).
+    /// Каждый различный ключ пакета ищется один раз; изменения рёбер сортируются
+    /// по (источник, приёмник), повторы схлопываются (действует последняя операция),
+    /// и каждая затронутая строка хранилища обновляется за один проход слиянием.
+    /// При наличии пула строки обрабатываются параллельно (не передавайте пул, если
+    /// распределитель A не допускает одновременного выделения памяти, например
+    /// pmr::monotonic_buffer_resource). Кэши свойств сбрасываются один раз.
+    /// Пакет проверяется целиком до изменений: при ошибке граф не меняется.
+    /// Сложность: O(K + E_b log E_b + затронутые строки) для AdjacencyList
+    /// </summary>
+    /// <param name="batch">пакет изменений</param>
+    /// <param name="pool">пул потоков или nullptr</param>
+    /// <exception cref="runtime_error - добавляемая вершина уже существует, удаляемая вершина
+    /// или конец ребра не существует">
+    /// </exception>
+    void Apply(const MutationBatch<T, W>& batch, ThreadPool* pool = nullptr) {
+        const vector<T>& keys = batch.Keys();
+        size_t k = keys.size();
+
+        // индексы ключей в графе: один поиск на ключ
+        DGRAPH_COUNT_TOTAL(indexProbes, k);
+        vector<I> global(k);
+        for (size_t i = 0; i < k; ++i)
+            global[i] = indexMap.Find(keys[i], vertices);
+
+        // проверка пакета до изменений
+        vector<char> added(k, 0);
+        for (int64_t a : batch.VertexAdds()) {
+            if (global[a] >= 0 || added[a])
+                throw runtime_error("Apply: вершина уже существует");
+            added[a] = 1;
+        }
+        auto exists = [&](int64_t id) { return global[id] >= 0 || added[id]; };
+        for (int64_t d : batch.VertexDeletes())
+            if (!exists(d))
+                throw runtime_error("Apply: вершина не найдена");
+        for (const auto& op : batch.EdgeOps())
+            if (!exists(op.from) || !exists(op.to))
+                throw runtime_error("Apply: одна из вершин не найдена");
+
+        // новые вершины
+        for (int64_t a : batch.VertexAdds()) {
+            if (journal.ptr)
+                journal.ptr->OnAddV(keys[a]);
+            vertices.push_back(keys[a]);
+            global[a] = static_cast<I>(vertices.size() - 1);
+            indexMap.Insert(keys[a], global[a], vertices);
+            adj.AddVertex();
+        }
+
+        // изменения рёбер: сортировка с сохранением порядка повторов, затем последний побеждает
+        struct Change {
+            I from;
+            I to;
+            W w;
+            bool erase;
+        };
+        const auto& ops = batch.EdgeOps();
+        vector<Change> changes;
+        changes.reserve(ops.size());
+        for (const auto& op : ops)
+            changes.push_back(Change{ global[op.from], global[op.to], op.w, op.erase });
+        stable_sort(changes.begin(), changes.end(), [](const Change& a, const Change& b) {
+            return a.from != b.from ? a.from < b.from : a.to < b.to;
+        });
+        size_t m = 0;
+        for (size_t i = 0; i < changes.size(); ++i) {
+            if (m > 0 && changes[m - 1].from == changes[i].from && changes[m - 1].to == changes[i].to)
+                changes[m - 1] = changes[i];
+            else
+                changes[m++] = changes[i];
+        }
+        changes.resize(m);
+
+        if (journal.ptr)
+            for (const Change& c : changes) {
+                if (c.erase)
+                    journal.ptr->OnDeleteE(vertices[c.from], vertices[c.to]);
+                else
+                    journal.ptr->OnAddE(vertices[c.from], vertices[c.to], c.w);
+            }
+
+        // границы групп одного источника
+        vector<size_t> rows;
+        for (size_t i = 0; i < m; ++i)
+            if (i == 0 || changes[i].from != changes[i - 1].from)
+                rows.push_back(i);
+        rows.push_back(m);
+        auto mergeRow = [&](size_t r, unsigned) {
+            adj.MergeRow(changes[rows[r]].from, changes.begin() + rows[r], changes.begin() + rows[r + 1]);
+        };
+        if (pool && rows.size() > 2)
+            pool->ParallelFor(0, rows.size() - 1, 16, mergeRow);
+        else
+            for (size_t r = 0; r + 1 < rows.size(); ++r)
+                mergeRow(r, 0);
+
+        // удаление вершин: с конца, чтобы индексы не сдвигались, индекс перестраивается один раз
+        vector<I> doomed;
+        for (int64_t d : batch.VertexDeletes())
+            doomed.push_back(global[d]);
+        sort(doomed.begin(), doomed.end());
+        doomed.erase(unique(doomed.begin(), doomed.end()), doomed.end());
+        if (journal.ptr)
+            for (I d : doomed)
+                journal.ptr->OnDeleteV(vertices[d]);
+        for (auto it = doomed.rbegin(); it != doomed.rend(); ++it) {
+            vertices.erase(vertices.begin() + *it);
+            adj.EraseVertex(*it);
+        }
+        if (!doomed.empty())
+            indexMap.Rebuild(vertices, vertices.size());
+
+        Touch();
+    }
+
+    /// <summary>
+    /// Обход в ширину (BFS)
+    /// Сложность: O(V ^ 2)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <returns>Массив с значениями вершин</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> BFS(const T& start) const {
+        DGRAPH_SCOPE("BFS");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices); // индекс стартовой вершины
+        if (s < 0) // если начальная вершина не существует
+            throw runtime_error("BFS: начальная вершина не найдена");
+
+        I n = static_cast<I>(vertices.size());
+
+        Alloc<char> scratch(GetAllocator());
+        vector<char, Alloc<char>> visited(n, 0, scratch); // посещенные вершины
+        vector<char, Alloc<char>> in_queue(n, 0, scratch); // вершины в очереди
+        queue<I, deque<I, Alloc<I>>> q{ deque<I, Alloc<I>>(Alloc<I>(scratch)) };
+        vector<T> order;
+        DGRAPH_COUNT(scratchArrays, 4);
+
+        // Поместить стартовую вершину в очередь.
+        q.push(s);
+        in_queue[s] = 1;
+        DGRAPH_COUNT(queuePushes, 1);
+
+        while (!q.empty()) {
+
+            // Извлечь вершину, отметить как посещённую.
+            I u = q.front();
+            q.pop();
+
+            if (visited[u])
+                continue;
+
+            visited[u] = 1;
+            order.push_back(vertices[u]);
+
+            // Проверяем всех возможных соседей
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (!visited[v] && !in_queue[v]) {
+                    q.push(v);
+                    in_queue[v] = 1;
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Обход в глубину (DFS)
+    /// Сложность: O(V ^ 2)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <returns>Массив с значениями вершин</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> DFS(const T& start) const {
+        DGRAPH_SCOPE("DFS");
+        DGRAPH_COUNT(indexProbes, 1);
+
+        I s = indexMap.Find(start, vertices); // индекс стартовой вершины
+        if (s < 0) // Если начальная вершина не найдена
+            throw runtime_error("DFS: начальная вершина не найдена"); // Бросаем исключение ошибки времени выполнения
+
+        I n = static_cast<I>(vertices.size());
+
+        Alloc<char> scratch(GetAllocator());
+        vector<char, Alloc<char>> visited(n, 0, scratch); // посещенные вершины
+        vector<T> order;
+        stack<I, vector<I, Alloc<I>>> st{ vector<I, Alloc<I>>(Alloc<I>(scratch)) };
+        DGRAPH_COUNT(scratchArrays, 3);
+
+        st.push(s);
+        DGRAPH_COUNT(queuePushes, 1);
+
+        while (!st.empty()) {
+            I u = st.top();
+            st.pop();
+
+            if (visited[u])
+                continue;
+
+            visited[u] = 1;
+            order.push_back(vertices[u]);
+
+            // Добавляем всех соседей вершины u в стек
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (!visited[v]) {
+                    st.push(v);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+
+        return order;
+    }
+
+    /// <summary>
+    /// Алгоритм Форда-Беллмана для поиска кратчайшего пути от стартовой вершины ко всем остальным
+    /// Сложность:
+    /// пустой граф O(V ^ 2)
+    /// разреженный граф O(V* E)
+    /// плотный граф O(V ^ 3)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <returns>список длин кратчайших путей от стартовой вершины до всех остальных по порядку</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует или обнаруживается отрицательный цикл">
+    /// </exception>
+    vector<W> BellmanFord(const T& start) const {
+        DGRAPH_SCOPE("BellmanFord");
+        DGRAPH_COUNT(indexProbes, 1);
+
+        I s = indexMap.Find(start, vertices); // индекс стартовой вершины
+        if (s < 0) // Если вершина не существует
+            throw runtime_error("Вершина не найдена");
+
+        I n = static_cast<I>(vertices.size());
+
+        // Инициализация: все расстояния = INF, кроме стартовой (0)
+        vector<W> dist(n, INF);
+        dist[s] = 0;
+        DGRAPH_COUNT(scratchArrays, 1);
+
+        // Основной цикл 
+        // для каждого ребра u->v обновляем dist[v] = min(dist[v], dist[u] + w)
+        for (I k = 0; k < n - 1; ++k) {
+            for (I u = 0; u < n; ++u) {
+                DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+                if (dist[u] == INF)
+                    continue;
+                adj.ForEachOut(u, [&](I v, const W& w) {
+                    if (dist[v] > dist[u] + w) { // если существует более короткий путь в вершину v
+                        DGRAPH_COUNT(relaxations, 1);
+                        dist[v] = dist[u] + w; // перезаписываем длину кратчайшего пути в вершину v
+                    }
+                });
+            }
+        }
+
+        //  Проверка на отрицательные циклы 
+        for (I u = 0; u < n; ++u) {
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            if (dist[u] == INF)
+                continue;
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                // если после основного цикла остаются более короткие пути
+                if (dist[v] > dist[u] + w) {
+                    throw runtime_error("Обнаружен отрицательный цикл!");
+                }
+            });
+        }
+
+        return dist;
+    }
+
+    /// <summary>
+    /// Обход в ширину с отменой и крайним сроком.
+    /// ctl проверяется перед началом и по ходу обхода (через каждые CONTROL_STRIDE
+    /// просмотренных элементов строк); при остановке value - начало порядка BFS(start).
+    /// Сложность: как у BFS(start)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>порядок обхода и состояние (Done, Cancelled или Timeout)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    QueryResult<vector<T>> BFS(const T& start, const QueryControl& ctl) const {
+        DGRAPH_SCOPE("BFS");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("BFS: начальная вершина не найдена");
+        QueryResult<vector<T>> res;
+        res.status = ctl.Check();
+        if (res.status != QueryStatus::Done)
+            return res;
+
+        Alloc<char> scratch(GetAllocator());
+        vector<char, Alloc<char>> seen(vertices.size(), 0, scratch);
+        vector<I, Alloc<I>> q{ Alloc<I>(scratch) };
+        DGRAPH_COUNT(scratchArrays, 2);
+        q.push_back(s);
+        seen[s] = 1;
+        size_t work = 0;
+        for (size_t head = 0; head < q.size(); ++head) {
+            I u = q[head];
+            res.value.push_back(vertices[u]);
+            work += adj.ScanCost(u);
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    q.push_back(v);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+            if (work >= CONTROL_STRIDE) {
+                work = 0;
+                res.status = ctl.Check();
+                if (res.status != QueryStatus::Done)
+                    return res;
+            }
+        }
+        return res;
+    }
+
+    /// <summary>
+    /// Форд-Беллман с отменой и крайним сроком.
+    /// ctl проверяется перед началом и внутри проходов (через каждые CONTROL_STRIDE
+    /// просмотренных элементов строк), поэтому даже проход O(V ^ 2) плотного хранилища
+    /// прерывается быстро. Останавливается, когда проход ничего не улучшил.
+    /// При остановке value - текущие расстояния: каждое конечное значение - длина
+    /// некоторого пути, т.е. верхняя оценка кратчайшего.
+    /// Сложность: как у BellmanFord(start)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>расстояния по индексам вершин и состояние (Failed - отрицательный цикл)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    QueryResult<vector<W>> BellmanFord(const T& start, const QueryControl& ctl) const {
+        DGRAPH_SCOPE("BellmanFord");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("Вершина не найдена");
+        I n = static_cast<I>(vertices.size());
+        QueryResult<vector<W>> res;
+        vector<W>& dist = res.value;
+        dist.assign(n, INF);
+        dist[s] = 0;
+        DGRAPH_COUNT(scratchArrays, 1);
+        res.status = ctl.Check();
+        if (res.status != QueryStatus::Done)
+            return res;
+
+        size_t work = 0;
+        bool changed = true;
+        for (I k = 0; k < n && changed; ++k) {
+            changed = false;
+            for (I u = 0; u < n; ++u) {
+                work += adj.ScanCost(u);
+                if (work >= CONTROL_STRIDE) {
+                    work = 0;
+                    res.status = ctl.Check();
+                    if (res.status != QueryStatus::Done)
+                        return res;
+                }
+                DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+                if (dist[u] == INF)
+                    continue;
+                adj.ForEachOut(u, [&](I v, const W& w) {
+                    if (dist[v] > dist[u] + w) {
+                        DGRAPH_COUNT(relaxations, 1);
+                        dist[v] = dist[u] + w;
+                        changed = true;
+                    }
+                });
+            }
+        }
+        // улучшение на V-м проходе означает отрицательный цикл
+        if (changed)
+            res.status = QueryStatus::Failed;
+        return res;
+    }
+
+    /// <summary>
+    /// Асинхронный обход в ширину: BFS(start, ctl) выполняется на исполнителе.
+    /// Крайний срок в ctl абсолютный, поэтому время ожидания в очереди исполнителя
+    /// тоже учитывается. Граф и флаг отмены должны существовать, а граф - не изменяться
+    /// до получения результата.
+    /// </summary>
+    /// <typeparam name="Executor">исполнитель с методом Submit(function&lt;void()&gt;), например ThreadPool</typeparam>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="executor">исполнитель</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>future с результатом; отсутствие начальной вершины - исключение runtime_error из get()</returns>
+    template <typename Executor>
+    future<QueryResult<vector<T>>> BFSAsync(const T& start, Executor& executor,
+        const QueryControl& ctl = QueryControl()) const {
+        return RunAsync(executor, [this, start, ctl]() { return BFS(start, ctl); });
+    }
+
+    /// <summary>
+    /// Асинхронный Форд-Беллман: BellmanFord(start, ctl) выполняется на исполнителе
+    /// (условия те же, что у BFSAsync)
+    /// </summary>
+    /// <typeparam name="Executor">исполнитель с методом Submit(function&lt;void()&gt;), например ThreadPool</typeparam>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="executor">исполнитель</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>future с результатом; отсутствие начальной вершины - исключение runtime_error из get()</returns>
+    template <typename Executor>
+    future<QueryResult<vector<W>>> BellmanFordAsync(const T& start, Executor& executor,
+        const QueryControl& ctl = QueryControl()) const {
+        return RunAsync(executor, [this, start, ctl]() { return BellmanFord(start, ctl); });
+    }
+
+    /// <summary>
+    /// Обход в ширину с рабочей областью: без выделения памяти (после первого вызова)
+    /// и без O(V) очистки массивов. Порядок обхода совпадает с BFS(start).
+    /// Сложность: O(сумма длин строк достигнутых вершин)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ws">рабочая область; индексы вершин в порядке обхода - ws.Order()</param>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    void BFS(const T& start, TraversalWorkspace<W, I>& ws) const {
+        DGRAPH_SCOPE("BFS");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("BFS: начальная вершина не найдена");
+        if (ws.Begin(vertices.size()))
+            DGRAPH_COUNT(scratchArrays, 1);
+
+        vector<I>& q = ws.Frontier();
+        vector<I>& order = ws.OrderRef();
+        q.push_back(s);
+        ws.Enqueue(s);
+        DGRAPH_COUNT(queuePushes, 1);
+        for (size_t head = 0; head < q.size(); ++head) {
+            I u = q[head];
+            ws.Visit(u);
+            order.push_back(u);
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (!ws.Visited(v) && ws.Enqueue(v)) {
+                    q.push_back(v);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+    }
+
+    /// <summary>
+    /// Обход в ширину с рабочей областью и буфером результата
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ws">рабочая область</param>
+    /// <param name="out">значения вершин в порядке обхода (перезаписывается, ёмкость сохраняется)</param>
+    void BFS(const T& start, TraversalWorkspace<W, I>& ws, vector<T>& out) const {
+        BFS(start, ws);
+        out.clear();
+        for (I v : ws.Order())
+            out.push_back(vertices[v]);
+    }
+
+    /// <summary>
+    /// Обход в глубину с рабочей областью. Порядок обхода совпадает с DFS(start).
+    /// Сложность: O(сумма длин строк достигнутых вершин)
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ws">рабочая область; индексы вершин в порядке обхода - ws.Order()</param>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    void DFS(const T& start, TraversalWorkspace<W, I>& ws) const {
+        DGRAPH_SCOPE("DFS");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("DFS: начальная вершина не найдена");
+        if (ws.Begin(vertices.size()))
+            DGRAPH_COUNT(scratchArrays, 1);
+
+        vector<I>& st = ws.Frontier();
+        vector<I>& order = ws.OrderRef();
+        st.push_back(s);
+        DGRAPH_COUNT(queuePushes, 1);
+        while (!st.empty()) {
+            I u = st.back();
+            st.pop_back();
+            if (!ws.Visit(u))
+                continue;
+            order.push_back(u);
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W&) {
+                if (!ws.Visited(v)) {
+                    st.push_back(v);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+    }
+
+    /// <summary>
+    /// Обход в глубину с рабочей областью и буфером результата
+    /// </summary>
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ws">рабочая область</param>
+    /// <param name="out">значения вершин в порядке обхода (перезаписывается, ёмкость сохраняется)</param>
+    void DFS(const T& start, TraversalWorkspace<W, I>& ws, vector<T>& out) const {
+        DFS(start, ws);
+        out.clear();
+        for (I v : ws.Order())
+            out.push_back(vertices[v]);
+    }
+
+    /// <summary>
+    /// Кратчайшие пути от стартовой вершины с рабочей областью: релаксация через очередь
+    /// (вариант Форда-Беллмана, просматривающий только достигнутые вершины).
+    /// Результат: ws.Reached(v), ws.Dist(v), ws.Order(); расстояния совпадают с BellmanFord(start).
+    /// Отрицательный цикл обнаруживается по длине пути в V рёбер.
+    /// Сложность: O(V * E) в худшем случае, на практике близко к O(E) по достигнутой части
     /// </summary>
-    vector<T> vertices;
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="ws">рабочая область</param>
+    /// <exception cref="runtime_error - начальная вершина не существует или обнаруживается отрицательный цикл">
+    /// </exception>
+    void BellmanFord(const T& start, TraversalWorkspace<W, I>& ws) const {
+        DGRAPH_SCOPE("BellmanFord");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("Вершина не найдена");
+        I n = static_cast<I>(vertices.size());
+        if (ws.Begin(vertices.size()))
+            DGRAPH_COUNT(scratchArrays, 1);
+
+        vector<I>& q = ws.Frontier();
+        vector<I>& order = ws.OrderRef();
+        ws.Visit(s);
+        ws.DistRef(s) = W();
+        ws.Hops(s) = 0;
+        order.push_back(s);
+        q.push_back(s);
+        ws.Enqueue(s);
+        DGRAPH_COUNT(queuePushes, 1);
+        for (size_t head = 0; head < q.size(); ++head) {
+            // сдвиг очереди, чтобы она не росла с каждой повторной постановкой
+            if (head >= 1024 && head * 2 >= q.size()) {
+                q.erase(q.begin(), q.begin() + head);
+                head = 0;
+            }
+            I u = q[head];
+            ws.Dequeue(u);
+            W du = ws.DistRef(u);
+            I hu = ws.Hops(u);
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                W nd = du + w;
+                if (ws.Visit(v))
+                    order.push_back(v);
+                else if (!(ws.DistRef(v) > nd))
+                    return;
+                DGRAPH_COUNT(relaxations, 1);
+                ws.DistRef(v) = nd;
+                ws.Hops(v) = hu + 1;
+                if (ws.Hops(v) >= n)
+                    throw runtime_error("Обнаружен отрицательный цикл!");
+                if (ws.Enqueue(v)) {
+                    q.push_back(v);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+    }
 
     /// <summary>
-    ///  , adj[i][j] =  ,   i  j
+    /// Проверка отсутствия циклов (результат кэшируется до следующего изменения графа)
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList; повторно O(1)
     /// </summary>
-    vector<vector<W>> adj;
+    bool IsAcyclic() const {
+        return GetShape()->acyclic;
+    }
 
     /// <summary>
-    ///    
+    /// Топологическая сортировка (алгоритм Кана)
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList; повторно O(V)
     /// </summary>
-    unordered_map<T, int> indexMap;
+    /// <returns>вершины в порядке, при котором все рёбра идут вперёд</returns>
+    /// <exception cref="runtime_error - граф содержит цикл">
+    /// </exception>
+    vector<T> TopologicalSort() const {
+        DGRAPH_SCOPE("TopologicalSort");
+        auto sh = GetShape();
+        if (!sh->acyclic)
+            throw runtime_error("TopologicalSort: граф содержит цикл");
+        vector<T> order;
+        order.reserve(sh->topo.size());
+        DGRAPH_COUNT(scratchArrays, 1);
+        for (I v : sh->topo)
+            order.push_back(vertices[v]);
+        return order;
+    }
 
     /// <summary>
-    ///  " "
+    /// Кратчайшие пути в ациклическом графе: релаксация рёбер в топологическом порядке.
+    /// Допускает отрицательные веса.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
     /// </summary>
-    W INF;
-
-public:
+    /// <param name="start">Начальная вершина</param>
+    /// <returns>длины кратчайших путей по индексам вершин (INF - недостижима)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует или граф содержит цикл">
+    /// </exception>
+    vector<W> DagShortestPaths(const T& start) const {
+        DGRAPH_SCOPE("DagShortestPaths");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("DagShortestPaths: вершина не найдена");
+        auto sh = GetShape();
+        if (!sh->acyclic)
+            throw runtime_error("DagShortestPaths: граф содержит цикл");
+
+        vector<W> dist(vertices.size(), INF);
+        dist[s] = 0;
+        DGRAPH_COUNT(scratchArrays, 1);
+        for (I u : sh->topo) {
+            if (dist[u] == INF)
+                continue;
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                if (dist[v] > dist[u] + w) {
+                    DGRAPH_COUNT(relaxations, 1);
+                    dist[v] = dist[u] + w;
+                }
+            });
+        }
+        return dist;
+    }
 
     /// <summary>
-    ///   
+    /// Алгоритм Дейкстры на двоичной куче. Веса рёбер должны быть неотрицательными.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O((V + E) log V) для AdjacencyList
     /// </summary>
-    /// <param name="InVal"> " "</param>
-    DGraph(W InVal) : INF(InVal) {}
+    /// <param name="start">Начальная вершина</param>
+    /// <returns>длины кратчайших путей по индексам вершин (INF - недостижима)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует или есть ребро отрицательного веса">
+    /// </exception>
+    vector<W> Dijkstra(const T& start) const {
+        DGRAPH_SCOPE("Dijkstra");
+        DGRAPH_COUNT(indexProbes, 1);
+        I s = indexMap.Find(start, vertices);
+        if (s < 0)
+            throw runtime_error("Dijkstra: вершина не найдена");
+        if (!GetShape()->nonNegative)
+            throw runtime_error("Dijkstra: ребро отрицательного веса");
+
+        vector<W> dist(vertices.size(), INF);
+        vector<pair<W, I>> heap;
+        auto later = [](const pair<W, I>& a, const pair<W, I>& b) { return a.first > b.first; };
+        DGRAPH_COUNT(scratchArrays, 2);
+        dist[s] = 0;
+        heap.emplace_back(W(0), s);
+        DGRAPH_COUNT(queuePushes, 1);
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            W d = heap.back().first;
+            I u = heap.back().second;
+            heap.pop_back();
+            if (d > dist[u]) // устаревшая запись
+                continue;
+            DGRAPH_COUNT(edgesScanned, adj.ScanCost(u));
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                if (dist[v] > d + w) {
+                    DGRAPH_COUNT(relaxations, 1);
+                    dist[v] = d + w;
+                    heap.emplace_back(dist[v], v);
+                    push_heap(heap.begin(), heap.end(), later);
+                    DGRAPH_COUNT(queuePushes, 1);
+                }
+            });
+        }
+        return dist;
+    }
 
     /// <summary>
-    ///  
+    /// Предобработка ориентиров для AStar (см. LandmarkIndex).
+    /// Индекс соответствует графу на момент построения; после изменения графа его нужно построить заново.
+    /// Сложность: O(k * (V + E) log V) для AdjacencyList, O(k * V ^ 2) для плотных хранилищ
     /// </summary>
-    /// <returns>   </returns>
-    int Size() const {
-        return static_cast<int>(vertices.size());
+    /// <param name="k">число ориентиров</param>
+    /// <param name="sel">способ выбора ориентиров</param>
+    /// <param name="pool">пул потоков для расстояний от и до ориентиров или nullptr</param>
+    /// <param name="seed">зерно случайного выбора</param>
+    /// <exception cref="runtime_error - в графе есть ребро отрицательного веса">
+    /// </exception>
+    LandmarkIndex<W, I> Landmarks(size_t k, LandmarkSelection sel = LandmarkSelection::Avoid,
+        ThreadPool* pool = nullptr, uint32_t seed = 1) const {
+        DGRAPH_SCOPE("Landmarks");
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> weights;
+        BuildCsr(offsets, targets, &weights);
+        DGRAPH_COUNT(edgesScanned, targets.size());
+        return LandmarkIndex<W, I>(offsets, targets, weights, INF, k, sel, pool, seed);
     }
 
-    /// ,   
-
     /// <summary>
-    ///   
+    /// Кратчайший путь между двумя вершинами: A* с оценками ALT по ориентирам.
+    /// Просматривает вершины в порядке d(s, v) + h(v), где h - нижняя оценка d(v, t)
+    /// по неравенству треугольника; вершины, из которых цель заведомо недостижима, отбрасываются.
+    /// Веса должны быть неотрицательны.
+    /// Сложность: O((V + E) log V) в худшем случае, на практике - малая часть графа
     /// </summary>
-    /// <param name="v"> </param>
-    /// <returns>True - , False -  </returns>
-    bool HasVert(const T& v) const {
-        return indexMap.find(v) != indexMap.end();
+    /// <param name="from">начальная вершина</param>
+    /// <param name="to">конечная вершина</param>
+    /// <param name="landmarks">ориентиры, построенные Landmarks для текущего графа</param>
+    /// <param name="stats">если не nullptr, статистика запроса</param>
+    /// <param name="path">если не nullptr, вершины пути от from до to (пусто, если недостижима)</param>
+    /// <returns>длина кратчайшего пути или INF</returns>
+    /// <exception cref="runtime_error - вершина не существует, ребро отрицательного веса или ориентиры от другого графа">
+    /// </exception>
+    W AStar(const T& from, const T& to, const LandmarkIndex<W, I>& landmarks,
+        AStarStats* stats = nullptr, vector<T>* path = nullptr) const {
+        if (landmarks.Size() != vertices.size())
+            throw runtime_error("AStar: ориентиры построены для другого графа");
+        return AStarSearch(from, to, [&](I v, I t) { return landmarks.Bound(v, t); }, stats, path);
     }
 
-    /// ,      
-
     /// <summary>
-    ///      
+    /// Кратчайший путь между двумя вершинами без ориентиров (h = 0):
+    /// алгоритм Дейкстры с остановкой на цели
     /// </summary>
-    /// <param name="from">1 </param>
-    /// <param name="to">2 </param>
-    /// <returns>True - , False -  </returns>
-    bool HasEdge(const T& from, const T& to) const {
-        auto it1 = indexMap.find(from);
-        auto it2 = indexMap.find(to);
-        if (it1 == indexMap.end() || it2 == indexMap.end())
-            return false;
-        return adj[it1->second][it2->second] != INF;
+    /// <param name="from">начальная вершина</param>
+    /// <param name="to">конечная вершина</param>
+    /// <param name="stats">если не nullptr, статистика запроса</param>
+    /// <param name="path">если не nullptr, вершины пути от from до to</param>
+    /// <returns>длина кратчайшего пути или INF</returns>
+    W AStar(const T& from, const T& to, AStarStats* stats = nullptr, vector<T>* path = nullptr) const {
+        return AStarSearch(from, to, [](I, I) { return W(); }, stats, path);
     }
 
-
     /// <summary>
-    ///  
+    /// Предобработка иерархии сжатия для ShortestPath (см. ContractionHierarchy).
+    /// Иерархия соответствует графу на момент построения; после изменения графа её нужно построить заново.
+    /// Сложность: зависит от структуры графа; на дорожных графах близка к линейной, на сетках
+    /// и плотных графах верхние уровни иерархии становятся плотными и построение заметно дольше
     /// </summary>
-    /// <param name="from">1 </param>
-    /// <param name="to">2 </param>
-    /// <exception cref="runtime_error -       ">
+    /// <param name="pool">пул потоков для поисков свидетелей или nullptr</param>
+    /// <param name="opt">параметры построения</param>
+    /// <exception cref="runtime_error - в графе есть ребро отрицательного веса">
     /// </exception>
-    /// <returns>    </returns>
-    W GetEdge(const T& from, const T& to) const {
-        auto it1 = indexMap.find(from);
-        auto it2 = indexMap.find(to);
-        if (it1 == indexMap.end() || it2 == indexMap.end())
-            throw runtime_error("getEdge:   "); //     
-        W val = adj[it1->second][it2->second];
-        if (val == INF)
-            throw runtime_error("getEdge:   "); //     
-        return val;
+    ContractionHierarchy<W, I> Contract(ThreadPool* pool = nullptr, const ContractOptions& opt = ContractOptions()) const {
+        DGRAPH_SCOPE("Contract");
+        if (!GetShape()->nonNegative)
+            throw runtime_error("Contract: ребро отрицательного веса");
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> weights;
+        BuildCsr(offsets, targets, &weights);
+        DGRAPH_COUNT(edgesScanned, targets.size());
+        return ContractionHierarchy<W, I>(offsets, targets, weights, INF, pool, opt);
     }
 
-
     /// <summary>
-    ///  
-    /// : O(V ^ 2)
+    /// Кратчайший путь между двумя вершинами по иерархии сжатия:
+    /// двунаправленный поиск только по рёбрам к вершинам большего ранга,
+    /// сокращения в пути раскрываются до исходных рёбер графа.
+    /// Иерархия может быть построена Contract или загружена ContractionHierarchy::Load.
     /// </summary>
-    /// <param name="value"> </param>
-    /// <exception cref="runtime_error -   ">
+    /// <param name="from">начальная вершина</param>
+    /// <param name="to">конечная вершина</param>
+    /// <param name="ch">иерархия, построенная для текущего графа</param>
+    /// <param name="path">если не nullptr, вершины пути от from до to (пусто, если недостижима)</param>
+    /// <returns>длина кратчайшего пути или INF</returns>
+    /// <exception cref="runtime_error - вершина не существует или иерархия от другого графа">
     /// </exception>
-    void AddV(const T& value) {
-        if (indexMap.find(value) != indexMap.end()) { //   
-            throw runtime_error("  ");
+    W ShortestPath(const T& from, const T& to, const ContractionHierarchy<W, I>& ch, vector<T>* path = nullptr) const {
+        DGRAPH_SCOPE("ShortestPath");
+        DGRAPH_COUNT(indexProbes, 2);
+        if (ch.Size() != vertices.size())
+            throw runtime_error("ShortestPath: иерархия построена для другого графа");
+        I s = indexMap.Find(from, vertices);
+        I t = indexMap.Find(to, vertices);
+        if (s < 0 || t < 0)
+            throw runtime_error("ShortestPath: вершина не найдена");
+        vector<I> idx;
+        W d = ch.Query(s, t, path ? &idx : nullptr);
+        if (path) {
+            path->clear();
+            for (I v : idx)
+                path->push_back(vertices[v]);
         }
-
-        //        .
-        vertices.push_back(value);
-        indexMap[value] = vertices.size() - 1;
-
-        //   :     .
-
-        //   INF    
-        for (size_t i = 0; i < adj.size(); ++i) {
-            adj[i].push_back(INF);
-        }
-
-        //    ( INF)
-        adj.push_back(vector<W>(vertices.size(), INF));
+        return d == ch.Inf() ? INF : d;
     }
-    
+
     /// <summary>
-    ///  
-    /// : O(V^2)
+    /// Кратчайшие пути с выбором алгоритма по свойствам графа:
+    /// ацикличный - DagShortestPaths, неотрицательные веса - Dijkstra, иначе BellmanFord.
+    /// Свойства определяются один раз и кэшируются до следующего изменения графа.
     /// </summary>
-    /// <param name="value"> </param>
-    /// <exception cref="runtime_error -   ">
+    /// <param name="start">Начальная вершина</param>
+    /// <param name="used">если не nullptr, сюда записывается выбранный алгоритм</param>
+    /// <returns>длины кратчайших путей по индексам вершин (INF - недостижима)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует или обнаруживается отрицательный цикл">
     /// </exception>
-    void DeleteV(const T& value) {
-        if (indexMap.find(value) == indexMap.end()) { //    
-            throw runtime_error("  ");
-        }
-
-        int idx = indexMap[value];
+    vector<W> ShortestPathsAuto(const T& start, PathMethod* used = nullptr) const {
+        auto sh = GetShape();
+        PathMethod m = sh->acyclic ? PathMethod::Dag
+            : sh->nonNegative ? PathMethod::Dijkstra : PathMethod::BellmanFord;
+        if (used)
+            *used = m;
+        if (m == PathMethod::Dag)
+            return DagShortestPaths(start);
+        if (m == PathMethod::Dijkstra)
+            return Dijkstra(start);
+        return BellmanFord(start);
+    }
 
-        //   
-        vertices.erase(vertices.begin() + idx);
+    /// <summary>
+    /// Пакетный Форд-Беллман: расстояния от каждого источника, параллельно на пуле потоков.
+    /// Ошибка одного источника (нет вершины, отрицательный цикл) не прерывает пакет,
+    /// а отмечается в status; при отмене или истечении срока незавершённые строки
+    /// получают Cancelled / Timeout.
+    /// Сложность: O(k * V * E / потоки)
+    /// </summary>
+    /// <param name="sources">источники</param>
+    /// <param name="count">количество источников</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>матрица count x V расстояний (INF - недостижима)</returns>
+    BatchResult<W> BatchBellmanFord(const T* sources, size_t count, ThreadPool& pool,
+        const QueryControl& ctl = QueryControl()) const {
+        DGRAPH_SCOPE("BatchBellmanFord");
+        DGRAPH_COUNT(indexProbes, count);
+        DGRAPH_COUNT(scratchArrays, 2);
+        return RunBatch<W>(sources, count, pool, ctl, INF, [&](I s, W* row, unsigned) {
+            return RelaxFrom(s, row, ctl);
+        });
+    }
 
-        //      
-        adj.erase(adj.begin() + idx);
+    BatchResult<W> BatchBellmanFord(const vector<T>& sources, ThreadPool& pool,
+        const QueryControl& ctl = QueryControl()) const {
+        return BatchBellmanFord(sources.data(), sources.size(), pool, ctl);
+    }
 
-        //      
-        for (size_t i = 0; i < adj.size(); ++i)
-            adj[i].erase(adj[i].begin() + idx);
+    /// <summary>
+    /// Пакетный BFS: число рёбер кратчайшего пути от каждого источника, параллельно на пуле потоков.
+    /// У каждого потока своя очередь, переиспользуемая между источниками.
+    /// Сложность: O(k * V ^ 2 / потоки) для плотных хранилищ, O(k * (V + E) / потоки) для AdjacencyList
+    /// </summary>
+    /// <param name="sources">источники</param>
+    /// <param name="count">количество источников</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="ctl">отмена и крайний срок</param>
+    /// <returns>матрица count x V (-1 - недостижима)</returns>
+    BatchResult<int> BatchBFS(const T* sources, size_t count, ThreadPool& pool,
+        const QueryControl& ctl = QueryControl()) const {
+        DGRAPH_SCOPE("BatchBFS");
+        DGRAPH_COUNT(indexProbes, count);
+        DGRAPH_COUNT(scratchArrays, 2 + pool.Workers() + 1);
+        vector<vector<I>> queues(pool.Workers() + 1);
+        return RunBatch<int>(sources, count, pool, ctl, -1, [&](I s, int* row, unsigned slot) {
+            return HopsFrom(s, row, queues[slot], ctl);
+        });
+    }
 
-        //  indexMap
-        indexMap.clear();
-        for (size_t i = 0; i < vertices.size(); ++i)
-            indexMap[vertices[i]] = i;
+    BatchResult<int> BatchBFS(const vector<T>& sources, ThreadPool& pool,
+        const QueryControl& ctl = QueryControl()) const {
+        return BatchBFS(sources.data(), sources.size(), pool, ctl);
     }
 
     /// <summary>
-    ///     
-    /// : O(1)
+    /// Сжатие графа: неизменяемая копия, где соседи хранятся разностями в формате varint,
+    /// а веса - отдельным столбцом (точно, квантованно или не хранятся).
+    /// Индексы вершин сохраняются.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
     /// </summary>
-    /// <param name="from">1 </param>
-    /// <param name="to">2 </param>
-    /// <param name="weight"> </param>
-    /// <exception cref="runtime_error -     ">
-    /// </exception>
-    void AddE(const T& from, const T& to, W weight) {
+    /// <param name="opt">параметры сжатия</param>
+    /// <returns>сжатый граф для запросов BFS, DFS, GetNeighbors, GetWeight</returns>
+    CompressedDGraph<T, W, I> Compress(const CompressOptions& opt = CompressOptions()) const {
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> weights;
+        BuildCsr(offsets, targets, opt.weights == WeightMode::Dropped ? nullptr : &weights);
+        return CompressedDGraph<T, W, I>(vector<T>(vertices.begin(), vertices.end()),
+            offsets, targets, weights, opt);
+    }
 
-        if (indexMap.find(from) == indexMap.end() || indexMap.find(to) == indexMap.end())
-            throw runtime_error("    ");
+    /// <summary>
+    /// Сильно связные компоненты (итеративный алгоритм Тарьяна, без рекурсии)
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
+    /// </summary>
+    /// <returns>номер компоненты для каждого индекса вершины и размеры компонент</returns>
+    Components<I> StronglyConnectedComponents() const {
+        DGRAPH_SCOPE("StronglyConnectedComponents");
+        DGRAPH_COUNT(scratchArrays, 2);
+        vector<size_t> offsets;
+        vector<I> targets;
+        BuildCsr(offsets, targets);
+        DGRAPH_COUNT(edgesScanned, targets.size());
+        return SccTarjan(offsets, targets);
+    }
 
-        int u = indexMap[from];
-        int v = indexMap[to];
-        adj[u][v] = weight; //      u  v
+    /// <summary>
+    /// Сильно связные компоненты, параллельный алгоритм forward-backward для больших графов.
+    /// Результат совпадает с последовательным вариантом, включая нумерацию.
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    Components<I> StronglyConnectedComponents(ThreadPool& pool) const {
+        DGRAPH_SCOPE("StronglyConnectedComponents");
+        DGRAPH_COUNT(scratchArrays, 2);
+        vector<size_t> offsets;
+        vector<I> targets;
+        BuildCsr(offsets, targets);
+        DGRAPH_COUNT(edgesScanned, targets.size());
+        return SccForwardBackward(offsets, targets, pool);
     }
-    
+
     /// <summary>
-    ///   
-    /// : O(1)
+    /// Слабо связные компоненты (направление рёбер не учитывается),
+    /// система непересекающихся множеств без блокировок
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O((V + E) * alpha(V)) для AdjacencyList
     /// </summary>
-    /// <param name="from">1 </param>
-    /// <param name="to">2 </param>
-    /// <exception cref="runtime_error -     ">
-    /// </exception>
-    void DeleteE(const T& from, const T& to) {
+    /// <returns>номер компоненты для каждого индекса вершины и размеры компонент</returns>
+    Components<I> WeaklyConnectedComponents() const {
+        DGRAPH_SCOPE("WeaklyConnectedComponents");
+        return WccUnionFind<I>(vertices.size(), [this](I u, auto f) {
+            adj.ForEachOut(u, [&](I v, const W&) { f(v); });
+        });
+    }
 
-        if (indexMap.find(from) == indexMap.end() || indexMap.find(to) == indexMap.end()) //      
-            throw runtime_error("    ");
+    /// <summary>
+    /// Слабо связные компоненты, вершины обрабатываются параллельно на пуле потоков
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    Components<I> WeaklyConnectedComponents(ThreadPool& pool) const {
+        DGRAPH_SCOPE("WeaklyConnectedComponents");
+        return WccUnionFind<I>(vertices.size(), [this](I u, auto f) {
+            adj.ForEachOut(u, [&](I v, const W&) { f(v); });
+        }, &pool);
+    }
 
-        int u = indexMap[from];
-        int v = indexMap[to];
-        adj[u][v] = INF; //    u  v   
+    /// <summary>
+    /// Индекс достижимости (SCC-сжатие и замыкание или интервальная разметка).
+    /// Строится при первом обращении и хранится до изменения графа; добавление вершины
+    /// и ребра между уже достижимыми вершинами индекс сохраняют.
+    /// Сложность построения: O(V ^ 2) для плотных хранилищ, O(V + E + C ^ 2 / 64) для AdjacencyList
+    /// </summary>
+    /// <param name="pool">пул потоков для построения или nullptr</param>
+    /// <param name="opt">параметры индекса (учитываются при построении)</param>
+    shared_ptr<const ReachabilityIndex<I>> Reachability(ThreadPool* pool = nullptr,
+        const ReachOptions& opt = ReachOptions()) const {
+        return reach.Get([&]() {
+            DGRAPH_SCOPE("Reachability");
+            vector<size_t> offsets;
+            vector<I> targets;
+            BuildCsr(offsets, targets);
+            DGRAPH_COUNT(edgesScanned, targets.size());
+            return make_shared<const ReachabilityIndex<I>>(offsets, targets, pool, opt);
+        });
     }
 
     /// <summary>
-    ///    (BFS)
-    /// : O(V ^ 2)
+    /// Существует ли путь из from в to (вершина достижима из себя).
+    /// Использует индекс достижимости, при необходимости строя его.
+    /// Сложность: O(1) с замыканием; после построения индекса без обхода графа
     /// </summary>
-    /// <param name="start"> </param>
-    /// <returns>   </returns>
-    /// <exception cref="runtime_error -    ">
+    /// <param name="from">начальная вершина</param>
+    /// <param name="to">конечная вершина</param>
+    /// <exception cref="runtime_error - одна из вершин не существует">
     /// </exception>
-    vector<T> BFS(const T& start) const {
-        auto it = indexMap.find(start);
-        if (it == indexMap.end()) //     
-            throw runtime_error("BFS:    ");
-
-        int s = it->second; //   
-        int n = Size();
-
-        vector<char> visited(n, 0); //  
-        vector<char> in_queue(n, 0); //   
-        queue<int> q;
-        vector<T> order;
-
-        //     .
-        q.push(s);
-        in_queue[s] = 1;
-
-        while (!q.empty()) {
-
-            //  ,   .
-            int u = q.front();
-            q.pop();
-
-            if (visited[u])
-                continue;
+    bool CanReach(const T& from, const T& to) const {
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            throw runtime_error("CanReach: вершина не найдена");
+        return Reachability()->CanReach(u, v);
+    }
 
-            visited[u] = 1;
-            order.push_back(vertices[u]);
+    /// <summary>
+    /// Движок анализа (SpMV) по текущей смежности графа. Его можно построить один раз
+    /// и выполнить на нём несколько алгоритмов; изменения графа после построения не видны.
+    /// Сложность построения: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="weighted">учитывать веса рёбер (иначе все веса 1)</param>
+    SpmvEngine<I> Analytics(ThreadPool& pool, bool weighted = false) const {
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> ws;
+        BuildCsr(offsets, targets, weighted ? &ws : nullptr);
+        vector<double> values;
+        values.reserve(ws.size());
+        for (const W& w : ws)
+            values.push_back(AsDouble(w));
+        return SpmvEngine<I>(offsets, targets, weighted ? &values : nullptr, pool);
+    }
 
-            //    
-            for (int v = 0; v < n; ++v) {
-                if (adj[u][v] != INF && !visited[v] && !in_queue[v]) {
-                    q.push(v);
-                    in_queue[v] = 1;
-                }
-            }
-        }
-        return order;
+    /// <summary>
+    /// PageRank (без учёта весов)
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="opt">затухание, порог сходимости, число итераций</param>
+    /// <returns>ранги по индексам вершин</returns>
+    AnalyticsResult PageRank(ThreadPool& pool, const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        DGRAPH_SCOPE("PageRank");
+        return Analytics(pool).PageRank(opt);
     }
 
     /// <summary>
-    ///    (DFS)
-    /// : O(V ^ 2)
+    /// Персонализированный PageRank: телепортация равномерно на вершины seeds
     /// </summary>
-    /// <param name="start"> </param>
-    /// <returns>   </returns>
-    /// <exception cref="runtime_error -    ">
+    /// <param name="seeds">вершины персонализации</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="opt">затухание, порог сходимости, число итераций</param>
+    /// <returns>ранги по индексам вершин</returns>
+    /// <exception cref="runtime_error - одна из вершин не существует или seeds пуст">
     /// </exception>
-    vector<T> DFS(const T& start) const {
-
-        auto it = indexMap.find(start);
-        if (it == indexMap.end()) //     
-            throw runtime_error("DFS:    "); //     
-
-        int s = it->second; //   
-        int n = Size();
-
-        vector<char> visited(n, 0); //  
-        vector<T> order;
-        stack<int> st;
-
-        st.push(s);
-
-        while (!st.empty()) {
-            int u = st.top();
-            st.pop();
+    AnalyticsResult PersonalizedPageRank(const vector<T>& seeds, ThreadPool& pool,
+        const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        DGRAPH_SCOPE("PersonalizedPageRank");
+        DGRAPH_COUNT(indexProbes, seeds.size());
+        vector<double> teleport(vertices.size(), 0.0);
+        for (const T& v : seeds) {
+            I i = indexMap.Find(v, vertices);
+            if (i < 0)
+                throw runtime_error("PersonalizedPageRank: вершина не найдена");
+            teleport[i] = 1.0;
+        }
+        return Analytics(pool).PersonalizedPageRank(move(teleport), opt);
+    }
 
-            if (visited[u])
-                continue;
+    /// <summary>
+    /// Центральность Каца x = alpha * A^T x + beta (без учёта весов)
+    /// </summary>
+    /// <param name="alpha">затухание, меньше 1 / (наибольшее собственное число)</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="beta">базовая центральность</param>
+    /// <param name="opt">порог сходимости и число итераций (damping не используется)</param>
+    AnalyticsResult KatzCentrality(double alpha, ThreadPool& pool, double beta = 1.0,
+        const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        DGRAPH_SCOPE("KatzCentrality");
+        return Analytics(pool).Katz(alpha, beta, opt);
+    }
 
-            visited[u] = 1;
-            order.push_back(vertices[u]);
+    /// <summary>
+    /// Движок центральности по текущей смежности графа (см. CentralityEngine).
+    /// Его можно построить один раз и выполнить несколько расчётов; изменения графа после построения не видны.
+    /// Сложность построения: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="weighted">учитывать веса рёбер (Дейкстра), иначе длина пути - число рёбер</param>
+    /// <exception cref="runtime_error - weighted и в графе есть ребро неположительного веса">
+    /// </exception>
+    CentralityEngine<I> Centrality(ThreadPool& pool, bool weighted = false) const {
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> ws;
+        BuildCsr(offsets, targets, weighted ? &ws : nullptr);
+        vector<double> values;
+        values.reserve(ws.size());
+        for (const W& w : ws)
+            values.push_back(AsDouble(w));
+        return CentralityEngine<I>(move(offsets), move(targets), weighted ? &values : nullptr, pool);
+    }
 
-            //     u  
-            for (int v = 0; v < n; ++v) {
-                if (adj[u][v] != INF && !visited[v]) {
-                    st.push(v);
-                }
-            }
-        }
+    /// <summary>
+    /// Посредничество (алгоритм Брандеса), точно или по выборке источников
+    /// Сложность: O(V * E) без весов, O(V * E log V) с весами, делённое на число потоков
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="weighted">учитывать веса рёбер (должны быть положительны)</param>
+    /// <param name="opt">размер выборки или допустимая погрешность</param>
+    /// <returns>значения по индексам вершин</returns>
+    CentralityResult Betweenness(ThreadPool& pool, bool weighted = false,
+        const CentralityOptions& opt = CentralityOptions()) const {
+        DGRAPH_SCOPE("Betweenness");
+        return Centrality(pool, weighted).Betweenness(opt);
+    }
 
-        return order;
+    /// <summary>
+    /// Близость по исходящим расстояниям (Вассерман-Фауст), точно или по выборке
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="weighted">учитывать веса рёбер (должны быть положительны)</param>
+    /// <param name="opt">размер выборки или допустимая погрешность</param>
+    /// <returns>значения по индексам вершин</returns>
+    CentralityResult Closeness(ThreadPool& pool, bool weighted = false,
+        const CentralityOptions& opt = CentralityOptions()) const {
+        DGRAPH_SCOPE("Closeness");
+        return Centrality(pool, weighted).Closeness(opt);
     }
 
     /// <summary>
-    ///  -          
-    /// :
-    ///   O(V ^ 2)
-    ///   O(V* E)
-    ///   O(V ^ 3)
+    /// Гармоническая центральность по исходящим расстояниям, точно или по выборке
     /// </summary>
-    /// <param name="start"> </param>
-    /// <returns>           </returns>
-    /// <exception cref="runtime_error -        ">
-    /// </exception>
-    vector<W> BellmanFord(const T& start) const {
+    /// <param name="pool">пул потоков</param>
+    /// <param name="weighted">учитывать веса рёбер (должны быть положительны)</param>
+    /// <param name="opt">размер выборки или допустимая погрешность</param>
+    /// <returns>значения по индексам вершин</returns>
+    CentralityResult HarmonicCentrality(ThreadPool& pool, bool weighted = false,
+        const CentralityOptions& opt = CentralityOptions()) const {
+        DGRAPH_SCOPE("HarmonicCentrality");
+        return Centrality(pool, weighted).Harmonic(opt);
+    }
 
-        if (indexMap.find(start) == indexMap.end()) //    
-            throw runtime_error("  ");
+    /// <summary>
+    /// Движок подсчёта треугольников по текущей смежности (см. TriangleEngine):
+    /// упорядоченные строки с ориентацией по степени. Изменения графа после построения не видны.
+    /// Сложность построения: O(V ^ 2) для плотных хранилищ, O(V + E log E) для AdjacencyList
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="opt">векторное пересечение и порог битовой карты</param>
+    TriangleEngine<I> Triangles(ThreadPool& pool, const TriangleOptions& opt = TriangleOptions()) const {
+        vector<size_t> offsets;
+        vector<I> targets;
+        BuildCsr(offsets, targets);
+        return TriangleEngine<I>(offsets, targets, pool, opt);
+    }
 
-        int n = vertices.size();
-        int s = indexMap.at(start); //   
+    /// <summary>
+    /// Число треугольников (направление рёбер не учитывается)
+    /// Сложность: O(E * sqrt(E) / потоки) в худшем случае
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    uint64_t CountTriangles(ThreadPool& pool) const {
+        DGRAPH_SCOPE("CountTriangles");
+        return Triangles(pool).Count();
+    }
 
-        // :   = INF,   (0)
-        vector<W> dist(n, INF);
-        dist[s] = 0;
+    /// <summary>
+    /// Локальные коэффициенты кластеризации: доля связанных пар среди соседей вершины
+    /// (направление рёбер не учитывается)
+    /// Сложность: O(E * sqrt(E) / потоки) в худшем случае
+    /// </summary>
+    /// <param name="pool">пул потоков</param>
+    /// <returns>коэффициенты по индексам вершин</returns>
+    vector<double> ClusteringCoefficients(ThreadPool& pool) const {
+        DGRAPH_SCOPE("ClusteringCoefficients");
+        return Triangles(pool).Clustering();
+    }
 
-        //   
-        //    u->v  dist[v] = min(dist[v], dist[u] + w)
-        for (int k = 0; k < n - 1; ++k) {
-            for (int u = 0; u < n; ++u) {
-                for (int v = 0; v < n; ++v) {
-                    if (adj[u][v] != INF && dist[u] != INF) {
-                        if (dist[v] > dist[u] + adj[u][v]) { //        v
-                            dist[v] = dist[u] + adj[u][v]; //       v
-                        }
-                    }
-                }
-            }
+    /// <summary>
+    /// Перенумерация внутренних индексов вершин для локальности обращений к памяти:
+    /// вершины, соседние в графе, получают близкие индексы. Вершины, рёбра и поиск
+    /// по значению вершины не меняются, меняется только порядок индексов
+    /// (и, соответственно, порядок элементов в результатах по индексам).
+    /// Направление рёбер при упорядочивании не учитывается.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O((V + E) log V) для AdjacencyList
+    /// </summary>
+    /// <param name="strategy">способ упорядочивания</param>
+    /// <returns>новый индекс для каждого старого индекса вершины</returns>
+    vector<I> Reorder(ReorderStrategy strategy) {
+        DGRAPH_SCOPE("Reorder");
+        size_t n = vertices.size();
+        vector<size_t> offs, rOffs;
+        vector<I> targs, rTargs;
+        BuildCsr(offs, targs);
+        comp_detail::Reverse(offs, targs, rOffs, rTargs);
+        DGRAPH_COUNT(scratchArrays, 4);
+        DGRAPH_COUNT(edgesScanned, 2 * targs.size());
+
+        vector<size_t> degree(n);
+        for (size_t v = 0; v < n; ++v)
+            degree[v] = (offs[v + 1] - offs[v]) + (rOffs[v + 1] - rOffs[v]);
+
+        // соседи в обоих направлениях
+        auto forNeighbors = [&](I u, auto f) {
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                f(targs[e]);
+            for (size_t e = rOffs[u]; e < rOffs[u + 1]; ++e)
+                f(rTargs[e]);
+        };
+
+        vector<I> order; // order[новый] = старый
+        order.reserve(n);
+        if (strategy == ReorderStrategy::DegreeDescending) {
+            for (size_t v = 0; v < n; ++v)
+                order.push_back(static_cast<I>(v));
+            stable_sort(order.begin(), order.end(), [&](I a, I b) { return degree[a] > degree[b]; });
         }
-
-        //      
-        for (int u = 0; u < n; ++u) {
-            for (int v = 0; v < n; ++v) {
-                //        
-                if (adj[u][v] != INF && dist[u] != INF && dist[v] > dist[u] + adj[u][v]) {
-                    throw runtime_error("  !");
+        else {
+            bool rcm = strategy == ReorderStrategy::ReverseCuthillMcKee;
+            // корни компонент: RCM начинает с вершины наименьшей степени, BFS - с наибольшей
+            vector<I> roots(n);
+            for (size_t v = 0; v < n; ++v)
+                roots[v] = static_cast<I>(v);
+            stable_sort(roots.begin(), roots.end(), [&](I a, I b) {
+                return rcm ? degree[a] < degree[b] : degree[a] > degree[b];
+            });
+            vector<char> seen(n, 0);
+            vector<I> level;
+            for (I r : roots) {
+                if (seen[r])
+                    continue;
+                seen[r] = 1;
+                order.push_back(r);
+                for (size_t head = order.size() - 1; head < order.size(); ++head) {
+                    level.clear();
+                    forNeighbors(order[head], [&](I v) {
+                        if (!seen[v]) {
+                            seen[v] = 1;
+                            level.push_back(v);
+                        }
+                    });
+                    // Катхилл-Макки: новые соседи по возрастанию степени
+                    if (rcm)
+                        stable_sort(level.begin(), level.end(), [&](I a, I b) { return degree[a] < degree[b]; });
+                    order.insert(order.end(), level.begin(), level.end());
                 }
             }
+            if (rcm)
+                reverse(order.begin(), order.end());
         }
 
-        return dist;
+        vector<I> to(n);
+        for (size_t i = 0; i < n; ++i)
+            to[order[i]] = static_cast<I>(i);
+
+        vector<T, Alloc<T>> fresh(vertices.get_allocator());
+        fresh.reserve(n);
+        for (I old : order)
+            fresh.push_back(move(vertices[old]));
+        vertices.swap(fresh);
+        adj.Permute(to);
+        indexMap.Rebuild(vertices, vertices.size());
+        Touch();
+        return to;
     }
 
-    ///     
+    ///  Печать матрицы смежности 
 
     /// <summary>
-    ///    
+    /// Печать матрицы смежности 
     /// </summary>
     void printM() const {
-        cout << "\n  (INF =  ):\n";
+        cout << "\nМатрица смежности (INF = нет ребра):\n";
         cout << setw(8) << "";
         for (size_t i = 0; i < vertices.size(); ++i)
             cout << setw(8) << vertices[i];
@@ -357,8 +2383,8 @@ public:
         for (size_t i = 0; i < vertices.size(); ++i) {
             cout << setw(8) << vertices[i];
             for (size_t j = 0; j < vertices.size(); ++j) {
-                if (adj[i][j] == INF) cout << setw(8) << "INF";
-                else cout << setw(8) << adj[i][j];
+                if (!adj.Has(static_cast<I>(i), static_cast<I>(j))) cout << setw(8) << "INF";
+                else cout << setw(8) << adj.Get(static_cast<I>(i), static_cast<I>(j));
             }
             cout << endl;
         }
@@ -366,31 +2392,35 @@ public:
     }
 
     /// <summary>
-    ///    
-    /// : O(V)
+    /// Возвращает список соседей вершины
+    /// Сложность: O(V)
     /// </summary>
-    /// <param name="vertex"></param>
-    /// <returns> ,          </returns>
-    /// <exception cref="runtime_error -   ">
+    /// <param name="vertex">Вершина</param>
+    /// <returns>Массив вершин, с которыми у данной вершины есть связь в любом направлении</returns>
+    /// <exception cref="runtime_error - вершина не существует">
     /// </exception>
     vector<T> GetNeighbors(const T& vertex) const {
+        DGRAPH_SCOPE("GetNeighbors");
+        DGRAPH_COUNT(indexProbes, 1);
 
-        auto it = indexMap.find(vertex);
-        if (it == indexMap.end()) //    
-            throw runtime_error("GetNeighbors:   ");
+        I idx = indexMap.Find(vertex, vertices);
+        if (idx < 0) // если вершины не существует
+            throw runtime_error("GetNeighbors: вершина не найдена");
 
-        int idx = it->second;
         vector<T> neighbors;
+        DGRAPH_COUNT(scratchArrays, 1);
+        DGRAPH_COUNT(edgesScanned, 2 * vertices.size());
 
-        for (size_t j = 0; j < vertices.size(); ++j) {
+        I n = static_cast<I>(vertices.size());
+        for (I j = 0; j < n; ++j) {
 
-            //  
-            if (adj[idx][j] != INF) {
+            // исходящие рёбра
+            if (adj.Has(idx, j)) {
                 neighbors.push_back(vertices[j]);
             }
 
-            //  
-            else if (adj[j][idx] != INF) {
+            // входящие рёбра
+            else if (adj.Has(j, idx)) {
                 neighbors.push_back(vertices[j]);
             }
         }
@@ -398,40 +2428,69 @@ public:
     }
 
     /// <summary>
-    ///      
-    /// : O(1)
+    /// Получение веса ребра между двумя вершинами
+    /// Сложность: O(1)
     /// </summary>
-    /// <param name="from">1 </param>
-    /// <param name="to">2 </param>
-    /// <returns>    </returns>
-    /// <exception cref="runtime_error -         ">
+    /// <param name="from">1 вершина</param>
+    /// <param name="to">2 вершина</param>
+    /// <returns>вес ребра между двумя вершинами</returns>
+    /// <exception cref="runtime_error - одна из вершин не существует или ребро не существует">
     /// </exception>
     W GetWeight(const T& from, const T& to) const {
-        auto it1 = indexMap.find(from);
-        auto it2 = indexMap.find(to);
-        if (it1 == indexMap.end() || it2 == indexMap.end()) //        
-            throw runtime_error("GetWeight:   ");
+        DGRAPH_COUNT_TOTAL(indexProbes, 2);
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0) // если хотя бы одной из вершин не существует
+            throw runtime_error("GetWeight: вершина не найдена");
 
-        int u = it1->second;
-        int v = it2->second;
+        if (!adj.Has(u, v)) // если ребра не существует
+            throw runtime_error("GetWeight: ребро отсутствует");
 
-        if (adj[u][v] == INF) //    
-            throw runtime_error("GetWeight:  ");
-
-        return adj[u][v];
+        return adj.Get(u, v);
 
     }
     
     /// <summary>
-    ///      GraphML
+    /// Заморозка графа: построение неизменяемой копии в упакованном виде CSR
+    /// с теми же запросами (HasEdge, GetWeight, BFS, DFS, BellmanFord, GetNeighbors).
+    /// Индексы вершин сохраняются.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
+    /// </summary>
+    /// <returns>замороженный граф, который можно разделять между потоками без блокировок</returns>
+    FrozenDGraph<T, W, I> Freeze() const {
+        vector<size_t> offsets;
+        vector<I> targets;
+        vector<W> weights;
+        BuildCsr(offsets, targets, &weights);
+        return FrozenDGraph<T, W, I>(vector<T>(vertices.begin(), vertices.end()),
+            move(offsets), move(targets), move(weights), INF);
+    }
+
+    /// <summary>
+    /// Сохранение рёбер в двоичный файл для DiskGraph (внешняя память).
+    /// Вершины записываются своими индексами; значения вершин в файл не попадают.
+    /// Сложность: O(V ^ 2) для плотных хранилищ, O(V + E) для AdjacencyList
+    /// </summary>
+    /// <param name="filename">Имя файла для сохранения</param>
+    /// <exception cref="runtime_error - невозможно создать или записать файл">
+    /// </exception>
+    void SaveEdgeFile(const string& filename) const {
+        EdgeFileWriter<W, I> out(filename, vertices.size());
+        for (I u = 0; u < static_cast<I>(vertices.size()); ++u)
+            adj.ForEachOut(u, [&](I v, const W& w) { out.Add(u, v, w); });
+        out.Close();
+    }
+
+    /// <summary>
+    /// Сохранение графа в файл формата GraphML
     /// </summary>
-    /// <param name="filename">   </param>
-    /// <exception cref="runtime_error -   ">
+    /// <param name="filename">Имя файла для сохранения</param>
+    /// <exception cref="runtime_error - невозможно открыть файл">
     /// </exception>
     void saveGraphML(const string& filename) const {
         ofstream file(filename);
-        if (!file.is_open()) //    
-            throw runtime_error("     ");
+        if (!file.is_open()) // если файл не открывается
+            throw runtime_error("Не удалось открыть файл для записи");
 
         file << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n";
         file << "<graphml xmlns=\"http://graphml.graphdrawing.org/xmlns\"\n";
@@ -441,23 +2500,21 @@ public:
 
         file << "  <graph id=\"G\" edgedefault=\"directed\">\n";
 
-        // 
+        // Узлы
         for (size_t i = 0; i < vertices.size(); ++i) {
             file << "    <node id=\"n" << i << "\"";
             file << " name = " << "\"" << vertices[i] << "\"";
             file << "</node>\n";
         }
 
-        // и
-        for (size_t u = 0; u < vertices.size(); ++u) {
-            for (size_t v = 0; v < vertices.size(); ++v) {
-                if (adj[u][v] != INF) {
-                    file << "    <edge isDirected=\"true\" source=\"n" << u
-                        << "\" target=\"n" << v << "\"";
-                    file << " weight = " << "\"" << adj[u][v] << "\"";
-                    file << "</edge>\n";
-                }
-            }
+        // Рёбра
+        for (I u = 0; u < static_cast<I>(vertices.size()); ++u) {
+            adj.ForEachOut(u, [&](I v, const W& w) {
+                file << "    <edge isDirected=\"true\" source=\"n" << u
+                    << "\" target=\"n" << v << "\"";
+                file << " weight = " << "\"" << w << "\"";
+                file << "</edge>\n";
+            });
         }
         file << "  </graph>\n";
         file << "</graphml>\n";
@@ -465,53 +2522,51 @@ public:
     }
 
     /// <summary>
-    ///      GraphML
+    /// Загрузка графа из файла формата GraphML
     /// </summary>
-    /// <param name="filename">   </param>
-    /// <exception cref="runtime_error -       / ( weight    name  )">
+    /// <param name="filename">Имя файла для загрузки</param>
+    /// <exception cref="runtime_error - невозможно открыть файл или некорректная запись узлов/рёбер (отсутствует weight у ребра или name у узла)">
     /// </exception>
     void loadGraphML(const string& filename) {
         ifstream file(filename);
-        if (!file.is_open()) //    
-            throw runtime_error("     "); //     
+        if (!file.is_open()) // если файл не открывается
+            throw runtime_error("Не удалось открыть файл для чтения"); // Бросаем исключение ошибки времени выполнения
 
-        vertices.clear();
-        adj.clear();
-        indexMap.clear();
+        Clear();
 
         string line;
         unordered_map<string, int> xmlIdToIndex;
 
         while (getline(file, line)) {
 
-            //   
+            //  Узлы 
             if (line.find("<node") != string::npos) {
 
                 // id="n0"
                 size_t idPos = line.find("id=\"");
                 if (idPos == string::npos)
                     continue;
-                idPos += 4; //       id
+                idPos += 4; // теперь указывает на первый символ значения id
                 size_t idEnd = line.find("\"", idPos);
                 string xmlId = line.substr(idPos, idEnd - idPos);
 
                 // name="A"
                 size_t namePos = line.find("name=\"");
                 if (namePos == string::npos)
-                    throw runtime_error(": node  name");
+                    throw runtime_error("Ошибка: node без name");
 
                 namePos += 6;
                 size_t nameEnd = line.find("\"", namePos);
                 string value = line.substr(namePos, nameEnd - namePos);
 
-                //  
+                // Добавляем вершину
                 AddV(value);
                 xmlIdToIndex[xmlId] = vertices.size() - 1;
 
                 continue;
             }
 
-            //  и 
+            //  Рёбра 
             if (line.find("<edge") != string::npos) {
 
                 // source="n0"
@@ -533,18 +2588,18 @@ public:
                 // weight="5.5"
                 size_t wPos = line.find("weight=\"");
                 if (wPos == string::npos)
-                    throw runtime_error(": edge  weight");
+                    throw runtime_error("Ошибка: edge без weight");
 
                 wPos += 8;
                 size_t wEnd = line.find("\"", wPos);
                 string wStr = line.substr(wPos, wEnd - wPos);
 
-                //  
+                // Конвертация веса
                 W weight{};
                 stringstream ss(wStr);
                 ss >> weight;
 
-                // 
+                // Индексы
                 int u = xmlIdToIndex.at(xmlSource);
                 int v = xmlIdToIndex.at(xmlTarget);
 
@@ -556,46 +2611,177 @@ public:
 };
 
 /// <summary>
-///     (AddV, DeleteV, HasVert, size)
+/// Граф, размещающий всё в pmr::memory_resource (арене запроса и т.п.)
+/// </summary>
+template <typename T, typename W>
+using PmrDGraph = DGraph<T, W, pmr::polymorphic_allocator<char>>;
+
+/// <summary>
+/// Тестирование операций с вершинами (AddV, DeleteV, HasVert, size)
 /// </summary>
 void test_vertex_operations();
 
 /// <summary>
-///     (AddE, DeleteE, HasEdge, GetEdge)
+/// Тестирование операций с рёбрами (AddE, DeleteE, HasEdge, GetEdge)
 /// </summary>
 void test_edge_operations();
 
 /// <summary>
-///  BFS
+/// Тест BFS
 /// </summary>
 void test_bfs();
 
 /// <summary>
-///  DFS
+/// Тест DFS
 /// </summary>
 void test_dfs();
 
 /// <summary>
-///  BellmanFord
+/// Тест BellmanFord
 /// </summary>
 void test_bellman_ford();
 
 /// <summary>
-///  GetNeighbors
+/// Тест GetNeighbors
 /// </summary>
 void test_get_neighbors();
 
 /// <summary>
-///  GetWeight
+/// Тест GetWeight
 /// </summary>
 void test_get_weight();
 
 /// <summary>
-///  saveGraphML
+/// Тест saveGraphML
 /// </summary>
 void test_saveGraphML();
 
 /// <summary>
-///  loadGraphML
+/// Тест loadGraphML
+/// </summary>
+void test_loadGraphML();
+
+/// <summary>
+/// Тест генераторов графов (TGrGen.h)
+/// </summary>
+void test_generators();
+
+/// <summary>
+/// Тест счётчиков статистики (GetStats, ResetStats, SetTraceCallback)
+/// </summary>
+void test_stats();
+
+/// <summary>
+/// Тест графа с пользовательским распределителем памяти (PmrDGraph)
+/// </summary>
+void test_allocator();
+
+/// <summary>
+/// Тест плоского индекса вершин и интернирования строк (TGrIndex.h)
+/// </summary>
+void test_flat_index();
+
+/// <summary>
+/// Тест политик хранения DGraph (DenseSentinel, DenseBitmap, AdjacencyList, Unweighted, 64-битный индекс)
+/// </summary>
+void test_storage_policies();
+
+/// <summary>
+/// Тест одновременного чтения снимков и публикации изменений (SharedDGraph)
+/// </summary>
+void test_shared_graph();
+
+/// <summary>
+/// Тест замороженного графа (Freeze, FrozenDGraph)
+/// </summary>
+void test_freeze();
+
+/// <summary>
+/// Тест пакетных запросов
+/// </summary>
+void test_batch_queries();
+
+/// <summary>
+/// Тест сильно и слабо связных компонент
+/// </summary>
+void test_components();
+
+/// <summary>
+/// Тест топологической сортировки и кратчайших путей в ацикличном графе
+/// </summary>
+void test_dag_paths();
+
+/// <summary>
+/// Тест PageRank, персонализированного PageRank и центральности Каца
+/// </summary>
+void test_analytics();
+
+/// <summary>
+/// Тест перенумерации вершин
+/// </summary>
+void test_reorder();
+
+/// <summary>
+/// Тест графа во внешней памяти
+/// </summary>
+void test_disk_graph();
+
+/// <summary>
+/// Тест сжатого графа
+/// </summary>
+void test_compressed();
+
+/// <summary>
+/// Тест журнала изменений и восстановления
+/// </summary>
+void test_journal();
+
+/// <summary>
+/// Тест пакетного применения изменений
+/// </summary>
+void test_mutation_batch();
+
+/// <summary>
+/// Тест обходов с рабочей областью
+/// </summary>
+void test_workspace();
+
+/// <summary>
+/// Тест индекса достижимости
+/// </summary>
+void test_reachability();
+
+/// <summary>
+/// Тест ориентиров и поиска A*
+/// </summary>
+void test_astar();
+
+/// <summary>
+/// Тест иерархии сжатия: совпадение с Дейкстрой, раскрытие пути, сохранение и загрузка
+/// </summary>
+void test_ch();
+
+/// <summary>
+/// Тест асинхронных запросов: future, отмена, крайний срок, частичный результат
+/// </summary>
+void test_async_queries();
+
+/// <summary>
+/// Тест центральности: сравнение с полным перебором, выборочный режим
+/// </summary>
+void test_centrality();
+
+/// <summary>
+/// Тест треугольников и кластеризации: перебор, векторный и скалярный пути, битовая карта
+/// </summary>
+void test_triangles();
+
+/// <summary>
+/// Тест представлений графа: подграф по вершинам, фильтр рёбер, обращение и материализация
+/// </summary>
+void test_views();
+
+/// <summary>
+/// Тест учёта памяти и ShrinkToFit / Compact после удалений
 /// </summary>
-void test_loadGraphML();
\ No newline at end of file
+void test_memory_usage();
\ No newline at end of file
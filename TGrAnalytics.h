@@ -0,0 +1,389 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include "TGrPool.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#ifndef TGR_SSE2
+#define TGR_SSE2 1
+#endif
+#endif
+
+using namespace std;
+
+/// <summary>
+/// Параметры итерационных алгоритмов анализа (PageRank, Katz)
+/// </summary>
+struct AnalyticsOptions {
+    /// <summary>
+    /// коэффициент затухания PageRank
+    /// </summary>
+    double damping = 0.85;
+
+    /// <summary>
+    /// порог сходимости: сумма модулей изменений за итерацию
+    /// </summary>
+    double tolerance = 1e-9;
+
+    /// <summary>
+    /// предельное число итераций
+    /// </summary>
+    int maxIterations = 100;
+};
+
+/// <summary>
+/// Результат итерационного алгоритма
+/// </summary>
+struct AnalyticsResult {
+    /// <summary>
+    /// значения по индексам вершин
+    /// </summary>
+    vector<double> scores;
+
+    /// <summary>
+    /// выполнено итераций
+    /// </summary>
+    int iterations = 0;
+
+    /// <summary>
+    /// изменение на последней итерации
+    /// </summary>
+    double residual = 0;
+
+    /// <summary>
+    /// достигнут ли порог tolerance
+    /// </summary>
+    bool converged = false;
+
+    /// <summary>
+    /// время итераций, с
+    /// </summary>
+    double seconds = 0;
+
+    /// <summary>
+    /// рёбер в матрице
+    /// </summary>
+    size_t edges = 0;
+
+    /// <summary>
+    /// Пропускная способность: обработано рёбер в секунду
+    /// </summary>
+    double EdgesPerSecond() const {
+        return seconds > 0 ? static_cast<double>(edges) * iterations / seconds : 0.0;
+    }
+};
+
+namespace analytics_detail {
+
+    /// <summary>
+    /// y[i] = a[i] * b[i]
+    /// </summary>
+    inline void Mul(const double* a, const double* b, double* y, size_t n) {
+        size_t i = 0;
+#ifdef TGR_SSE2
+        for (; i + 2 <= n; i += 2)
+            _mm_storeu_pd(y + i, _mm_mul_pd(_mm_loadu_pd(a + i), _mm_loadu_pd(b + i)));
+#endif
+        for (; i < n; ++i)
+            y[i] = a[i] * b[i];
+    }
+
+    /// <summary>
+    /// y[i] = d * y[i] + c * t[i] (t == nullptr - t[i] = 1)
+    /// </summary>
+    /// <returns>сумма |y[i] - x[i]| после обновления</returns>
+    inline double Combine(double d, double c, const double* t, const double* x, double* y, size_t n) {
+        size_t i = 0;
+        double sum = 0;
+#ifdef TGR_SSE2
+        __m128d vd = _mm_set1_pd(d), vc = _mm_set1_pd(c), acc = _mm_setzero_pd();
+        const __m128d absMask = _mm_castsi128_pd(_mm_set1_epi64x(0x7fffffffffffffffLL));
+        for (; i + 2 <= n; i += 2) {
+            __m128d tc = t ? _mm_mul_pd(vc, _mm_loadu_pd(t + i)) : vc;
+            __m128d v = _mm_add_pd(_mm_mul_pd(vd, _mm_loadu_pd(y + i)), tc);
+            _mm_storeu_pd(y + i, v);
+            acc = _mm_add_pd(acc, _mm_and_pd(_mm_sub_pd(v, _mm_loadu_pd(x + i)), absMask));
+        }
+        double lanes[2];
+        _mm_storeu_pd(lanes, acc);
+        sum = lanes[0] + lanes[1];
+#endif
+        for (; i < n; ++i) {
+            y[i] = d * y[i] + c * (t ? t[i] : 1.0);
+            sum += fabs(y[i] - x[i]);
+        }
+        return sum;
+    }
+}
+
+/// <summary>
+/// Движок разреженного умножения матрицы на вектор (SpMV) по смежности графа.
+/// Хранит транспонированную матрицу (входящие рёбра) и считает y = A^T x "вытягиванием":
+/// каждая строка y[v] - сумма по входящим рёбрам, поэтому потоки не пишут в общие ячейки.
+/// Строки разбиты на части с примерно равным числом рёбер, части выполняются на пуле потоков.
+/// Суммы по частям складываются в фиксированном порядке, результат не зависит от числа потоков.
+/// </summary>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename I>
+class SpmvEngine {
+private:
+
+    /// <summary>
+    /// начала строк входящих рёбер, размер V + 1
+    /// </summary>
+    vector<size_t> inOffsets;
+
+    /// <summary>
+    /// источники входящих рёбер
+    /// </summary>
+    vector<I> sources;
+
+    /// <summary>
+    /// веса входящих рёбер (пусто - все веса 1)
+    /// </summary>
+    vector<double> values;
+
+    /// <summary>
+    /// 1 / (сумма весов исходящих рёбер), 0 для висячих вершин
+    /// </summary>
+    vector<double> invOut;
+
+    /// <summary>
+    /// границы частей по строкам
+    /// </summary>
+    vector<size_t> parts;
+
+    ThreadPool& pool;
+
+    /// <summary>
+    /// Строка произведения: сумма x[u] * w(u, v) по входящим рёбрам v, четыре независимых сумматора
+    /// </summary>
+    double Row(size_t v, const double* x) const {
+        size_t e = inOffsets[v], end = inOffsets[v + 1];
+        const I* src = sources.data();
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        if (values.empty()) {
+            for (; e + 4 <= end; e += 4) {
+                s0 += x[src[e]];
+                s1 += x[src[e + 1]];
+                s2 += x[src[e + 2]];
+                s3 += x[src[e + 3]];
+            }
+            for (; e < end; ++e)
+                s0 += x[src[e]];
+        }
+        else {
+            const double* w = values.data();
+            for (; e + 4 <= end; e += 4) {
+                s0 += x[src[e]] * w[e];
+                s1 += x[src[e + 1]] * w[e + 1];
+                s2 += x[src[e + 2]] * w[e + 2];
+                s3 += x[src[e + 3]] * w[e + 3];
+            }
+            for (; e < end; ++e)
+                s0 += x[src[e]] * w[e];
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+    /// <summary>
+    /// Степенной метод x = d * A^T (x * scale) + c * t.
+    /// pagerank - нормированный вариант: масса висячих вершин раздаётся по t.
+    /// </summary>
+    AnalyticsResult Power(bool pagerank, double d, double c, const vector<double>* tele,
+        const AnalyticsOptions& opt) const {
+        size_t n = Rows();
+        AnalyticsResult res;
+        res.edges = Edges();
+        if (n == 0) {
+            res.converged = true;
+            return res;
+        }
+
+        const double* t = tele ? tele->data() : nullptr;
+        vector<double> x(n), y(n), next(n);
+        if (pagerank) {
+            for (size_t v = 0; v < n; ++v)
+                x[v] = t ? t[v] : 1.0 / static_cast<double>(n);
+        }
+        size_t P = parts.size() - 1;
+        vector<double> dangling(P), residual(P);
+
+        auto started = chrono::steady_clock::now();
+        for (int it = 0; it < opt.maxIterations; ++it) {
+            double cIt = c;
+            const double* in = x.data();
+            if (pagerank) {
+                // масштабирование по исходящей степени и масса висячих вершин
+                pool.ParallelFor(0, P, 1, [&](size_t p, unsigned) {
+                    size_t lo = parts[p], hi = parts[p + 1];
+                    analytics_detail::Mul(x.data() + lo, invOut.data() + lo, y.data() + lo, hi - lo);
+                    double sum = 0;
+                    for (size_t u = lo; u < hi; ++u)
+                        if (invOut[u] == 0)
+                            sum += x[u];
+                    dangling[p] = sum;
+                });
+                double lost = 0;
+                for (double s : dangling)
+                    lost += s;
+                cIt = d * lost + c;
+                if (!t)
+                    cIt /= static_cast<double>(n);
+                in = y.data();
+            }
+
+            pool.ParallelFor(0, P, 1, [&](size_t p, unsigned) {
+                size_t lo = parts[p], hi = parts[p + 1];
+                for (size_t v = lo; v < hi; ++v)
+                    next[v] = Row(v, in);
+                residual[p] = analytics_detail::Combine(d, cIt, t ? t + lo : nullptr,
+                    x.data() + lo, next.data() + lo, hi - lo);
+            });
+
+            double r = 0;
+            for (double s : residual)
+                r += s;
+            x.swap(next);
+            res.iterations = it + 1;
+            res.residual = r;
+            if (r < opt.tolerance) {
+                res.converged = true;
+                break;
+            }
+        }
+        res.seconds = chrono::duration<double>(chrono::steady_clock::now() - started).count();
+        res.scores = move(x);
+        return res;
+    }
+
+public:
+
+    /// <summary>
+    /// Построение по исходящему CSR: приёмники вершины u - targs[offs[u] .. offs[u + 1])
+    /// </summary>
+    /// <param name="offs">начала строк, размер V + 1</param>
+    /// <param name="targs">приёмники</param>
+    /// <param name="weights">веса рёбер параллельно targs (nullptr - все веса 1)</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="partsPerWorker">частей на поток (больше - лучше балансировка)</param>
+    SpmvEngine(const vector<size_t>& offs, const vector<I>& targs, const vector<double>* weights,
+        ThreadPool& pool, unsigned partsPerWorker = 4) : pool(pool) {
+        size_t n = offs.size() - 1;
+
+        // транспонирование подсчётом
+        inOffsets.assign(n + 1, 0);
+        for (I v : targs)
+            ++inOffsets[v + 1];
+        for (size_t i = 0; i < n; ++i)
+            inOffsets[i + 1] += inOffsets[i];
+        sources.resize(targs.size());
+        if (weights)
+            values.resize(targs.size());
+        invOut.assign(n, 0.0);
+        vector<size_t> pos(inOffsets.begin(), inOffsets.end() - 1);
+        for (size_t u = 0; u < n; ++u) {
+            double out = 0;
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e) {
+                size_t k = pos[targs[e]]++;
+                sources[k] = static_cast<I>(u);
+                double w = weights ? (*weights)[e] : 1.0;
+                if (weights)
+                    values[k] = w;
+                out += w;
+            }
+            if (out != 0)
+                invOut[u] = 1.0 / out;
+        }
+
+        // части с примерно равной стоимостью (входящие рёбра + строка)
+        size_t P = max<size_t>(1, min<size_t>(n, static_cast<size_t>(pool.Workers()) * max(1u, partsPerWorker)));
+        size_t total = sources.size() + n;
+        parts.push_back(0);
+        size_t v = 0;
+        for (size_t p = 1; p < P; ++p) {
+            size_t goal = total * p / P;
+            while (v < n && inOffsets[v] + v < goal)
+                ++v;
+            if (v > parts.back())
+                parts.push_back(v);
+        }
+        parts.push_back(n);
+    }
+
+    /// <summary>
+    /// Количество строк (вершин)
+    /// </summary>
+    size_t Rows() const {
+        return inOffsets.size() - 1;
+    }
+
+    /// <summary>
+    /// Количество рёбер
+    /// </summary>
+    size_t Edges() const {
+        return sources.size();
+    }
+
+    /// <summary>
+    /// Количество частей, на которые разбиты строки
+    /// </summary>
+    size_t Partitions() const {
+        return parts.size() - 1;
+    }
+
+    /// <summary>
+    /// Произведение y = A^T x: y[v] = сумма w(u, v) * x[u] по рёбрам u->v
+    /// Сложность: O(V + E) / потоки
+    /// </summary>
+    void Multiply(const vector<double>& x, vector<double>& y) const {
+        if (x.size() != Rows())
+            throw runtime_error("Multiply: неверный размер вектора");
+        y.resize(Rows());
+        pool.ParallelFor(0, Partitions(), 1, [&](size_t p, unsigned) {
+            for (size_t v = parts[p]; v < parts[p + 1]; ++v)
+                y[v] = Row(v, x.data());
+        });
+    }
+
+    /// <summary>
+    /// PageRank (при заданных весах - взвешенный: переход пропорционален весу ребра).
+    /// Масса висячих вершин распределяется равномерно.
+    /// </summary>
+    /// <returns>ранги по индексам вершин, сумма равна 1</returns>
+    AnalyticsResult PageRank(const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        return Power(true, opt.damping, 1.0 - opt.damping, nullptr, opt);
+    }
+
+    /// <summary>
+    /// Персонализированный PageRank: телепортация и масса висячих вершин
+    /// распределяются по вектору teleport (нормируется на сумму)
+    /// </summary>
+    /// <exception cref="runtime_error - неверный размер teleport или нулевая сумма">
+    /// </exception>
+    AnalyticsResult PersonalizedPageRank(vector<double> teleport, const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        if (teleport.size() != Rows())
+            throw runtime_error("PersonalizedPageRank: неверный размер вектора");
+        double sum = 0;
+        for (double p : teleport)
+            sum += p;
+        if (!(sum > 0))
+            throw runtime_error("PersonalizedPageRank: пустой вектор телепортации");
+        for (double& p : teleport)
+            p /= sum;
+        return Power(true, opt.damping, 1.0 - opt.damping, &teleport, opt);
+    }
+
+    /// <summary>
+    /// Центральность Каца: x = alpha * A^T x + beta. Сходится при alpha меньше
+    /// 1 / (наибольшее собственное число A); иначе converged = false.
+    /// </summary>
+    AnalyticsResult Katz(double alpha, double beta = 1.0, const AnalyticsOptions& opt = AnalyticsOptions()) const {
+        return Power(false, alpha, beta, nullptr, opt);
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include "TGrIndex.h"
+
+using namespace std;
+
+/// <summary>
+/// Пакет изменений графа для DGraph::Apply.
+/// Вершины пакета хранятся один раз (локальная нумерация через FlatIndex),
+/// рёбра - парами локальных номеров, поэтому при применении каждый различный
+/// ключ ищется в графе один раз, а не дважды на каждое ребро.
+///
+/// Порядок применения: сначала добавляются вершины, затем меняются рёбра
+/// (для одного ребра действует последняя операция пакета), затем удаляются вершины.
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+template <typename T, typename W>
+class MutationBatch {
+public:
+
+    /// <summary>
+    /// Изменение ребра в локальных номерах пакета
+    /// </summary>
+    struct EdgeOp {
+        int64_t from;
+        int64_t to;
+        W w;
+        bool erase;
+    };
+
+    /// <summary>
+    /// Добавление вершины
+    /// </summary>
+    void AddV(const T& v) {
+        adds.push_back(Intern(v));
+    }
+
+    /// <summary>
+    /// Удаление вершины (вместе с её рёбрами)
+    /// </summary>
+    void DeleteV(const T& v) {
+        deletes.push_back(Intern(v));
+    }
+
+    /// <summary>
+    /// Добавление ребра или изменение веса существующего
+    /// </summary>
+    void AddE(const T& from, const T& to, W weight) {
+        int64_t a = Intern(from);
+        int64_t b = Intern(to);
+        edges.push_back(EdgeOp{ a, b, weight, false });
+    }
+
+    /// <summary>
+    /// Удаление ребра (отсутствующее ребро не ошибка, как в DGraph::DeleteE)
+    /// </summary>
+    void DeleteE(const T& from, const T& to) {
+        int64_t a = Intern(from);
+        int64_t b = Intern(to);
+        edges.push_back(EdgeOp{ a, b, W(), true });
+    }
+
+    /// <summary>
+    /// Резервирование памяти под ожидаемое число рёбер
+    /// </summary>
+    void Reserve(size_t edgeOps) {
+        edges.reserve(edgeOps);
+    }
+
+    /// <summary>
+    /// Очистка пакета для повторного использования
+    /// </summary>
+    void Clear() {
+        keys.clear();
+        index.Clear();
+        adds.clear();
+        deletes.clear();
+        edges.clear();
+    }
+
+    /// <summary>
+    /// Пакет не содержит операций
+    /// </summary>
+    bool Empty() const {
+        return adds.empty() && deletes.empty() && edges.empty();
+    }
+
+    /// <summary>
+    /// Различные вершины, упомянутые в пакете; локальный номер - индекс в массиве
+    /// </summary>
+    const vector<T>& Keys() const {
+        return keys;
+    }
+
+    /// <summary>
+    /// Локальные номера добавляемых вершин
+    /// </summary>
+    const vector<int64_t>& VertexAdds() const {
+        return adds;
+    }
+
+    /// <summary>
+    /// Локальные номера удаляемых вершин
+    /// </summary>
+    const vector<int64_t>& VertexDeletes() const {
+        return deletes;
+    }
+
+    /// <summary>
+    /// Операции с рёбрами в порядке добавления
+    /// </summary>
+    const vector<EdgeOp>& EdgeOps() const {
+        return edges;
+    }
+
+private:
+    vector<T> keys;
+    FlatIndex<T, int64_t> index;
+    vector<int64_t> adds;
+    vector<int64_t> deletes;
+    vector<EdgeOp> edges;
+
+    int64_t Intern(const T& v) {
+        int64_t id = index.Find(v, keys);
+        if (id < 0) {
+            id = static_cast<int64_t>(keys.size());
+            keys.push_back(v);
+            index.Insert(v, id, keys);
+        }
+        return id;
+    }
+};
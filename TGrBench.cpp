@@ -0,0 +1,563 @@
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include "TGr.h"
+#include "TGrGen.h"
+#include "TGrBench.h"
+
+using namespace std;
+
+/// <summary>
+/// Исходящий CSR по упорядоченному списку рёбер (для графов, которые не помещаются в матрицу)
+/// </summary>
+template <typename W>
+static void bench_csr(int n, const vector<GenEdge<W>>& edges, vector<size_t>& offs, vector<int>& targs) {
+    offs.assign(static_cast<size_t>(n) + 1, 0);
+    targs.clear();
+    targs.reserve(edges.size());
+    for (const auto& e : edges) {
+        ++offs[e.from + 1];
+        targs.push_back(e.to);
+    }
+    for (int i = 0; i < n; ++i)
+        offs[i + 1] += offs[i];
+}
+
+/// <summary>
+/// Набор чисел потоков для замеров: 1, 2, 4, ... до числа ядер
+/// </summary>
+static vector<unsigned> bench_threads() {
+    unsigned hw = max(1u, thread::hardware_concurrency());
+    vector<unsigned> ts;
+    for (unsigned t = 1; t < hw; t *= 2)
+        ts.push_back(t);
+    ts.push_back(hw);
+    return ts;
+}
+
+void bench_pagerank() {
+    const int SCALE = 18, FACTOR = 16;
+    GenOptions opt;
+    opt.seed = 1;
+    auto edges = GenRMAT<double>(SCALE, FACTOR, 0.57, 0.19, 0.19, GenWeights<double>(), opt);
+    GenSortUnique(edges);
+    vector<size_t> offs;
+    vector<int> targs;
+    bench_csr(1 << SCALE, edges, offs, targs);
+
+    cout << "PageRank, R-MAT scale " << SCALE << ": V = " << (1 << SCALE)
+        << ", E = " << targs.size() << "\n";
+    cout << setw(8) << "threads" << setw(12) << "iters" << setw(14) << "ms/iter" << setw(16) << "Medges/s" << "\n";
+    AnalyticsOptions ao;
+    ao.tolerance = 1e-10;
+    ao.maxIterations = 30;
+    for (unsigned t : bench_threads()) {
+        ThreadPool pool(t);
+        SpmvEngine<int> eng(offs, targs, nullptr, pool);
+        auto r = eng.PageRank(ao);
+        cout << setw(8) << t << setw(12) << r.iterations
+            << setw(14) << fixed << setprecision(2) << r.seconds * 1000.0 / r.iterations
+            << setw(16) << r.EdgesPerSecond() / 1e6 << "\n";
+    }
+    cout << endl;
+}
+
+/// <summary>
+/// приёмник результатов замеров, чтобы компилятор не выбрасывал измеряемый код
+/// </summary>
+static volatile double bench_sink = 0;
+
+/// <summary>
+/// Время выполнения f, мс
+/// </summary>
+template <typename F>
+static double bench_ms(F f) {
+    auto t0 = chrono::steady_clock::now();
+    f();
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+}
+
+/// <summary>
+/// Сетка rows x cols со случайной нумерацией вершин в списках смежности
+/// </summary>
+static DGraph<int, double, allocator<char>, AdjacencyList> bench_shuffled_grid(int rows, int cols) {
+    int n = rows * cols;
+    GenOptions opt;
+    opt.seed = 2;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 10;
+    auto edges = GenGrid(rows, cols, true, ws, opt);
+    vector<int> label(n);
+    for (int i = 0; i < n; ++i)
+        label[i] = i;
+    mt19937 rng(2);
+    shuffle(label.begin(), label.end(), rng);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(1e18);
+    for (int i = 0; i < n; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(label[e.from], label[e.to], e.weight);
+    return g;
+}
+
+void bench_reorder() {
+    const int BFS_SIDE = 400, BF_SIDE = 80, RUNS = 5;
+    auto big = bench_shuffled_grid(BFS_SIDE, BFS_SIDE);
+    auto small = bench_shuffled_grid(BF_SIDE, BF_SIDE);
+
+    cout << "Reorder: BFS on " << BFS_SIDE << "x" << BFS_SIDE << " grid, BellmanFord on "
+        << BF_SIDE << "x" << BF_SIDE << " grid (AdjacencyList, shuffled ids)\n";
+    cout << setw(22) << "order" << setw(14) << "BFS ms" << setw(18) << "BellmanFord ms" << "\n";
+
+    const char* names[] = { "insertion (shuffled)", "RCM", "degree-descending", "BFS order" };
+    for (int k = 0; k < 4; ++k) {
+        auto b = big;
+        auto s = small;
+        if (k > 0) {
+            ReorderStrategy st = k == 1 ? ReorderStrategy::ReverseCuthillMcKee
+                : k == 2 ? ReorderStrategy::DegreeDescending : ReorderStrategy::BfsOrder;
+            b.Reorder(st);
+            s.Reorder(st);
+        }
+        double bfs = 0, bf = 0;
+        for (int r = 0; r < RUNS; ++r) {
+            bfs += bench_ms([&]() { b.BFS(r); });
+            bf += bench_ms([&]() { s.BellmanFord(r); });
+        }
+        cout << setw(22) << names[k] << setw(14) << fixed << setprecision(2) << bfs / RUNS
+            << setw(18) << bf / RUNS << "\n";
+    }
+    cout << endl;
+}
+
+/// <summary>
+/// Замороженный граф с тем же интерфейсом обхода строк, что у CompressedDGraph
+/// </summary>
+struct FrozenScan {
+    const FrozenDGraph<int, double>& f;
+    void BFS(int s) const {
+        f.BFS(s);
+    }
+    template <typename F>
+    void ForEachOut(int u, F fn) const {
+        const double* w = f.OutWeights(u);
+        for (const int* v = f.OutBegin(u); v != f.OutEnd(u); ++v, ++w)
+            fn(*v, *w);
+    }
+};
+
+void bench_compression() {
+    const int SCALE = 16, FACTOR = 16, RUNS = 5;
+    GenOptions opt;
+    opt.seed = 3;
+    GenWeights<double> ws;
+    ws.minW = 1;
+    ws.maxW = 100;
+    auto edges = GenRMAT<double>(SCALE, FACTOR, 0.57, 0.19, 0.19, ws, opt);
+    GenSortUnique(edges);
+    int n = 1 << SCALE;
+    DGraph<int, double, allocator<char>, AdjacencyList> g(1e18);
+    for (int i = 0; i < n; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    g.Reorder(ReorderStrategy::BfsOrder);
+
+    cout << "Compression, R-MAT scale " << SCALE << ": V = " << n << ", E = " << edges.size() << "\n";
+    cout << setw(28) << "layout" << setw(12) << "MB" << setw(14) << "bytes/edge"
+        << setw(12) << "BFS ms" << setw(16) << "scan Medges/s" << "\n";
+
+    auto report = [&](const char* name, size_t bytes, auto& graph) {
+        double bfs = 0, scan = 0;
+        for (int r = 0; r < RUNS; ++r) {
+            bfs += bench_ms([&]() { graph.BFS(r); });
+            double sum = 0;
+            scan += bench_ms([&]() {
+                for (int u = 0; u < n; ++u)
+                    graph.ForEachOut(u, [&](int v, double w) { sum += w + v; });
+                bench_sink = sum;
+            });
+        }
+        cout << setw(28) << name << setw(12) << fixed << setprecision(2) << bytes / 1048576.0
+            << setw(14) << static_cast<double>(bytes) / edges.size() << setw(12) << bfs / RUNS
+            << setw(16) << edges.size() * RUNS / (scan / 1000.0) / 1e6 << "\n";
+    };
+
+    // несжатый CSR с обратными рёбрами
+    auto frozen = g.Freeze();
+    FrozenScan fs{ frozen };
+    report("CSR (Freeze)", frozen.MemoryBytes(), fs);
+
+    CompressOptions exact;
+    auto c1 = g.Compress(exact);
+    report("varint + exact weights", c1.MemoryBytes(), c1);
+
+    CompressOptions quant;
+    quant.weights = WeightMode::Quantized;
+    auto c2 = g.Compress(quant);
+    report("varint + 16-bit weights", c2.MemoryBytes(), c2);
+
+    CompressOptions bare;
+    bare.weights = WeightMode::Dropped;
+    bare.reverse = false;
+    auto c3 = g.Compress(bare);
+    report("varint, no weights/reverse", c3.MemoryBytes(), c3);
+    cout << endl;
+}
+
+/// <summary>
+/// Граф из цепочек длины len: каждый обход достигает не более len вершин
+/// </summary>
+static DGraph<int, double, allocator<char>, AdjacencyList> bench_chains(int n, int len) {
+    DGraph<int, double, allocator<char>, AdjacencyList> g(1e18);
+    for (int i = 0; i < n; ++i)
+        g.AddV(i);
+    for (int i = 0; i + 1 < n; ++i)
+        if ((i + 1) % len != 0)
+            g.AddE(i, i + 1, 1.0 + i % 7);
+    return g;
+}
+
+void bench_workspace() {
+    const int BFS_N = 1000000, BF_N = 3000, LEN = 16, BFS_Q = 2000, BF_Q = 50;
+    auto big = bench_chains(BFS_N, LEN);
+    auto small = bench_chains(BF_N, LEN);
+    mt19937 rng(3);
+
+    cout << "Workspace: " << BFS_Q << " BFS on V = " << BFS_N << ", " << BF_Q
+        << " BellmanFord on V = " << BF_N << " (chains of " << LEN << ")\n";
+    cout << setw(22) << "" << setw(14) << "BFS us/q" << setw(20) << "BellmanFord us/q" << "\n";
+
+    vector<int> src(BFS_Q);
+    for (int& s : src)
+        s = static_cast<int>(rng() % BFS_N);
+    double bfs = bench_ms([&]() {
+        for (int s : src)
+            bench_sink = bench_sink + big.BFS(s).size();
+    });
+    // тот же алгоритм с очередью, но новая рабочая область (новые массивы) на каждый запрос
+    double bf = bench_ms([&]() {
+        for (int q = 0; q < BF_Q; ++q) {
+            TraversalWorkspace<double> fresh;
+            small.BellmanFord(src[q] % BF_N, fresh);
+            bench_sink = bench_sink + fresh.Order().size();
+        }
+    });
+    cout << setw(22) << "fresh arrays" << setw(14) << fixed << setprecision(2) << bfs * 1000.0 / BFS_Q
+        << setw(20) << bf * 1000.0 / BF_Q << "\n";
+
+    TraversalWorkspace<double> ws;
+    vector<int> out;
+    bfs = bench_ms([&]() {
+        for (int s : src) {
+            big.BFS(s, ws, out);
+            bench_sink = bench_sink + out.size();
+        }
+    });
+    bf = bench_ms([&]() {
+        for (int q = 0; q < BF_Q; ++q) {
+            small.BellmanFord(src[q] % BF_N, ws);
+            bench_sink = bench_sink + ws.Order().size();
+        }
+    });
+    cout << setw(22) << "TraversalWorkspace" << setw(14) << fixed << setprecision(2) << bfs * 1000.0 / BFS_Q
+        << setw(20) << bf * 1000.0 / BF_Q << "\n";
+
+    // для сравнения: другой алгоритм - BellmanFord(start), V - 1 полных проходов по всем рёбрам
+    bf = bench_ms([&]() {
+        for (int q = 0; q < BF_Q; ++q)
+            bench_sink = bench_sink + small.BellmanFord(src[q] % BF_N)[0];
+    });
+    cout << setw(22) << "full passes (algo)" << setw(14) << "-" << setw(20) << fixed << setprecision(2)
+        << bf * 1000.0 / BF_Q << "\n";
+    cout << endl;
+}
+
+void bench_astar() {
+    const int SIDE = 300, QUERIES = 200;
+    auto g = bench_shuffled_grid(SIDE, SIDE);
+    int n = SIDE * SIDE;
+    mt19937 rng(4);
+    vector<pair<int, int>> qs(QUERIES);
+    for (auto& q : qs)
+        q = make_pair(static_cast<int>(rng() % n), static_cast<int>(rng() % n));
+    ThreadPool pool(max(1u, thread::hardware_concurrency()));
+
+    cout << "AStar: " << QUERIES << " queries on " << SIDE << "x" << SIDE << " grid (AdjacencyList)\n";
+    cout << setw(16) << "landmarks" << setw(12) << "MB" << setw(14) << "build ms"
+        << setw(16) << "settled/q" << setw(12) << "us/q" << "\n";
+    for (size_t k : { 0, 2, 4, 8, 16 }) {
+        size_t settled = 0;
+        double build = 0, mb = 0, ms;
+        if (k == 0) {
+            ms = bench_ms([&]() {
+                for (const auto& q : qs) {
+                    AStarStats st;
+                    bench_sink = bench_sink + g.AStar(q.first, q.second, &st);
+                    settled += st.settled;
+                }
+            });
+        }
+        else {
+            unique_ptr<LandmarkIndex<double, int>> lm;
+            build = bench_ms([&]() {
+                lm.reset(new LandmarkIndex<double, int>(g.Landmarks(k, LandmarkSelection::Avoid, &pool)));
+            });
+            mb = lm->MemoryBytes() / 1048576.0;
+            ms = bench_ms([&]() {
+                for (const auto& q : qs) {
+                    AStarStats st;
+                    bench_sink = bench_sink + g.AStar(q.first, q.second, *lm, &st);
+                    settled += st.settled;
+                }
+            });
+        }
+        cout << setw(16) << (k == 0 ? string("none (Dijkstra)") : to_string(k))
+            << setw(12) << fixed << setprecision(2) << mb << setw(14) << build
+            << setw(16) << settled / QUERIES << setw(12) << ms * 1000.0 / QUERIES << "\n";
+    }
+    cout << endl;
+}
+
+void bench_ch() {
+    const int SIDE = 120, QUERIES = 200;
+    auto g = bench_shuffled_grid(SIDE, SIDE);
+    int n = SIDE * SIDE;
+    mt19937 rng(5);
+    vector<pair<int, int>> qs(QUERIES);
+    for (auto& q : qs)
+        q = make_pair(static_cast<int>(rng() % n), static_cast<int>(rng() % n));
+    ThreadPool pool(max(1u, thread::hardware_concurrency()));
+
+    cout << "Contraction hierarchy: " << QUERIES << " queries on " << SIDE << "x" << SIDE << " grid (AdjacencyList)\n";
+    cout << setw(22) << "method" << setw(12) << "MB" << setw(14) << "build ms" << setw(12) << "us/q" << "\n";
+    unique_ptr<LandmarkIndex<double, int>> lm;
+    double build = bench_ms([&]() {
+        lm.reset(new LandmarkIndex<double, int>(g.Landmarks(16, LandmarkSelection::Avoid, &pool)));
+    });
+    double ms = bench_ms([&]() {
+        for (const auto& q : qs)
+            bench_sink = bench_sink + g.AStar(q.first, q.second, *lm);
+    });
+    cout << setw(22) << "AStar, 16 landmarks" << setw(12) << fixed << setprecision(2) << lm->MemoryBytes() / 1048576.0
+        << setw(14) << build << setw(12) << ms * 1000.0 / QUERIES << "\n";
+
+    unique_ptr<ContractionHierarchy<double, int>> ch;
+    build = bench_ms([&]() {
+        ch.reset(new ContractionHierarchy<double, int>(g.Contract(&pool)));
+    });
+    ms = bench_ms([&]() {
+        for (const auto& q : qs)
+            bench_sink = bench_sink + g.ShortestPath(q.first, q.second, *ch);
+    });
+    cout << setw(22) << "ShortestPath (CH)" << setw(12) << fixed << setprecision(2) << ch->MemoryBytes() / 1048576.0
+        << setw(14) << build << setw(12) << ms * 1000.0 / QUERIES << "\n";
+    cout << setw(22) << "shortcuts" << setw(12) << ch->ShortcutCount() << "\n";
+    cout << endl;
+}
+
+void bench_centrality() {
+    const int N = 5000;
+    GenOptions opt;
+    opt.seed = 7;
+    auto g = GenBuild(N, GenBarabasiAlbert(N, 4, GenWeights<double>(), opt), 1e18);
+    ThreadPool pool(max(1u, thread::hardware_concurrency()));
+
+    cout << "Centrality: Barabasi-Albert graph, " << N << " vertices, " << pool.Workers() << " threads\n";
+    cout << setw(26) << "method" << setw(12) << "sources" << setw(12) << "ms" << setw(16) << "max rel. error" << "\n";
+    vector<int> all(N);
+    for (int i = 0; i < N; ++i)
+        all[i] = i;
+    double batch = bench_ms([&]() {
+        bench_sink = bench_sink + g.BatchBFS(all, pool).data.size();
+    });
+    cout << setw(26) << "BatchBFS from every vertex" << setw(12) << N << setw(12) << fixed << setprecision(1) << batch << "\n";
+
+    auto engine = g.Centrality(pool);
+    CentralityResult exact;
+    double ms = bench_ms([&]() {
+        exact = engine.Betweenness();
+    });
+    double top = *max_element(exact.scores.begin(), exact.scores.end());
+    cout << setw(26) << "Betweenness exact" << setw(12) << exact.sources << setw(12) << ms << "\n";
+    for (double eps : { 0.05, 0.1 }) {
+        CentralityOptions o;
+        o.epsilon = eps;
+        CentralityResult est;
+        ms = bench_ms([&]() {
+            est = engine.Betweenness(o);
+        });
+        double err = 0;
+        for (int v = 0; v < N; ++v)
+            err = max(err, fabs(est.scores[v] - exact.scores[v]) / top);
+        cout << setw(20) << "Betweenness eps=" << setw(6) << setprecision(2) << eps << setw(12) << est.sources
+            << setw(12) << setprecision(1) << ms << setw(16) << setprecision(4) << err << "\n";
+    }
+    ms = bench_ms([&]() {
+        bench_sink = bench_sink + engine.Closeness().scores.size();
+    });
+    cout << setw(26) << "Closeness exact" << setw(12) << N << setw(12) << setprecision(1) << ms << "\n";
+    cout << endl;
+}
+
+void bench_triangles() {
+    ThreadPool pool(max(1u, thread::hardware_concurrency()));
+    GenOptions opt;
+    opt.seed = 8;
+    struct Case {
+        string name;
+        int n;
+        vector<GenEdge<double>> edges;
+    };
+    vector<Case> cases;
+    cases.push_back({ "R-MAT scale 14, ef 16", 1 << 14, GenRMAT(14, 16, 0.57, 0.19, 0.19, GenWeights<double>(), opt) });
+    cases.push_back({ "Barabasi-Albert 20000, m 8", 20000, GenBarabasiAlbert(20000, 8, GenWeights<double>(), opt) });
+
+    cout << "Triangles: power-law graphs, " << pool.Workers() << " threads\n";
+    cout << setw(28) << "graph" << setw(12) << "triangles" << setw(16) << "GetNeighbors ms"
+        << setw(12) << "build ms" << setw(12) << "scalar ms" << setw(12) << "SSE2 ms" << "\n";
+    for (const Case& c : cases) {
+        DGraph<int, double, allocator<char>, AdjacencyList> g(1e18);
+        for (int i = 0; i < c.n; ++i)
+            g.AddV(i);
+        for (const auto& e : c.edges)
+            g.AddE(e.from, e.to, e.weight);
+
+        // прежний способ: копии соседей, сортировка каждой копии, пересечение
+        uint64_t naive = 0;
+        double slow = bench_ms([&]() {
+            vector<vector<int>> nb(c.n);
+            for (int u = 0; u < c.n; ++u) {
+                nb[u] = g.GetNeighbors(u);
+                sort(nb[u].begin(), nb[u].end());
+                nb[u].erase(unique(nb[u].begin(), nb[u].end()), nb[u].end());
+                nb[u].erase(remove(nb[u].begin(), nb[u].end(), u), nb[u].end());
+            }
+            for (int u = 0; u < c.n; ++u)
+                for (int v : nb[u])
+                    if (v > u)
+                        for (int w : nb[v])
+                            if (w > v && binary_search(nb[u].begin(), nb[u].end(), w))
+                                ++naive;
+        });
+
+        unique_ptr<TriangleEngine<int>> scalar, simd;
+        TriangleOptions so;
+        so.simd = false;
+        double build = bench_ms([&]() {
+            simd.reset(new TriangleEngine<int>(g.Triangles(pool)));
+        });
+        scalar.reset(new TriangleEngine<int>(g.Triangles(pool, so)));
+        uint64_t a = 0, b = 0;
+        double ms1 = bench_ms([&]() {
+            a = scalar->Count();
+        });
+        double ms2 = bench_ms([&]() {
+            b = simd->Count();
+        });
+        bench_sink = bench_sink + (a == b && a == naive);
+        cout << setw(28) << c.name << setw(12) << b << setw(16) << fixed << setprecision(1) << slow
+            << setw(12) << build << setw(12) << ms1 << setw(12) << ms2 << "\n";
+    }
+    cout << endl;
+}
+
+void bench_views() {
+    const int N = 1 << 15;
+    GenOptions opt;
+    opt.seed = 9;
+    auto edges = GenRMAT(15, 8, 0.57, 0.19, 0.19, GenWeights<double>(), opt);
+    DGraph<int, double, allocator<char>, AdjacencyList> g(1e18);
+    for (int i = 0; i < N; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    vector<int> keep;
+    for (int i = 0; i < N; ++i)
+        if (i % 4 != 3)
+            keep.push_back(i);
+
+    cout << "Views: R-MAT scale 15, ef 8, induced subgraph of 3/4 vertices\n";
+    cout << setw(28) << "method" << setw(12) << "build ms" << setw(12) << "BFS ms" << setw(12) << "visited" << "\n";
+    auto row = [](const string& name, double build, double bfs, size_t visited) {
+        cout << setw(28) << name << setw(12) << fixed << setprecision(1) << build << setw(12) << bfs
+            << setw(12) << visited << "\n";
+    };
+
+    // прежний способ: копия подграфа вставками
+    DGraph<int, double, allocator<char>, AdjacencyList> copy(1e18);
+    double build = bench_ms([&]() {
+        for (int v : keep)
+            copy.AddV(v);
+        for (const auto& e : edges)
+            if (e.from % 4 != 3 && e.to % 4 != 3)
+                copy.AddE(e.from, e.to, e.weight);
+    });
+    size_t visited = 0;
+    double bfs = bench_ms([&]() {
+        visited = copy.BFS(0).size();
+    });
+    row("copy (AddV/AddE)", build, bfs, visited);
+
+    GraphView<DGraph<int, double, allocator<char>, AdjacencyList>> view(g);
+    build = bench_ms([&]() {
+        view = g.View().Induced(keep);
+    });
+    bfs = bench_ms([&]() {
+        visited = view.BFS(0).size();
+    });
+    row("view", build, bfs, visited);
+
+    DGraph<int, double, allocator<char>, AdjacencyList> m(1e18);
+    build = bench_ms([&]() {
+        m = view.Materialize();
+    });
+    bfs = bench_ms([&]() {
+        visited = m.BFS(0).size();
+    });
+    row("view.Materialize()", build, bfs, visited);
+
+    auto rev = view.Reverse();
+    bfs = bench_ms([&]() {
+        visited = rev.BFS(0).size();
+    });
+    row("view.Reverse()", 0.0, bfs, visited);
+    cout << endl;
+}
+
+template <typename G>
+static void bench_memory_case(const string& name, int n) {
+    G g(1e18);
+    for (int i = 0; i < n; ++i)
+        g.AddV(i);
+    for (int i = 0; i < n; ++i)
+        for (int j = 1; j <= 16; ++j)
+            g.AddE(i, (i * 31 + j * 7) % n, j);
+    size_t full = g.MemoryUsage().Total();
+    for (int i = n - 1; i >= 0; --i)
+        if (i % 4 != 0)
+            g.DeleteV(i);
+    GraphMemory before = g.MemoryUsage();
+    double ms = bench_ms([&]() {
+        g.Compact();
+    });
+    GraphMemory after = g.MemoryUsage();
+    cout << setw(28) << name << setw(12) << full / 1024 << setw(12) << before.Total() / 1024
+        << setw(10) << fixed << setprecision(2) << before.Waste() << setw(12) << after.Total() / 1024
+        << setw(12) << setprecision(1) << ms << "\n";
+}
+
+void bench_memory() {
+    cout << "Memory: delete 3/4 of vertices, then Compact()\n";
+    cout << setw(28) << "storage" << setw(12) << "full KB" << setw(12) << "deleted KB" << setw(10) << "waste"
+        << setw(12) << "compact KB" << setw(12) << "compact ms" << "\n";
+    bench_memory_case<DGraph<int, double>>("DenseSentinel, 2000", 2000);
+    bench_memory_case<DGraph<int, double, allocator<char>, DenseBitmap>>("DenseBitmap, 2000", 2000);
+    bench_memory_case<DGraph<int, double, allocator<char>, AdjacencyList>>("AdjacencyList, 20000", 20000);
+    cout << endl;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+/// <summary>
+/// Замеры производительности. Запускаются из main с аргументом --bench
+/// и печатают результаты в стандартный вывод.
+/// </summary>
+
+/// <summary>
+/// Замер PageRank: время итерации и рёбер в секунду в зависимости от числа потоков
+/// </summary>
+void bench_pagerank();
+
+/// <summary>
+/// Замер BFS и BellmanFord на сетке с перемешанными номерами до и после Reorder
+/// </summary>
+void bench_reorder();
+
+/// <summary>
+/// Замер сжатого графа: байт на ребро и время BFS против несжатого CSR
+/// </summary>
+void bench_compression();
+
+/// <summary>
+/// Замер множества малых обходов большого графа: новые массивы на каждый запрос
+/// против TraversalWorkspace (один и тот же алгоритм, разница - только стоимость подготовки).
+/// Отдельная строка - BellmanFord(start) полными проходами: это смена алгоритма, а не рабочей области
+/// </summary>
+void bench_workspace();
+
+/// <summary>
+/// Замер AStar с ориентирами: память, вершин на запрос и время в зависимости от числа ориентиров
+/// </summary>
+void bench_astar();
+
+/// <summary>
+/// Замер иерархии сжатия: время построения, размер и время запроса в сравнении с AStar
+/// </summary>
+void bench_ch();
+
+/// <summary>
+/// Замер центральности: точное и выборочное посредничество, близость; погрешность выборки
+/// </summary>
+void bench_centrality();
+
+/// <summary>
+/// Замер подсчёта треугольников на степенных графах (R-MAT, Барабаши-Альберт):
+/// пересечение копий GetNeighbors, скалярное и векторное пересечение упорядоченных строк
+/// </summary>
+void bench_triangles();
+
+/// <summary>
+/// Замер представлений: обход подграфа через копию (AddV/AddE), через представление
+/// без копирования и через Materialize; обход обращённого графа
+/// </summary>
+void bench_views();
+
+/// <summary>
+/// Замер памяти после массового удаления вершин и её освобождения Compact
+/// для плотной матрицы и списков смежности
+/// </summary>
+void bench_memory();
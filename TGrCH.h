@@ -0,0 +1,687 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <limits>
+#include <filesystem>
+#include "TGrPool.h"
+#include "TGrWorkspace.h"
+
+using namespace std;
+
+/// <summary>
+/// Параметры построения иерархии сжатия
+/// </summary>
+struct ContractOptions {
+    /// <summary>
+    /// наибольшее число вершин, окончательно обрабатываемых одним поиском свидетеля;
+    /// при превышении путь-свидетель считается ненайденным (лишнее ребро-сокращение
+    /// не нарушает точность, только увеличивает иерархию)
+    /// </summary>
+    size_t witnessSettleLimit = 500;
+};
+
+/// <summary>
+/// Иерархия сжатия (contraction hierarchies) для быстрых запросов кратчайшего пути s-t.
+///
+/// Предобработка: вершины по очереди "сжимаются" в порядке возрастания приоритета
+/// (удвоенная разность рёбер - число нужных сокращений минус число удаляемых рёбер -
+/// плюс число уже сжатых соседей). При сжатии v для каждой пары u -> v -> x добавляется ребро-сокращение
+/// u -> x, если поиск свидетеля не нашёл пути не длиннее в оставшемся графе.
+/// За раунд сжимается независимое множество вершин (локальные минимумы приоритета),
+/// поиски свидетелей для него выполняются параллельно; вершины множества в поиске
+/// не используются, поэтому сокращения разных вершин раунда не зависят друг от друга.
+///
+/// Запрос: двунаправленный Дейкстра только по рёбрам "вверх" (к вершинам большего ранга),
+/// путь восстанавливается раскрытием сокращений до исходных рёбер.
+/// Веса должны быть неотрицательны. Иерархия соответствует графу на момент построения.
+/// </summary>
+/// <typeparam name="W">тип весов рёбер (тривиально копируемый, для Save/Load)</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename W, typename I>
+class ContractionHierarchy {
+public:
+
+    /// <summary>
+    /// Ребро иерархии: соседняя вершина, вес, средняя вершина сокращения (-1 - исходное ребро)
+    /// </summary>
+    struct Arc {
+        I node;
+        W w;
+        I mid;
+    };
+
+    /// <summary>
+    /// Пустая иерархия (для Load)
+    /// </summary>
+    ContractionHierarchy() {}
+
+    /// <summary>
+    /// Построение по взвешенному CSR
+    /// </summary>
+    /// <param name="offs">смещения строк</param>
+    /// <param name="targs">приёмники рёбер</param>
+    /// <param name="ws">веса рёбер</param>
+    /// <param name="inf">обозначение "недостижима"</param>
+    /// <param name="pool">пул потоков или nullptr</param>
+    /// <param name="opt">параметры</param>
+    /// <exception cref="runtime_error - ребро отрицательного веса">
+    /// </exception>
+    ContractionHierarchy(const vector<size_t>& offs, const vector<I>& targs, const vector<W>& ws, W inf,
+        ThreadPool* pool = nullptr, const ContractOptions& opt = ContractOptions())
+        : inf(inf) {
+        Build(offs, targs, ws, pool, opt);
+    }
+
+    /// <summary>
+    /// Кратчайший путь между индексами s и t
+    /// Сложность: обычно сотни просмотренных вершин даже на больших дорожных графах
+    /// </summary>
+    /// <param name="s">начальная вершина</param>
+    /// <param name="t">конечная вершина</param>
+    /// <param name="path">если не nullptr, индексы вершин пути в исходном графе</param>
+    /// <param name="settled">если не nullptr, число обработанных вершин в обоих направлениях</param>
+    /// <returns>длина пути или Inf()</returns>
+    W Query(I s, I t, vector<I>* path = nullptr, size_t* settled = nullptr) const {
+        if (path)
+            path->clear();
+        if (settled)
+            *settled = 0;
+        if (s == t) {
+            if (path)
+                path->push_back(s);
+            return W();
+        }
+
+        // forward - вверх от s по fwd, backward - вверх от t по bwd; Hops - предок
+        static thread_local TraversalWorkspace<W, I> side[2];
+        const vector<size_t>* offs[2] = { &fOffs, &bOffs };
+        const vector<Arc>* arcs[2] = { &fArcs, &bArcs };
+        vector<pair<W, I>> heap[2];
+        auto later = [](const pair<W, I>& a, const pair<W, I>& b) { return a.first > b.first; };
+        I from[2] = { s, t };
+        for (int d = 0; d < 2; ++d) {
+            side[d].Begin(Size());
+            side[d].Visit(from[d]);
+            side[d].DistRef(from[d]) = W();
+            side[d].Hops(from[d]) = -1;
+            heap[d].emplace_back(W(), from[d]);
+        }
+
+        W best = inf;
+        I meet = -1;
+        size_t count = 0;
+        for (int d = 0; !heap[0].empty() || !heap[1].empty(); d ^= 1) {
+            if (heap[d].empty())
+                continue;
+            // остановка: ни одна из сторон не может улучшить найденный путь
+            bool done = true;
+            for (int e = 0; e < 2; ++e)
+                if (!heap[e].empty() && (best == inf || heap[e].front().first < best))
+                    done = false;
+            if (done)
+                break;
+
+            pop_heap(heap[d].begin(), heap[d].end(), later);
+            W du = heap[d].back().first;
+            I u = heap[d].back().second;
+            heap[d].pop_back();
+            if (!side[d].Enqueue(u))
+                continue;
+            ++count;
+            if (best != inf && !(du < best))
+                continue;
+            if (side[d ^ 1].Visited(u)) {
+                W total = du + side[d ^ 1].DistRef(u);
+                if (best == inf || total < best) {
+                    best = total;
+                    meet = u;
+                }
+            }
+            for (size_t e = (*offs[d])[u]; e < (*offs[d])[u + 1]; ++e) {
+                const Arc& a = (*arcs[d])[e];
+                W nd = du + a.w;
+                if (side[d].Visit(a.node) || nd < side[d].DistRef(a.node)) {
+                    side[d].DistRef(a.node) = nd;
+                    side[d].Hops(a.node) = u;
+                    heap[d].emplace_back(nd, a.node);
+                    push_heap(heap[d].begin(), heap[d].end(), later);
+                }
+            }
+        }
+        if (settled)
+            *settled = count;
+
+        if (path && meet >= 0) {
+            // цепочка вершин иерархии s .. meet .. t, затем раскрытие сокращений
+            vector<I> up;
+            for (I v = meet; v >= 0; v = side[0].Hops(v))
+                up.push_back(v);
+            reverse(up.begin(), up.end());
+            for (I v = side[1].Hops(meet); v >= 0; v = side[1].Hops(v))
+                up.push_back(v);
+            path->push_back(up[0]);
+            for (size_t i = 0; i + 1 < up.size(); ++i)
+                Unpack(up[i], up[i + 1], *path);
+        }
+        return best;
+    }
+
+    /// <summary>
+    /// Количество вершин
+    /// </summary>
+    size_t Size() const {
+        return rank.size();
+    }
+
+    /// <summary>
+    /// Ранг вершины: порядковый номер её сжатия
+    /// </summary>
+    I Rank(I v) const {
+        return rank[v];
+    }
+
+    /// <summary>
+    /// Число рёбер иерархии "вверх" в обоих направлениях (исходные и сокращения)
+    /// </summary>
+    size_t ArcCount() const {
+        return fArcs.size() + bArcs.size();
+    }
+
+    /// <summary>
+    /// Число рёбер-сокращений
+    /// </summary>
+    size_t ShortcutCount() const {
+        size_t c = 0;
+        for (const Arc& a : fArcs)
+            c += a.mid >= 0;
+        for (const Arc& a : bArcs)
+            c += a.mid >= 0;
+        return c;
+    }
+
+    /// <summary>
+    /// Обозначение "недостижима"
+    /// </summary>
+    W Inf() const {
+        return inf;
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return rank.capacity() * sizeof(I) + (fOffs.capacity() + bOffs.capacity()) * sizeof(size_t)
+            + (fArcs.capacity() + bArcs.capacity()) * sizeof(Arc);
+    }
+
+    /// <summary>
+    /// Сохранение иерархии в двоичный файл
+    /// </summary>
+    /// <param name="path">путь к файлу</param>
+    /// <exception cref="runtime_error - не удаётся записать файл">
+    /// </exception>
+    void Save(const string& path) const {
+        static_assert(is_trivially_copyable<W>::value, "ContractionHierarchy::Save: тип веса должен быть тривиально копируемым");
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f)
+            throw runtime_error("ContractionHierarchy: не удалось создать " + path);
+        Header h;
+        memcpy(h.magic, MAGIC, 4);
+        h.indexBytes = sizeof(I);
+        h.weightBytes = sizeof(W);
+        h.vertices = rank.size();
+        h.forward = fArcs.size();
+        h.backward = bArcs.size();
+        bool ok = fwrite(&h, sizeof(h), 1, f) == 1 && fwrite(&inf, sizeof(W), 1, f) == 1
+            && Write(f, rank) && Write(f, fOffs) && WriteArcs(f, fArcs) && Write(f, bOffs) && WriteArcs(f, bArcs);
+        ok = fclose(f) == 0 && ok;
+        if (!ok)
+            throw runtime_error("ContractionHierarchy: ошибка записи " + path);
+    }
+
+    /// <summary>
+    /// Загрузка иерархии из файла, записанного Save.
+    /// Размеры из заголовка сверяются с размером файла до выделения памяти, затем
+    /// проверяется структура: ранги - перестановка, строки упорядочены, рёбра идут вверх по рангу,
+    /// у каждого сокращения есть обе половины.
+    /// Сложность: O(V + A log A)
+    /// </summary>
+    /// <param name="path">путь к файлу</param>
+    /// <exception cref="runtime_error - файл не открывается, повреждён или записан для других типов W, I">
+    /// </exception>
+    static ContractionHierarchy Load(const string& path) {
+        error_code ec;
+        uint64_t size = static_cast<uint64_t>(std::filesystem::file_size(path, ec));
+        FILE* f = ec ? nullptr : fopen(path.c_str(), "rb");
+        if (!f)
+            throw runtime_error("ContractionHierarchy: не удалось открыть " + path);
+        ContractionHierarchy ch;
+        Header h;
+        bool ok = fread(&h, sizeof(h), 1, f) == 1 && memcmp(h.magic, MAGIC, 4) == 0
+            && h.indexBytes == sizeof(I) && h.weightBytes == sizeof(W) && Fits(h, size)
+            && fread(&ch.inf, sizeof(W), 1, f) == 1
+            && Read(f, ch.rank, h.vertices) && Read(f, ch.fOffs, h.vertices + 1) && ReadArcs(f, ch.fArcs, h.forward)
+            && Read(f, ch.bOffs, h.vertices + 1) && ReadArcs(f, ch.bArcs, h.backward);
+        fclose(f);
+        if (!ok || !ch.Valid())
+            throw runtime_error("ContractionHierarchy: файл повреждён или несовместим: " + path);
+        return ch;
+    }
+
+private:
+
+    struct Header {
+        char magic[4];
+        uint32_t indexBytes;
+        uint32_t weightBytes;
+        uint32_t reserved = 0;
+        uint64_t vertices;
+        uint64_t forward;
+        uint64_t backward;
+    };
+
+    static constexpr const char* MAGIC = "TGRC";
+
+    W inf = W();
+
+    /// <summary>
+    /// ранг (порядок сжатия) каждой вершины
+    /// </summary>
+    vector<I> rank;
+
+    /// <summary>
+    /// fArcs[fOffs[v] ..) - рёбра v -> x, bArcs[bOffs[v] ..) - рёбра x -> v,
+    /// в обоих случаях rank[x] > rank[v]; упорядочены по x
+    /// </summary>
+    vector<size_t> fOffs, bOffs;
+    vector<Arc> fArcs, bArcs;
+
+    template <typename X>
+    static bool Write(FILE* f, const vector<X>& v) {
+        return v.empty() || fwrite(v.data(), sizeof(X), v.size(), f) == v.size();
+    }
+
+    template <typename X>
+    static bool Read(FILE* f, vector<X>& v, uint64_t count) {
+        v.resize(static_cast<size_t>(count));
+        return v.empty() || fread(v.data(), sizeof(X), v.size(), f) == v.size();
+    }
+
+    /// <summary>
+    /// размер ребра в файле: поля подряд, без выравнивания
+    /// </summary>
+    static constexpr size_t ARC_BYTES = 2 * sizeof(I) + sizeof(W);
+
+    /// <summary>
+    /// Рёбра пишутся по полям, чтобы в файл не попадали байты выравнивания структуры
+    /// </summary>
+    static bool WriteArcs(FILE* f, const vector<Arc>& arcs) {
+        vector<char> buf(arcs.size() * ARC_BYTES);
+        char* p = buf.data();
+        for (const Arc& a : arcs) {
+            memcpy(p, &a.node, sizeof(I));
+            memcpy(p + sizeof(I), &a.w, sizeof(W));
+            memcpy(p + sizeof(I) + sizeof(W), &a.mid, sizeof(I));
+            p += ARC_BYTES;
+        }
+        return buf.empty() || fwrite(buf.data(), 1, buf.size(), f) == buf.size();
+    }
+
+    static bool ReadArcs(FILE* f, vector<Arc>& arcs, uint64_t count) {
+        vector<char> buf(static_cast<size_t>(count) * ARC_BYTES);
+        if (!buf.empty() && fread(buf.data(), 1, buf.size(), f) != buf.size())
+            return false;
+        arcs.resize(static_cast<size_t>(count));
+        const char* p = buf.data();
+        for (Arc& a : arcs) {
+            memcpy(&a.node, p, sizeof(I));
+            memcpy(&a.w, p + sizeof(I), sizeof(W));
+            memcpy(&a.mid, p + sizeof(I) + sizeof(W), sizeof(I));
+            p += ARC_BYTES;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Размеры из заголовка в точности занимают файл (без переполнений при подсчёте)
+    /// </summary>
+    static bool Fits(const Header& h, uint64_t size) {
+        uint64_t fixed = sizeof(Header) + sizeof(W) + 2 * sizeof(size_t);
+        if (size < fixed)
+            return false;
+        uint64_t rest = size - fixed;
+        uint64_t perVertex = sizeof(I) + 2 * sizeof(size_t);
+        if (h.vertices > rest / perVertex || h.vertices > static_cast<uint64_t>(numeric_limits<I>::max()))
+            return false;
+        rest -= h.vertices * perVertex;
+        if (h.forward > rest / ARC_BYTES || h.backward > rest / ARC_BYTES - h.forward)
+            return false;
+        return rest == (h.forward + h.backward) * ARC_BYTES;
+    }
+
+    /// <summary>
+    /// Проверка загруженной иерархии: всё, на что опираются Query и Unpack
+    /// </summary>
+    bool Valid() const {
+        size_t n = rank.size();
+        vector<char> seen(n, 0);
+        for (I r : rank) {
+            if (r < 0 || static_cast<size_t>(r) >= n || seen[r])
+                return false;
+            seen[r] = 1;
+        }
+        // строки: смещения не убывают, соседи по возрастанию и выше по рангу,
+        // средняя вершина сокращения ниже обоих концов
+        auto rows = [&](const vector<size_t>& offs, const vector<Arc>& arcs) {
+            if (offs[0] != 0 || offs[n] != arcs.size())
+                return false;
+            for (size_t v = 0; v < n; ++v) {
+                if (offs[v] > offs[v + 1])
+                    return false;
+                for (size_t e = offs[v]; e < offs[v + 1]; ++e) {
+                    const Arc& a = arcs[e];
+                    if (a.node < 0 || static_cast<size_t>(a.node) >= n || rank[a.node] <= rank[v]
+                        || (e > offs[v] && !(arcs[e - 1].node < a.node)))
+                        return false;
+                    if (a.mid >= 0 && (static_cast<size_t>(a.mid) >= n || rank[a.mid] >= rank[v]))
+                        return false;
+                }
+            }
+            return true;
+        };
+        if (!rows(fOffs, fArcs) || !rows(bOffs, bArcs))
+            return false;
+        // ребро x -> y хранится у вершины меньшего ранга, как его ищет Unpack
+        auto has = [&](I x, I y) {
+            return (rank[x] < rank[y] ? FindArc(fOffs, fArcs, x, y) : FindArc(bOffs, bArcs, y, x)) != nullptr;
+        };
+        for (size_t vi = 0; vi < n; ++vi) {
+            I v = static_cast<I>(vi);
+            for (size_t e = fOffs[v]; e < fOffs[v + 1]; ++e)
+                if (fArcs[e].mid >= 0 && !(has(v, fArcs[e].mid) && has(fArcs[e].mid, fArcs[e].node)))
+                    return false;
+            for (size_t e = bOffs[v]; e < bOffs[v + 1]; ++e)
+                if (bArcs[e].mid >= 0 && !(has(bArcs[e].node, bArcs[e].mid) && has(bArcs[e].mid, v)))
+                    return false;
+        }
+        return true;
+    }
+
+    /// <summary>
+    /// Ребро в упорядоченной по node строке
+    /// </summary>
+    static const Arc* FindArc(const vector<size_t>& offs, const vector<Arc>& arcs, I v, I node) {
+        auto first = arcs.begin() + offs[v], last = arcs.begin() + offs[v + 1];
+        auto it = lower_bound(first, last, node, [](const Arc& a, I x) { return a.node < x; });
+        return it != last && it->node == node ? &*it : nullptr;
+    }
+
+    /// <summary>
+    /// Раскрытие ребра a -> b до исходных рёбер; в path дописываются вершины после a
+    /// </summary>
+    void Unpack(I a, I b, vector<I>& path) const {
+        vector<pair<I, I>> st(1, make_pair(a, b));
+        while (!st.empty()) {
+            I x = st.back().first, y = st.back().second;
+            st.pop_back();
+            // ребро хранится у вершины меньшего ранга
+            const Arc* arc = rank[x] < rank[y] ? FindArc(fOffs, fArcs, x, y) : FindArc(bOffs, bArcs, y, x);
+            if (arc->mid < 0) {
+                path.push_back(y);
+                continue;
+            }
+            st.emplace_back(arc->mid, y);
+            st.emplace_back(x, arc->mid);
+        }
+    }
+
+    /// <summary>
+    /// Изменяемый граф во время сжатия
+    /// </summary>
+    struct Work {
+        vector<vector<Arc>> out, in;
+        vector<char> contracted, busy;
+        vector<I> deleted;
+    };
+
+    /// <summary>
+    /// Сокращение u -> x веса w через mid
+    /// </summary>
+    struct Shortcut {
+        I from, to;
+        W w;
+    };
+
+    /// <summary>
+    /// Рабочие массивы поиска свидетелей (по одному на поток)
+    /// </summary>
+    struct Scratch {
+        TraversalWorkspace<W, I> ws;
+        vector<pair<W, I>> heap;
+        vector<char> target;
+        vector<Shortcut> res;
+    };
+
+    /// <summary>
+    /// Сокращения, нужные при сжатии v: поиск свидетелей от каждого входящего соседа
+    /// до обработки всех выходящих соседей v, превышения длины пути через v или лимита.
+    /// Вершины v и занятые (busy) в поиске не участвуют.
+    /// </summary>
+    void Witness(const Work& g, I v, Scratch& sc, size_t limit, vector<Shortcut>& res) const {
+        res.clear();
+        const vector<Arc>& outs = g.out[v];
+        if (outs.empty())
+            return;
+        TraversalWorkspace<W, I>& ws = sc.ws;
+        vector<pair<W, I>>& heap = sc.heap;
+        if (sc.target.size() < g.out.size())
+            sc.target.resize(g.out.size(), 0);
+        W maxOut = W();
+        for (const Arc& b : outs) {
+            if (b.w > maxOut)
+                maxOut = b.w;
+            sc.target[b.node] = 1;
+        }
+        auto later = [](const pair<W, I>& a, const pair<W, I>& b) { return a.first > b.first; };
+        for (const Arc& a : g.in[v]) {
+            I u = a.node;
+            W bound = a.w + maxOut;
+            ws.Begin(g.out.size());
+            heap.clear();
+            ws.Visit(u);
+            ws.DistRef(u) = W();
+            heap.emplace_back(W(), u);
+            size_t settledCount = 0, left = outs.size() - sc.target[u];
+            while (!heap.empty() && settledCount < limit && left > 0) {
+                pop_heap(heap.begin(), heap.end(), later);
+                W d = heap.back().first;
+                I x = heap.back().second;
+                heap.pop_back();
+                if (!ws.Enqueue(x))
+                    continue;
+                ++settledCount;
+                if (d > bound)
+                    break;
+                if (sc.target[x] && x != u)
+                    --left;
+                for (const Arc& e : g.out[x]) {
+                    I y = e.node;
+                    if (y == v || g.busy[y])
+                        continue;
+                    W nd = d + e.w;
+                    if (ws.Visit(y) || nd < ws.DistRef(y)) {
+                        ws.DistRef(y) = nd;
+                        heap.emplace_back(nd, y);
+                        push_heap(heap.begin(), heap.end(), later);
+                    }
+                }
+            }
+            for (const Arc& b : outs) {
+                if (b.node == u)
+                    continue;
+                W via = a.w + b.w;
+                if (!ws.Visited(b.node) || via < ws.DistRef(b.node))
+                    res.push_back(Shortcut{ u, b.node, via });
+            }
+        }
+        for (const Arc& b : outs)
+            sc.target[b.node] = 0;
+    }
+
+    /// <summary>
+    /// Ребро u -> x: добавление или уменьшение веса в строке
+    /// </summary>
+    static void Relax(vector<Arc>& list, I node, W w, I mid) {
+        for (Arc& a : list)
+            if (a.node == node) {
+                if (w < a.w) {
+                    a.w = w;
+                    a.mid = mid;
+                }
+                return;
+            }
+        list.push_back(Arc{ node, w, mid });
+    }
+
+    static void Remove(vector<Arc>& list, I node) {
+        for (size_t i = 0; i < list.size(); ++i)
+            if (list[i].node == node) {
+                list[i] = list.back();
+                list.pop_back();
+                return;
+            }
+    }
+
+    void Build(const vector<size_t>& offs, const vector<I>& targs, const vector<W>& ws,
+        ThreadPool* pool, const ContractOptions& opt) {
+        size_t n = offs.size() - 1;
+        Work g;
+        g.out.resize(n);
+        g.in.resize(n);
+        g.contracted.assign(n, 0);
+        g.busy.assign(n, 0);
+        g.deleted.assign(n, 0);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e) {
+                if (ws[e] < W())
+                    throw runtime_error("ContractionHierarchy: ребро отрицательного веса");
+                I v = targs[e];
+                if (v == static_cast<I>(u))
+                    continue; // петли не входят в кратчайшие пути
+                Relax(g.out[u], v, ws[e], -1);
+                Relax(g.in[v], static_cast<I>(u), ws[e], -1);
+            }
+
+        unsigned slots = pool ? pool->Workers() + 1 : 1;
+        vector<Scratch> scratch(slots);
+        auto forEach = [&](size_t count, auto f) {
+            if (pool)
+                pool->ParallelFor(0, count, 16, f);
+            else
+                for (size_t i = 0; i < count; ++i)
+                    f(i, 0);
+        };
+
+        // приоритет: удвоенная разность рёбер плюс число сжатых соседей
+        vector<long long> prio(n, 0);
+        auto priority = [&](I v, unsigned slot) {
+            Witness(g, v, scratch[slot], opt.witnessSettleLimit, scratch[slot].res);
+            long long diff = static_cast<long long>(scratch[slot].res.size())
+                - static_cast<long long>(g.in[v].size() + g.out[v].size());
+            return 2 * diff + g.deleted[v];
+        };
+        forEach(n, [&](size_t v, unsigned slot) { prio[v] = priority(static_cast<I>(v), slot); });
+
+        rank.assign(n, -1);
+        vector<vector<Arc>> upOut(n), upIn(n);
+        vector<I> remaining(n);
+        for (size_t v = 0; v < n; ++v)
+            remaining[v] = static_cast<I>(v);
+        I next = 0;
+
+        while (!remaining.empty()) {
+            // независимое множество: локальные минимумы (приоритет, индекс) среди соседей
+            auto less = [&](I a, I b) { return prio[a] != prio[b] ? prio[a] < prio[b] : a < b; };
+            vector<char> pick(remaining.size(), 0);
+            forEach(remaining.size(), [&](size_t i, unsigned) {
+                I v = remaining[i];
+                for (const Arc& a : g.out[v])
+                    if (less(a.node, v))
+                        return;
+                for (const Arc& a : g.in[v])
+                    if (less(a.node, v))
+                        return;
+                pick[i] = 1;
+            });
+            vector<I> set, rest;
+            for (size_t i = 0; i < remaining.size(); ++i)
+                (pick[i] ? set : rest).push_back(remaining[i]);
+            for (I v : set)
+                g.busy[v] = 1;
+
+            // поиски свидетелей параллельно
+            vector<vector<Shortcut>> found(set.size());
+            forEach(set.size(), [&](size_t i, unsigned slot) {
+                Witness(g, set[i], scratch[slot], opt.witnessSettleLimit, found[i]);
+            });
+
+            // сжатие: рёбра v сохраняются в иерархии, v удаляется, добавляются сокращения
+            vector<I> touched;
+            for (size_t i = 0; i < set.size(); ++i) {
+                I v = set[i];
+                rank[v] = next++;
+                upOut[v] = move(g.out[v]);
+                upIn[v] = move(g.in[v]);
+                g.out[v].clear();
+                g.in[v].clear();
+                for (const Arc& a : upOut[v]) {
+                    Remove(g.in[a.node], v);
+                    ++g.deleted[a.node];
+                    touched.push_back(a.node);
+                }
+                for (const Arc& a : upIn[v]) {
+                    Remove(g.out[a.node], v);
+                    ++g.deleted[a.node];
+                    touched.push_back(a.node);
+                }
+                for (const Shortcut& s : found[i]) {
+                    Relax(g.out[s.from], s.to, s.w, v);
+                    Relax(g.in[s.to], s.from, s.w, v);
+                }
+                g.contracted[v] = 1;
+                g.busy[v] = 0;
+            }
+
+            // пересчёт приоритетов соседей
+            sort(touched.begin(), touched.end());
+            touched.erase(unique(touched.begin(), touched.end()), touched.end());
+            forEach(touched.size(), [&](size_t i, unsigned slot) {
+                prio[touched[i]] = priority(touched[i], slot);
+            });
+            remaining.swap(rest);
+        }
+
+        // плоские массивы, строки упорядочены по соседу
+        auto flatten = [&](vector<vector<Arc>>& lists, vector<size_t>& o, vector<Arc>& arcs) {
+            o.assign(n + 1, 0);
+            for (size_t v = 0; v < n; ++v)
+                o[v + 1] = o[v] + lists[v].size();
+            arcs.clear();
+            arcs.reserve(o[n]);
+            for (size_t v = 0; v < n; ++v) {
+                sort(lists[v].begin(), lists[v].end(), [](const Arc& a, const Arc& b) { return a.node < b.node; });
+                arcs.insert(arcs.end(), lists[v].begin(), lists[v].end());
+                vector<Arc>().swap(lists[v]);
+            }
+        };
+        flatten(upOut, fOffs, fArcs);
+        flatten(upIn, bOffs, bArcs);
+    }
+};
@@ -0,0 +1,388 @@
+#pragma once
+
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <limits>
+#include <algorithm>
+#include <stdexcept>
+#include "TGrPool.h"
+
+using namespace std;
+
+/// <summary>
+/// Параметры расчёта центральности
+/// </summary>
+struct CentralityOptions {
+    /// <summary>
+    /// число источников выборки; 0 - все вершины (точный расчёт)
+    /// </summary>
+    size_t samples = 0;
+
+    /// <summary>
+    /// допустимая погрешность: если больше 0, размер выборки не меньше
+    /// CentralityEngine::SampleSize(V, epsilon, delta)
+    /// </summary>
+    double epsilon = 0;
+
+    /// <summary>
+    /// допустимая вероятность превышения погрешности
+    /// </summary>
+    double delta = 0.1;
+
+    /// <summary>
+    /// зерно выбора источников
+    /// </summary>
+    uint32_t seed = 1;
+};
+
+/// <summary>
+/// Результат расчёта центральности
+/// </summary>
+struct CentralityResult {
+    /// <summary>
+    /// значения по индексам вершин
+    /// </summary>
+    vector<double> scores;
+
+    /// <summary>
+    /// обработано источников
+    /// </summary>
+    size_t sources = 0;
+
+    /// <summary>
+    /// обработаны все вершины (иначе значения - оценки по выборке)
+    /// </summary>
+    bool exact = true;
+
+    /// <summary>
+    /// время расчёта, с
+    /// </summary>
+    double seconds = 0;
+};
+
+/// <summary>
+/// Центральность вершин по кратчайшим путям: посредничество (алгоритм Брандеса),
+/// близость и гармоническая центральность.
+/// Кратчайшие пути - обход в ширину (без весов) или Дейкстра (веса должны быть положительны).
+/// Источники обрабатываются параллельно; у каждого потока свои рабочие массивы
+/// и свои суммы, которые складываются в конце, поэтому синхронизации при обходах нет.
+///
+/// Выборочный режим: k источников выбираются случайно без повторений. По неравенству
+/// Хёфдинга при k = SampleSize(V, epsilon, delta) с вероятностью не меньше 1 - delta
+/// для всех вершин одновременно погрешность посредничества не больше epsilon * V * (V - 2),
+/// а гармонической центральности графа без весов - не больше epsilon.
+/// </summary>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename I>
+class CentralityEngine {
+public:
+
+    /// <summary>
+    /// Построение по CSR
+    /// </summary>
+    /// <param name="offs">смещения строк</param>
+    /// <param name="targs">приёмники рёбер</param>
+    /// <param name="weights">веса рёбер или nullptr - без весов</param>
+    /// <param name="pool">пул потоков</param>
+    /// <exception cref="runtime_error - вес ребра не положителен">
+    /// </exception>
+    CentralityEngine(vector<size_t> offs, vector<I> targs, const vector<double>* weights, ThreadPool& pool)
+        : pool(pool), offs(move(offs)), targs(move(targs)) {
+        if (weights) {
+            for (double w : *weights)
+                if (!(w > 0))
+                    throw runtime_error("CentralityEngine: веса рёбер должны быть положительны");
+            ws = *weights;
+        }
+        // обратный граф для близости: обход от s по нему даёт расстояния d(v, s)
+        size_t n = Size();
+        rOffs.assign(n + 1, 0);
+        for (I v : this->targs)
+            ++rOffs[v + 1];
+        for (size_t v = 0; v < n; ++v)
+            rOffs[v + 1] += rOffs[v];
+        rTargs.resize(this->targs.size());
+        if (weights)
+            rWs.resize(ws.size());
+        vector<size_t> pos(rOffs.begin(), rOffs.end() - 1);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = this->offs[u]; e < this->offs[u + 1]; ++e) {
+                size_t p = pos[this->targs[e]]++;
+                rTargs[p] = static_cast<I>(u);
+                if (weights)
+                    rWs[p] = ws[e];
+            }
+    }
+
+    /// <summary>
+    /// Количество вершин
+    /// </summary>
+    size_t Size() const {
+        return offs.size() - 1;
+    }
+
+    /// <summary>
+    /// Размер выборки для погрешности epsilon с вероятностью 1 - delta:
+    /// ln(2 * V / delta) / (2 * epsilon ^ 2), не больше V
+    /// </summary>
+    static size_t SampleSize(size_t n, double epsilon, double delta) {
+        if (n == 0)
+            return 0;
+        if (!(epsilon > 0) || !(delta > 0) || delta >= 1)
+            throw runtime_error("CentralityEngine: неверные epsilon или delta");
+        double k = ceil(log(2.0 * static_cast<double>(n) / delta) / (2.0 * epsilon * epsilon));
+        return k >= static_cast<double>(n) ? n : static_cast<size_t>(k);
+    }
+
+    /// <summary>
+    /// Посредничество: для каждой вершины v сумма по парам s != v != t доли
+    /// кратчайших путей s - t, проходящих через v (без нормировки).
+    /// Сложность: O(V * E) без весов, O(V * E log V) с весами; с выборкой - в V / k раз меньше
+    /// </summary>
+    CentralityResult Betweenness(const CentralityOptions& opt = CentralityOptions()) const {
+        auto t0 = chrono::steady_clock::now();
+        size_t n = Size();
+        vector<I> sources = Sources(opt);
+        vector<Scratch> scratch(pool.Workers() + 1);
+
+        pool.ParallelFor(0, sources.size(), 1, [&](size_t i, unsigned slot) {
+            Scratch& sc = Prepare(scratch[slot], true);
+            I s = sources[i];
+            Search(offs, targs, ws, s, sc, true);
+
+            // обратный проход в порядке убывания расстояния:
+            // delta[v] = сумма sigma[v] / sigma[w] * (1 + delta[w]) по рёбрам v -> w кратчайших путей
+            for (size_t j = sc.order.size(); j-- > 0;) {
+                I v = sc.order[j];
+                double dv = 0;
+                for (size_t e = offs[v]; e < offs[v + 1]; ++e) {
+                    I w = targs[e];
+                    if (sc.dist[w] == sc.dist[v] + Weight(ws, e))
+                        dv += sc.sigma[v] / sc.sigma[w] * (1.0 + sc.delta[w]);
+                }
+                sc.delta[v] = dv;
+                if (v != s)
+                    sc.acc[v] += dv;
+            }
+            Reset(sc);
+        });
+
+        CentralityResult res = Collect(scratch, sources.size(), n, t0);
+        if (!res.exact)
+            for (double& x : res.scores)
+                x *= static_cast<double>(n) / static_cast<double>(sources.size());
+        return res;
+    }
+
+    /// <summary>
+    /// Близость по исходящим расстояниям (формула Вассермана-Фауста для несвязных графов):
+    /// (r / (V - 1)) * (r / сумма расстояний), где r - число вершин, достижимых из v.
+    /// В выборочном режиме r / (V - 1) и среднее расстояние оцениваются по выборке.
+    /// Сложность: как у Betweenness
+    /// </summary>
+    CentralityResult Closeness(const CentralityOptions& opt = CentralityOptions()) const {
+        return Distances(opt, false);
+    }
+
+    /// <summary>
+    /// Гармоническая центральность: сумма 1 / d(v, u) по u != v, делённая на V - 1
+    /// (недостижимые вершины дают 0).
+    /// Сложность: как у Betweenness
+    /// </summary>
+    CentralityResult Harmonic(const CentralityOptions& opt = CentralityOptions()) const {
+        return Distances(opt, true);
+    }
+
+private:
+    ThreadPool& pool;
+    vector<size_t> offs, rOffs;
+    vector<I> targs, rTargs;
+    vector<double> ws, rWs;
+
+    /// <summary>
+    /// Рабочие массивы и суммы потока. Массивы размера V заполняются один раз,
+    /// после обхода восстанавливаются только для достигнутых вершин (order).
+    /// </summary>
+    struct Scratch {
+        vector<double> dist, sigma, delta;
+        vector<char> done;
+        vector<I> order;
+        vector<pair<double, I>> heap;
+        vector<double> acc, acc2;
+        vector<size_t> count;
+    };
+
+    static double Weight(const vector<double>& w, size_t e) {
+        return w.empty() ? 1.0 : w[e];
+    }
+
+    Scratch& Prepare(Scratch& sc, bool brandes) const {
+        size_t n = Size();
+        if (sc.dist.size() != n) {
+            sc.dist.assign(n, numeric_limits<double>::infinity());
+            sc.sigma.assign(n, 0.0);
+            sc.delta.assign(n, 0.0);
+            sc.done.assign(n, 0);
+            sc.acc.assign(n, 0.0);
+            if (!brandes) {
+                sc.acc2.assign(n, 0.0);
+                sc.count.assign(n, 0);
+            }
+        }
+        return sc;
+    }
+
+    static void Reset(Scratch& sc) {
+        for (I v : sc.order) {
+            sc.dist[v] = numeric_limits<double>::infinity();
+            sc.sigma[v] = 0;
+            sc.delta[v] = 0;
+            sc.done[v] = 0;
+        }
+        sc.order.clear();
+    }
+
+    /// <summary>
+    /// Кратчайшие пути от s: dist, число путей sigma (если нужно) и order - вершины
+    /// в порядке неубывания расстояния
+    /// </summary>
+    static void Search(const vector<size_t>& o, const vector<I>& t, const vector<double>& w,
+        I s, Scratch& sc, bool countPaths) {
+        sc.dist[s] = 0;
+        sc.sigma[s] = 1;
+        if (w.empty()) {
+            sc.order.push_back(s);
+            for (size_t head = 0; head < sc.order.size(); ++head) {
+                I u = sc.order[head];
+                double nd = sc.dist[u] + 1;
+                for (size_t e = o[u]; e < o[u + 1]; ++e) {
+                    I v = t[e];
+                    if (sc.dist[v] == numeric_limits<double>::infinity()) {
+                        sc.dist[v] = nd;
+                        sc.order.push_back(v);
+                    }
+                    if (countPaths && sc.dist[v] == nd)
+                        sc.sigma[v] += sc.sigma[u];
+                }
+            }
+            return;
+        }
+
+        auto later = [](const pair<double, I>& a, const pair<double, I>& b) { return a.first > b.first; };
+        sc.heap.clear();
+        sc.heap.emplace_back(0.0, s);
+        while (!sc.heap.empty()) {
+            pop_heap(sc.heap.begin(), sc.heap.end(), later);
+            I u = sc.heap.back().second;
+            sc.heap.pop_back();
+            if (sc.done[u])
+                continue;
+            sc.done[u] = 1;
+            sc.order.push_back(u);
+            for (size_t e = o[u]; e < o[u + 1]; ++e) {
+                I v = t[e];
+                double nd = sc.dist[u] + w[e];
+                if (nd < sc.dist[v]) {
+                    sc.dist[v] = nd;
+                    sc.sigma[v] = sc.sigma[u];
+                    sc.heap.emplace_back(nd, v);
+                    push_heap(sc.heap.begin(), sc.heap.end(), later);
+                }
+                else if (countPaths && nd == sc.dist[v])
+                    sc.sigma[v] += sc.sigma[u];
+            }
+        }
+    }
+
+    /// <summary>
+    /// Источники: все вершины или случайная выборка без повторений
+    /// </summary>
+    vector<I> Sources(const CentralityOptions& opt) const {
+        size_t n = Size();
+        size_t k = opt.samples;
+        if (opt.epsilon > 0)
+            k = max(k, SampleSize(n, opt.epsilon, opt.delta));
+        if (k == 0 || k > n)
+            k = n;
+        vector<I> all(n);
+        for (size_t v = 0; v < n; ++v)
+            all[v] = static_cast<I>(v);
+        if (k < n) {
+            mt19937 rng(opt.seed);
+            for (size_t i = 0; i < k; ++i)
+                swap(all[i], all[i + rng() % (n - i)]);
+            all.resize(k);
+        }
+        return all;
+    }
+
+    /// <summary>
+    /// Сумма acc по потокам
+    /// </summary>
+    static CentralityResult Collect(const vector<Scratch>& scratch, size_t k, size_t n,
+        chrono::steady_clock::time_point t0) {
+        CentralityResult res;
+        res.scores.assign(n, 0.0);
+        for (const Scratch& sc : scratch)
+            for (size_t v = 0; v < sc.acc.size(); ++v)
+                res.scores[v] += sc.acc[v];
+        res.sources = k;
+        res.exact = k == n;
+        res.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        return res;
+    }
+
+    /// <summary>
+    /// Близость и гармоническая центральность: обход от каждого источника s по обратному
+    /// графу даёт d(v, s) сразу для всех v; потоки суммируют по v сумму расстояний,
+    /// число достигнутых источников и сумму 1 / d
+    /// </summary>
+    CentralityResult Distances(const CentralityOptions& opt, bool harmonic) const {
+        auto t0 = chrono::steady_clock::now();
+        size_t n = Size();
+        vector<I> sources = Sources(opt);
+        vector<char> sampled(n, 0);
+        for (I s : sources)
+            sampled[s] = 1;
+        vector<Scratch> scratch(pool.Workers() + 1);
+
+        pool.ParallelFor(0, sources.size(), 1, [&](size_t i, unsigned slot) {
+            Scratch& sc = Prepare(scratch[slot], false);
+            I s = sources[i];
+            Search(rOffs, rTargs, rWs, s, sc, false);
+            for (I v : sc.order) {
+                if (v == s)
+                    continue;
+                sc.acc[v] += sc.dist[v];
+                sc.acc2[v] += 1.0 / sc.dist[v];
+                ++sc.count[v];
+            }
+            Reset(sc);
+        });
+
+        CentralityResult res;
+        res.scores.assign(n, 0.0);
+        vector<double> sum(n, 0.0), inv(n, 0.0);
+        vector<size_t> reached(n, 0);
+        for (const Scratch& sc : scratch)
+            for (size_t v = 0; v < sc.acc.size(); ++v) {
+                sum[v] += sc.acc[v];
+                inv[v] += sc.acc2[v];
+                reached[v] += sc.count[v];
+            }
+        for (size_t v = 0; v < n; ++v) {
+            // m - число источников, отличных от v
+            double m = static_cast<double>(sources.size() - sampled[v]);
+            if (m == 0)
+                continue;
+            double r = static_cast<double>(reached[v]);
+            res.scores[v] = harmonic ? inv[v] / m : (sum[v] > 0 ? r * r / (m * sum[v]) : 0.0);
+        }
+        res.sources = sources.size();
+        res.exact = sources.size() == n;
+        res.seconds = chrono::duration<double>(chrono::steady_clock::now() - t0).count();
+        return res;
+    }
+};
@@ -0,0 +1,346 @@
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <algorithm>
+#include <utility>
+#include "TGrPool.h"
+
+using namespace std;
+
+/// <summary>
+/// Разбиение вершин на компоненты связности
+/// </summary>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename I>
+struct Components {
+    /// <summary>
+    /// номер компоненты для каждого индекса вершины; компоненты пронумерованы
+    /// по возрастанию наименьшего индекса входящей в них вершины
+    /// </summary>
+    vector<I> id;
+
+    /// <summary>
+    /// размеры компонент
+    /// </summary>
+    vector<size_t> sizes;
+
+    /// <summary>
+    /// Количество компонент
+    /// </summary>
+    size_t Count() const {
+        return sizes.size();
+    }
+};
+
+namespace comp_detail {
+
+    /// <summary>
+    /// Перенумерация компонент в порядке первого появления и подсчёт размеров.
+    /// Делает результат независимым от порядка обработки (и от числа потоков).
+    /// </summary>
+    template <typename I>
+    Components<I> Canonical(vector<I> raw) {
+        Components<I> res;
+        vector<I> remap(raw.size(), -1);
+        for (I& c : raw) {
+            if (remap[c] < 0) {
+                remap[c] = static_cast<I>(res.sizes.size());
+                res.sizes.push_back(0);
+            }
+            c = remap[c];
+            ++res.sizes[c];
+        }
+        res.id = move(raw);
+        return res;
+    }
+
+    /// <summary>
+    /// Обратный CSR (входящие рёбра) подсчётом
+    /// </summary>
+    template <typename I>
+    void Reverse(const vector<size_t>& offs, const vector<I>& targs,
+        vector<size_t>& rOffs, vector<I>& rTargs) {
+        size_t n = offs.size() - 1;
+        rOffs.assign(n + 1, 0);
+        for (I v : targs)
+            ++rOffs[v + 1];
+        for (size_t i = 0; i < n; ++i)
+            rOffs[i + 1] += rOffs[i];
+        rTargs.resize(targs.size());
+        vector<size_t> pos(rOffs.begin(), rOffs.end() - 1);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                rTargs[pos[targs[e]]++] = static_cast<I>(u);
+    }
+
+    /// <summary>
+    /// Итеративный (без рекурсии) алгоритм Тарьяна на подмножестве вершин inSet.
+    /// index, low, onStack - общие массивы размера V, используются только элементы
+    /// вершин подмножества, поэтому непересекающиеся подмножества можно
+    /// обрабатывать параллельно. comp[v] = newId() для каждой найденной компоненты.
+    /// </summary>
+    template <typename I, typename InSet, typename NewId>
+    void Tarjan(const vector<size_t>& offs, const vector<I>& targs, const vector<I>& roots,
+        InSet inSet, NewId newId, vector<I>& index, vector<I>& low, vector<char>& onStack, vector<I>& comp) {
+        I counter = 0;
+        vector<I> st;
+        vector<pair<I, size_t>> frames; // вершина и позиция следующего ребра
+
+        for (I r : roots) {
+            if (index[r] >= 0)
+                continue;
+            index[r] = low[r] = counter++;
+            st.push_back(r);
+            onStack[r] = 1;
+            frames.emplace_back(r, offs[r]);
+
+            while (!frames.empty()) {
+                I v = frames.back().first;
+                size_t& e = frames.back().second;
+                if (e < offs[v + 1]) {
+                    I w = targs[e++];
+                    if (!inSet(w))
+                        continue;
+                    if (index[w] < 0) {
+                        index[w] = low[w] = counter++;
+                        st.push_back(w);
+                        onStack[w] = 1;
+                        frames.emplace_back(w, offs[w]);
+                    }
+                    else if (onStack[w])
+                        low[v] = min(low[v], index[w]);
+                    continue;
+                }
+
+                // все рёбра v просмотрены
+                frames.pop_back();
+                if (low[v] == index[v]) {
+                    I id = newId();
+                    I w;
+                    do {
+                        w = st.back();
+                        st.pop_back();
+                        onStack[w] = 0;
+                        comp[w] = id;
+                    } while (w != v);
+                }
+                if (!frames.empty()) {
+                    I p = frames.back().first;
+                    low[p] = min(low[p], low[v]);
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Корень в непрерывно сжимаемом лесе (сокращение пути вдвое через CAS)
+    /// </summary>
+    template <typename I>
+    I Find(vector<atomic<I>>& parent, I v) {
+        for (;;) {
+            I p = parent[v].load(memory_order_relaxed);
+            if (p == v)
+                return v;
+            I gp = parent[p].load(memory_order_relaxed);
+            if (gp != p)
+                parent[v].compare_exchange_weak(p, gp, memory_order_relaxed);
+            v = gp;
+        }
+    }
+
+    /// <summary>
+    /// Объединение без блокировок: корень с большим индексом подвешивается к меньшему
+    /// </summary>
+    template <typename I>
+    void Union(vector<atomic<I>>& parent, I a, I b) {
+        for (;;) {
+            a = Find(parent, a);
+            b = Find(parent, b);
+            if (a == b)
+                return;
+            if (a < b)
+                swap(a, b);
+            I expected = a;
+            if (parent[a].compare_exchange_strong(expected, b, memory_order_acq_rel))
+                return;
+        }
+    }
+}
+
+/// <summary>
+/// Сильно связные компоненты: итеративный алгоритм Тарьяна.
+/// Граф задан в виде CSR: рёбра вершины u - targs[offs[u] .. offs[u + 1]).
+/// Сложность: O(V + E)
+/// </summary>
+template <typename I>
+Components<I> SccTarjan(const vector<size_t>& offs, const vector<I>& targs) {
+    size_t n = offs.size() - 1;
+    vector<I> index(n, -1), low(n, 0), comp(n, -1), roots(n);
+    vector<char> onStack(n, 0);
+    for (size_t v = 0; v < n; ++v)
+        roots[v] = static_cast<I>(v);
+    I next = 0;
+    comp_detail::Tarjan(offs, targs, roots, [](I) { return true; }, [&]() { return next++; },
+        index, low, onStack, comp);
+    return comp_detail::Canonical(move(comp));
+}
+
+/// <summary>
+/// Сильно связные компоненты: параллельный алгоритм forward-backward.
+/// Для подмножества берётся опорная вершина; пересечение её прямого и обратного
+/// достижимых множеств - компонента, остальные три части независимы и обрабатываются
+/// параллельно в следующем раунде. Вершины без входящих или исходящих рёбер внутри
+/// подмножества отсекаются сразу, мелкие подмножества (до cutoff вершин)
+/// доделываются алгоритмом Тарьяна.
+/// Сложность: O((V + E) * глубина разбиения / потоки)
+/// </summary>
+template <typename I>
+Components<I> SccForwardBackward(const vector<size_t>& offs, const vector<I>& targs,
+    ThreadPool& pool, size_t cutoff = 1024) {
+    size_t n = offs.size() - 1;
+    vector<size_t> rOffs;
+    vector<I> rTargs;
+    comp_detail::Reverse(offs, targs, rOffs, rTargs);
+
+    // метка подмножества, которому принадлежит вершина; читается соседними задачами
+    vector<atomic<I>> part(n);
+    for (auto& p : part)
+        p.store(0, memory_order_relaxed);
+    vector<I> comp(n, -1), index(n, -1), low(n, 0);
+    vector<char> onStack(n, 0);
+    atomic<I> nextLabel(1), nextComp(0);
+
+    struct Piece {
+        I label;
+        vector<I> verts;
+    };
+    vector<Piece> work(1);
+    work[0].label = 0;
+    work[0].verts.resize(n);
+    for (size_t v = 0; v < n; ++v)
+        work[0].verts[v] = static_cast<I>(v);
+
+    while (!work.empty()) {
+        vector<Piece> next;
+        mutex nextLock;
+
+        pool.ParallelFor(0, work.size(), 1, [&](size_t k, unsigned) {
+            I L = work[k].label;
+            vector<I> verts = move(work[k].verts);
+            auto inSet = [&](I v) { return part[v].load(memory_order_relaxed) == L; };
+            auto newId = [&]() { return nextComp.fetch_add(1, memory_order_relaxed); };
+
+            // отсечение вершин без входящих или исходящих рёбер внутри подмножества
+            vector<I> rest;
+            rest.reserve(verts.size());
+            for (I v : verts) {
+                bool out = false, in = false;
+                for (size_t e = offs[v]; e < offs[v + 1] && !out; ++e)
+                    out = targs[e] != v && inSet(targs[e]);
+                for (size_t e = rOffs[v]; e < rOffs[v + 1] && !in; ++e)
+                    in = rTargs[e] != v && inSet(rTargs[e]);
+                if (out && in)
+                    rest.push_back(v);
+                else
+                    comp[v] = newId();
+            }
+            I trimmed = nextLabel.fetch_add(1, memory_order_relaxed);
+            for (I v : verts)
+                if (comp[v] >= 0)
+                    part[v].store(trimmed, memory_order_relaxed);
+            if (rest.empty())
+                return;
+
+            if (rest.size() <= cutoff) {
+                comp_detail::Tarjan(offs, targs, rest, inSet, newId, index, low, onStack, comp);
+                return;
+            }
+
+            // прямой обход от опорной вершины: метка F
+            I F = nextLabel.fetch_add(1, memory_order_relaxed);
+            I B = nextLabel.fetch_add(1, memory_order_relaxed);
+            I S = nextLabel.fetch_add(1, memory_order_relaxed);
+            I pivot = rest[0];
+            vector<I> q;
+            q.push_back(pivot);
+            part[pivot].store(F, memory_order_relaxed);
+            for (size_t head = 0; head < q.size(); ++head) {
+                I u = q[head];
+                for (size_t e = offs[u]; e < offs[u + 1]; ++e) {
+                    I w = targs[e];
+                    if (part[w].load(memory_order_relaxed) == L) {
+                        part[w].store(F, memory_order_relaxed);
+                        q.push_back(w);
+                    }
+                }
+            }
+
+            // обратный обход: F -> компонента S, L -> метка B
+            q.clear();
+            q.push_back(pivot);
+            part[pivot].store(S, memory_order_relaxed);
+            for (size_t head = 0; head < q.size(); ++head) {
+                I u = q[head];
+                for (size_t e = rOffs[u]; e < rOffs[u + 1]; ++e) {
+                    I w = rTargs[e];
+                    I pw = part[w].load(memory_order_relaxed);
+                    if (pw == F || pw == L) {
+                        part[w].store(pw == F ? S : B, memory_order_relaxed);
+                        q.push_back(w);
+                    }
+                }
+            }
+
+            I id = newId();
+            Piece pf{ F, {} }, pb{ B, {} }, pr{ L, {} };
+            for (I v : rest) {
+                I pv = part[v].load(memory_order_relaxed);
+                if (pv == S)
+                    comp[v] = id;
+                else if (pv == F)
+                    pf.verts.push_back(v);
+                else if (pv == B)
+                    pb.verts.push_back(v);
+                else
+                    pr.verts.push_back(v);
+            }
+            lock_guard<mutex> lk(nextLock);
+            for (Piece* p : { &pf, &pb, &pr })
+                if (!p->verts.empty())
+                    next.push_back(move(*p));
+        });
+        work = move(next);
+    }
+    return comp_detail::Canonical(move(comp));
+}
+
+/// <summary>
+/// Слабо связные компоненты: система непересекающихся множеств без блокировок.
+/// forEachOut(u, f(v)) перечисляет исходящие рёбра вершины u; при наличии пула
+/// вершины обрабатываются параллельно.
+/// Сложность: O((V + E) * alpha(V)) для списков смежности
+/// </summary>
+template <typename I, typename ForEachOut>
+Components<I> WccUnionFind(size_t n, ForEachOut forEachOut, ThreadPool* pool = nullptr) {
+    vector<atomic<I>> parent(n);
+    for (size_t v = 0; v < n; ++v)
+        parent[v].store(static_cast<I>(v), memory_order_relaxed);
+
+    auto link = [&](size_t u, unsigned) {
+        forEachOut(static_cast<I>(u), [&](I v) {
+            comp_detail::Union(parent, static_cast<I>(u), v);
+        });
+    };
+    if (pool)
+        pool->ParallelFor(0, n, 64, link);
+    else
+        for (size_t u = 0; u < n; ++u)
+            link(u, 0);
+
+    vector<I> comp(n);
+    for (size_t v = 0; v < n; ++v)
+        comp[v] = comp_detail::Find(parent, static_cast<I>(v));
+    return comp_detail::Canonical(move(comp));
+}
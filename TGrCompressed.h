@@ -0,0 +1,453 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "TGrIndex.h"
+#include "TGrStorage.h"
+
+using namespace std;
+
+/// <summary>
+/// Хранение весов в CompressedDGraph
+/// </summary>
+enum class WeightMode : unsigned char {
+    Exact,      // точные веса отдельным столбцом
+    Quantized,  // 16-битное линейное квантование между наименьшим и наибольшим весом
+    Dropped     // веса не хранятся, GetWeight недоступен
+};
+
+/// <summary>
+/// Параметры сжатия DGraph::Compress
+/// </summary>
+struct CompressOptions {
+    /// <summary>
+    /// хранение весов
+    /// </summary>
+    WeightMode weights = WeightMode::Exact;
+
+    /// <summary>
+    /// хранить сжатые входящие рёбра (для GetNeighbors за O(deg) вместо O(V + E))
+    /// </summary>
+    bool reverse = true;
+};
+
+namespace compress_detail {
+
+    /// <summary>
+    /// Запись беззнакового числа в формате varint (7 бит на байт, старший бит - продолжение)
+    /// </summary>
+    inline void PutVarint(vector<uint8_t>& out, uint64_t x) {
+        while (x >= 0x80) {
+            out.push_back(static_cast<uint8_t>(x | 0x80));
+            x >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(x));
+    }
+
+    /// <summary>
+    /// Чтение varint, p сдвигается за прочитанное число
+    /// </summary>
+    inline uint64_t GetVarint(const uint8_t*& p) {
+        uint64_t x = *p & 0x7f;
+        for (int shift = 7; *p++ & 0x80; shift += 7)
+            x |= static_cast<uint64_t>(*p & 0x7f) << shift;
+        return x;
+    }
+
+    inline uint64_t ZigZag(int64_t x) {
+        return (static_cast<uint64_t>(x) << 1) ^ static_cast<uint64_t>(x >> 63);
+    }
+
+    inline int64_t UnZigZag(uint64_t x) {
+        return static_cast<int64_t>(x >> 1) ^ -static_cast<int64_t>(x & 1);
+    }
+
+    /// <summary>
+    /// Сжатые строки смежности: для строки u первый сосед хранится как zigzag(v0 - u),
+    /// следующие - как разность с предыдущим минус 1 (соседи по возрастанию)
+    /// </summary>
+    template <typename I>
+    struct Rows {
+        vector<uint8_t> bytes;
+        vector<uint64_t> offsets; // начала строк в bytes, размер V + 1
+
+        template <typename F>
+        void Decode(I u, F f) const {
+            const uint8_t* p = bytes.data() + offsets[u];
+            const uint8_t* end = bytes.data() + offsets[u + 1];
+            if (p == end)
+                return;
+            int64_t v = static_cast<int64_t>(u) + UnZigZag(GetVarint(p));
+            f(static_cast<I>(v));
+            while (p != end) {
+                v += static_cast<int64_t>(GetVarint(p)) + 1;
+                f(static_cast<I>(v));
+            }
+        }
+
+        void Encode(I u, const I* first, const I* last) {
+            if (first != last) {
+                PutVarint(bytes, ZigZag(static_cast<int64_t>(*first) - static_cast<int64_t>(u)));
+                for (const I* it = first + 1; it != last; ++it)
+                    PutVarint(bytes, static_cast<uint64_t>(*it - *(it - 1) - 1));
+            }
+            offsets.push_back(bytes.size());
+        }
+
+        size_t MemoryBytes() const {
+            return bytes.capacity() + offsets.capacity() * sizeof(uint64_t);
+        }
+    };
+}
+
+/// <summary>
+/// Сжатый неизменяемый граф для больших разреженных графов (результат DGraph::Compress).
+/// Соседи каждой вершины упорядочены и хранятся разностями в формате varint;
+/// веса - отдельным столбцом, точно или с 16-битным квантованием, либо не хранятся.
+/// BFS, DFS и GetNeighbors распаковывают строки на лету. Все методы константные,
+/// граф можно использовать из нескольких потоков без блокировок.
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename T, typename W, typename I = int>
+class CompressedDGraph {
+private:
+
+    /// <summary>
+    /// список вершин (в порядке индексов исходного графа)
+    /// </summary>
+    vector<T> vertices;
+
+    /// <summary>
+    /// отображение вершины в индекс
+    /// </summary>
+    FlatIndex<T, I> indexMap;
+
+    /// <summary>
+    /// исходящие рёбра
+    /// </summary>
+    compress_detail::Rows<I> out;
+
+    /// <summary>
+    /// входящие рёбра (пусто, если не хранятся)
+    /// </summary>
+    compress_detail::Rows<I> in;
+
+    /// <summary>
+    /// номер первого ребра строки в столбце весов, размер V + 1
+    /// </summary>
+    vector<uint64_t> edgeOffsets;
+
+    /// <summary>
+    /// точные веса (WeightMode::Exact)
+    /// </summary>
+    vector<W> exact;
+
+    /// <summary>
+    /// квантованные веса (WeightMode::Quantized): w = low + q * step
+    /// </summary>
+    vector<uint16_t> quantized;
+    double low = 0, step = 0;
+
+    WeightMode mode;
+    size_t edges = 0;
+
+    I Require(const T& v, const char* what) const {
+        I i = indexMap.Find(v, vertices);
+        if (i < 0)
+            throw runtime_error(string(what) + ": вершина не найдена");
+        return i;
+    }
+
+    W WeightAt(uint64_t e) const {
+        if (mode == WeightMode::Exact)
+            return exact[e];
+        return Dequantize(quantized[e]);
+    }
+
+    template <typename X = W>
+    typename enable_if<is_arithmetic<X>::value, X>::type Dequantize(uint16_t q) const {
+        double w = low + q * step;
+        return is_integral<X>::value ? static_cast<X>(llround(w)) : static_cast<X>(w);
+    }
+
+    template <typename X = W>
+    typename enable_if<!is_arithmetic<X>::value, X>::type Dequantize(uint16_t) const {
+        return X();
+    }
+
+    template <typename X = W>
+    typename enable_if<is_arithmetic<X>::value>::type Quantize(const vector<W>& ws) {
+        if (ws.empty())
+            return;
+        auto mm = minmax_element(ws.begin(), ws.end());
+        low = static_cast<double>(*mm.first);
+        step = (static_cast<double>(*mm.second) - low) / 65535.0;
+        quantized.reserve(ws.size());
+        for (const W& w : ws)
+            quantized.push_back(static_cast<uint16_t>(step > 0 ? llround((static_cast<double>(w) - low) / step) : 0));
+    }
+
+    template <typename X = W>
+    typename enable_if<!is_arithmetic<X>::value>::type Quantize(const vector<W>&) {
+        mode = WeightMode::Dropped;
+    }
+
+public:
+
+    /// <summary>
+    /// Построение из CSR (используется DGraph::Compress)
+    /// </summary>
+    /// <param name="keys">вершины</param>
+    /// <param name="offs">начала строк, размер V + 1</param>
+    /// <param name="targs">приёмники, по возрастанию внутри строки</param>
+    /// <param name="ws">веса параллельно targs</param>
+    /// <param name="opt">параметры сжатия</param>
+    CompressedDGraph(vector<T> keys, const vector<size_t>& offs, const vector<I>& targs,
+        const vector<W>& ws, const CompressOptions& opt = CompressOptions())
+        : vertices(move(keys)), mode(opt.weights), edges(targs.size()) {
+        indexMap.Rebuild(vertices, vertices.size());
+        size_t n = vertices.size();
+
+        out.offsets.push_back(0);
+        for (size_t u = 0; u < n; ++u)
+            out.Encode(static_cast<I>(u), targs.data() + offs[u], targs.data() + offs[u + 1]);
+        out.bytes.shrink_to_fit();
+
+        if (opt.reverse) {
+            // входящие строки подсчётом: источники получаются по возрастанию
+            vector<size_t> rOffs(n + 1, 0);
+            for (I v : targs)
+                ++rOffs[v + 1];
+            for (size_t i = 0; i < n; ++i)
+                rOffs[i + 1] += rOffs[i];
+            vector<I> srcs(targs.size());
+            vector<size_t> pos(rOffs.begin(), rOffs.end() - 1);
+            for (size_t u = 0; u < n; ++u)
+                for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                    srcs[pos[targs[e]]++] = static_cast<I>(u);
+            in.offsets.push_back(0);
+            for (size_t v = 0; v < n; ++v)
+                in.Encode(static_cast<I>(v), srcs.data() + rOffs[v], srcs.data() + rOffs[v + 1]);
+            in.bytes.shrink_to_fit();
+        }
+
+        if (is_same<W, Unweighted>::value)
+            mode = WeightMode::Dropped;
+        if (mode != WeightMode::Dropped)
+            edgeOffsets.assign(offs.begin(), offs.end());
+        if (mode == WeightMode::Exact)
+            exact = ws;
+        else if (mode == WeightMode::Quantized)
+            Quantize(ws);
+    }
+
+    /// <summary>
+    /// Размер графа
+    /// </summary>
+    /// <returns>количество вершин в графе</returns>
+    int Size() const {
+        return static_cast<int>(vertices.size());
+    }
+
+    /// <summary>
+    /// Количество рёбер
+    /// </summary>
+    size_t EdgeCount() const {
+        return edges;
+    }
+
+    /// <summary>
+    /// Хранение весов
+    /// </summary>
+    WeightMode Weights() const {
+        return mode;
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return vertices.capacity() * sizeof(T) + indexMap.MemoryBytes() + out.MemoryBytes() + in.MemoryBytes()
+            + edgeOffsets.capacity() * sizeof(uint64_t) + exact.capacity() * sizeof(W)
+            + quantized.capacity() * sizeof(uint16_t);
+    }
+
+    /// <summary>
+    /// Память под рёбра (строки и веса), байт на ребро
+    /// </summary>
+    double BytesPerEdge() const {
+        size_t bytes = out.MemoryBytes() + in.MemoryBytes() + edgeOffsets.capacity() * sizeof(uint64_t)
+            + exact.capacity() * sizeof(W) + quantized.capacity() * sizeof(uint16_t);
+        return edges ? static_cast<double>(bytes) / edges : 0.0;
+    }
+
+    /// <summary>
+    /// Проверка существования вершины
+    /// </summary>
+    bool HasVert(const T& v) const {
+        return indexMap.Find(v, vertices) >= 0;
+    }
+
+    /// <summary>
+    /// Проверка существования ребра
+    /// Сложность: O(deg(from))
+    /// </summary>
+    bool HasEdge(const T& from, const T& to) const {
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            return false;
+        bool found = false;
+        out.Decode(u, [&](I x) { found = found || x == v; });
+        return found;
+    }
+
+    /// <summary>
+    /// Вес ребра (при квантовании - приближённый, погрешность не больше (max - min) / 131070)
+    /// Сложность: O(deg(from))
+    /// </summary>
+    /// <exception cref="runtime_error - одна из вершин или ребро не существует, либо веса не хранятся">
+    /// </exception>
+    W GetWeight(const T& from, const T& to) const {
+        I u = Require(from, "GetWeight");
+        I v = Require(to, "GetWeight");
+        if (mode == WeightMode::Dropped)
+            throw runtime_error("GetWeight: веса не хранятся");
+        long long pos = -1, k = 0;
+        out.Decode(u, [&](I x) {
+            if (x == v)
+                pos = k;
+            ++k;
+        });
+        if (pos < 0)
+            throw runtime_error("GetWeight: ребро отсутствует");
+        return WeightAt(edgeOffsets[u] + pos);
+    }
+
+    /// <summary>
+    /// Вес ребра (синоним GetWeight, как у DGraph)
+    /// </summary>
+    W GetEdge(const T& from, const T& to) const {
+        return GetWeight(from, to);
+    }
+
+    /// <summary>
+    /// Исходящие рёбра вершины с индексом u по возрастанию индекса: f(v, w).
+    /// При WeightMode::Dropped w = W().
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        if (mode == WeightMode::Dropped) {
+            out.Decode(u, [&](I v) { f(v, W()); });
+            return;
+        }
+        uint64_t e = edgeOffsets[u];
+        out.Decode(u, [&](I v) { f(v, WeightAt(e++)); });
+    }
+
+    /// <summary>
+    /// Обход в ширину (BFS), порядок совпадает с DGraph::BFS
+    /// Сложность: O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> BFS(const T& start) const {
+        I s = Require(start, "BFS");
+        vector<char> seen(vertices.size(), 0);
+        vector<I> q;
+        q.reserve(vertices.size());
+        vector<T> order;
+
+        q.push_back(s);
+        seen[s] = 1;
+        for (size_t head = 0; head < q.size(); ++head) {
+            I u = q[head];
+            order.push_back(vertices[u]);
+            out.Decode(u, [&](I v) {
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    q.push_back(v);
+                }
+            });
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Обход в глубину (DFS), порядок совпадает с DGraph::DFS
+    /// Сложность: O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> DFS(const T& start) const {
+        I s = Require(start, "DFS");
+        vector<char> visited(vertices.size(), 0);
+        vector<I> st;
+        vector<T> order;
+
+        st.push_back(s);
+        while (!st.empty()) {
+            I u = st.back();
+            st.pop_back();
+            if (visited[u])
+                continue;
+            visited[u] = 1;
+            order.push_back(vertices[u]);
+            out.Decode(u, [&](I v) {
+                if (!visited[v])
+                    st.push_back(v);
+            });
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Соседи вершины в любом направлении, по возрастанию индекса (как DGraph::GetNeighbors)
+    /// Сложность: O(deg) при хранении входящих рёбер, иначе O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - вершина не существует">
+    /// </exception>
+    vector<T> GetNeighbors(const T& vertex) const {
+        I u = Require(vertex, "GetNeighbors");
+        vector<I> idx;
+        out.Decode(u, [&](I v) { idx.push_back(v); });
+        size_t mid = idx.size();
+        if (!in.offsets.empty())
+            in.Decode(u, [&](I v) { idx.push_back(v); });
+        else {
+            for (I w = 0; w < static_cast<I>(vertices.size()); ++w)
+                out.Decode(w, [&](I v) {
+                    if (v == u)
+                        idx.push_back(w);
+                });
+        }
+        inplace_merge(idx.begin(), idx.begin() + mid, idx.end());
+        idx.erase(unique(idx.begin(), idx.end()), idx.end());
+
+        vector<T> neighbors;
+        neighbors.reserve(idx.size());
+        for (I v : idx)
+            neighbors.push_back(vertices[v]);
+        return neighbors;
+    }
+
+    /// <summary>
+    /// Индекс вершины или -1
+    /// </summary>
+    I IndexOf(const T& v) const {
+        return indexMap.Find(v, vertices);
+    }
+
+    /// <summary>
+    /// Вершина по индексу
+    /// </summary>
+    const T& VertexAt(I i) const {
+        return vertices[i];
+    }
+};
@@ -0,0 +1,476 @@
+#pragma once
+
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <fstream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace std;
+
+namespace external_detail {
+
+    /// <summary>
+    /// Заголовок файла рёбер. За ним следуют:
+    /// offsets[V + 1] (uint64_t) - начала строк, targets[E] (I) - приёмники, weights[E] (W) - веса.
+    /// Приёмники и веса хранятся раздельно, чтобы обходы без весов не читали веса с диска.
+    /// </summary>
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t indexBytes;
+        uint32_t weightBytes;
+        uint64_t vertices;
+        uint64_t edges;
+    };
+
+    const char MAGIC[4] = { 'T', 'G', 'R', 'E' };
+    const uint32_t VERSION = 1;
+
+    inline uint64_t TargetsAt(uint64_t vertices) {
+        return sizeof(Header) + (vertices + 1) * sizeof(uint64_t);
+    }
+}
+
+/// <summary>
+/// Кэш страниц файла ограниченного размера с вытеснением давно не использованных (LRU).
+/// В памяти одновременно находится не более maxPages страниц, поэтому объём
+/// используемой памяти не зависит от размера файла. Не потокобезопасен.
+/// </summary>
+class PageCache {
+public:
+
+    /// <summary>
+    /// Конструктор
+    /// </summary>
+    /// <param name="path">путь к файлу</param>
+    /// <param name="pageBytes">размер страницы, байт</param>
+    /// <param name="maxPages">наибольшее число страниц в памяти</param>
+    /// <exception cref="runtime_error - не удалось открыть файл">
+    /// </exception>
+    PageCache(const string& path, size_t pageBytes, size_t maxPages)
+        : file(path, ios::binary), pageBytes(max<size_t>(pageBytes, 64)), maxPages(max<size_t>(maxPages, 1)) {
+        if (!file.is_open())
+            throw runtime_error("PageCache: не удалось открыть файл " + path);
+        file.seekg(0, ios::end);
+        fileBytes = static_cast<uint64_t>(file.tellg());
+    }
+
+    /// <summary>
+    /// Чтение bytes байт со смещения offset (может захватывать несколько страниц)
+    /// </summary>
+    /// <exception cref="runtime_error - чтение за концом файла">
+    /// </exception>
+    void Read(uint64_t offset, void* dst, size_t bytes) {
+        if (offset + bytes > fileBytes)
+            throw runtime_error("PageCache: чтение за концом файла");
+        char* out = static_cast<char*>(dst);
+        while (bytes > 0) {
+            uint64_t no = offset / pageBytes;
+            size_t in = static_cast<size_t>(offset % pageBytes);
+            size_t take = min(bytes, pageBytes - in);
+            memcpy(out, Page(no) + in, take);
+            out += take;
+            offset += take;
+            bytes -= take;
+        }
+    }
+
+    /// <summary>
+    /// Размер файла, байт
+    /// </summary>
+    uint64_t FileBytes() const {
+        return fileBytes;
+    }
+
+    /// <summary>
+    /// Наибольший объём страниц в памяти, байт
+    /// </summary>
+    size_t CapacityBytes() const {
+        return pageBytes * maxPages;
+    }
+
+    /// <summary>
+    /// Объём страниц в памяти сейчас, байт
+    /// </summary>
+    size_t ResidentBytes() const {
+        return pages.size() * pageBytes;
+    }
+
+    /// <summary>
+    /// Обращения к страницам, найденным в кэше
+    /// </summary>
+    uint64_t Hits() const {
+        return hits;
+    }
+
+    /// <summary>
+    /// Обращения, потребовавшие чтения с диска
+    /// </summary>
+    uint64_t Misses() const {
+        return misses;
+    }
+
+    /// <summary>
+    /// Прочитано с диска, байт
+    /// </summary>
+    uint64_t BytesRead() const {
+        return bytesRead;
+    }
+
+private:
+
+    struct Slot {
+        vector<char> data;
+        list<uint64_t>::iterator pos;
+    };
+
+    ifstream file;
+    size_t pageBytes;
+    size_t maxPages;
+    uint64_t fileBytes = 0;
+
+    /// <summary>
+    /// номера страниц от недавно использованных к давно использованным
+    /// </summary>
+    list<uint64_t> lru;
+    unordered_map<uint64_t, Slot> pages;
+    uint64_t hits = 0, misses = 0, bytesRead = 0;
+
+    const char* Page(uint64_t no) {
+        auto it = pages.find(no);
+        if (it != pages.end()) {
+            ++hits;
+            lru.splice(lru.begin(), lru, it->second.pos);
+            return it->second.data.data();
+        }
+
+        ++misses;
+        vector<char> data;
+        if (pages.size() >= maxPages) {
+            // вытесняем давно не использованную страницу и переиспользуем её буфер
+            auto victim = pages.find(lru.back());
+            data.swap(victim->second.data);
+            pages.erase(victim);
+            lru.pop_back();
+        }
+        data.resize(pageBytes);
+        uint64_t at = no * pageBytes;
+        size_t len = static_cast<size_t>(min<uint64_t>(pageBytes, fileBytes - at));
+        file.clear();
+        file.seekg(static_cast<streamoff>(at));
+        file.read(data.data(), static_cast<streamsize>(len));
+        if (static_cast<size_t>(file.gcount()) != len)
+            throw runtime_error("PageCache: ошибка чтения");
+        bytesRead += len;
+
+        lru.push_front(no);
+        Slot& slot = pages[no];
+        slot.data.swap(data);
+        slot.pos = lru.begin();
+        return slot.data.data();
+    }
+};
+
+/// <summary>
+/// Потоковая запись файла рёбер. Рёбра подаются по неубыванию вершины-источника,
+/// поэтому в памяти держится только массив начал строк (O(V)), а не сами рёбра.
+/// Веса пишутся во временный файл и дописываются в конец при Close.
+/// </summary>
+/// <typeparam name="W">тип весов (тривиально копируемый)</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename W, typename I = int>
+class EdgeFileWriter {
+    static_assert(is_trivially_copyable<W>::value, "EdgeFileWriter: вес должен быть тривиально копируемым");
+
+public:
+
+    /// <summary>
+    /// Конструктор
+    /// </summary>
+    /// <param name="path">путь к создаваемому файлу</param>
+    /// <param name="vertices">количество вершин</param>
+    /// <exception cref="runtime_error - не удалось создать файл">
+    /// </exception>
+    EdgeFileWriter(const string& path, uint64_t vertices)
+        : path(path), out(path, ios::binary | ios::trunc), side(path + ".w", ios::binary | ios::trunc),
+          offsets(vertices + 1, 0) {
+        if (!out.is_open() || !side.is_open())
+            throw runtime_error("EdgeFileWriter: не удалось создать файл " + path);
+        out.seekp(static_cast<streamoff>(external_detail::TargetsAt(vertices)));
+    }
+
+    EdgeFileWriter(const EdgeFileWriter&) = delete;
+    EdgeFileWriter& operator=(const EdgeFileWriter&) = delete;
+
+    ~EdgeFileWriter() {
+        if (!closed) {
+            try {
+                Close();
+            }
+            catch (...) {
+
+            }
+        }
+    }
+
+    /// <summary>
+    /// Добавление ребра
+    /// </summary>
+    /// <exception cref="runtime_error - вершина вне диапазона или источник меньше предыдущего">
+    /// </exception>
+    void Add(I from, I to, const W& w) {
+        uint64_t n = offsets.size() - 1;
+        if (from < 0 || to < 0 || static_cast<uint64_t>(from) >= n || static_cast<uint64_t>(to) >= n)
+            throw runtime_error("EdgeFileWriter: вершина вне диапазона");
+        if (from < last)
+            throw runtime_error("EdgeFileWriter: рёбра должны идти по неубыванию источника");
+        last = from;
+        ++offsets[static_cast<size_t>(from) + 1];
+        out.write(reinterpret_cast<const char*>(&to), sizeof(I));
+        side.write(reinterpret_cast<const char*>(&w), sizeof(W));
+        ++edges;
+    }
+
+    /// <summary>
+    /// Завершение записи: веса, начала строк и заголовок
+    /// </summary>
+    void Close() {
+        if (closed)
+            return;
+        closed = true;
+        side.close();
+        ifstream ws(path + ".w", ios::binary);
+        vector<char> buf(1 << 16);
+        while (ws.read(buf.data(), buf.size()) || ws.gcount() > 0)
+            out.write(buf.data(), ws.gcount());
+        ws.close();
+        remove((path + ".w").c_str());
+
+        for (size_t i = 1; i < offsets.size(); ++i)
+            offsets[i] += offsets[i - 1];
+        external_detail::Header h;
+        memcpy(h.magic, external_detail::MAGIC, 4);
+        h.version = external_detail::VERSION;
+        h.indexBytes = sizeof(I);
+        h.weightBytes = sizeof(W);
+        h.vertices = offsets.size() - 1;
+        h.edges = edges;
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint64_t));
+        out.close();
+        if (out.fail())
+            throw runtime_error("EdgeFileWriter: ошибка записи " + path);
+    }
+
+private:
+    string path;
+    ofstream out;
+    ofstream side;
+    vector<uint64_t> offsets;
+    uint64_t edges = 0;
+    I last = 0;
+    bool closed = false;
+};
+
+/// <summary>
+/// Граф на диске (внешняя память). Рёбра читаются через кэш страниц ограниченного размера;
+/// в памяти держатся только массивы по вершинам (полувнешняя модель: O(V) памяти, рёбра на диске).
+/// Алгоритмы BFS и BellmanFord работают проходами по файлу рёбер подряд, без произвольного доступа.
+/// Не потокобезопасен.
+/// </summary>
+/// <typeparam name="W">тип весов</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename W, typename I = int>
+class DiskGraph {
+public:
+
+    /// <summary>
+    /// Открытие файла рёбер
+    /// </summary>
+    /// <param name="path">путь к файлу</param>
+    /// <param name="cacheBytes">наибольший объём кэша страниц, байт</param>
+    /// <param name="pageBytes">размер страницы, байт</param>
+    /// <exception cref="runtime_error - файл не открывается или имеет неверный формат">
+    /// </exception>
+    DiskGraph(const string& path, size_t cacheBytes = 64u << 20, size_t pageBytes = 64u << 10)
+        : cache(path, pageBytes, max<size_t>(4, cacheBytes / max<size_t>(pageBytes, 64))) {
+        if (cache.FileBytes() < sizeof(h))
+            throw runtime_error("DiskGraph: неверный формат файла");
+        cache.Read(0, &h, sizeof(h));
+        if (memcmp(h.magic, external_detail::MAGIC, 4) != 0 || h.version != external_detail::VERSION
+            || h.indexBytes != sizeof(I) || h.weightBytes != sizeof(W))
+            throw runtime_error("DiskGraph: неверный формат файла");
+        targetsAt = external_detail::TargetsAt(h.vertices);
+        weightsAt = targetsAt + h.edges * sizeof(I);
+        if (cache.FileBytes() != weightsAt + h.edges * sizeof(W))
+            throw runtime_error("DiskGraph: файл повреждён");
+    }
+
+    /// <summary>
+    /// Количество вершин
+    /// </summary>
+    I Size() const {
+        return static_cast<I>(h.vertices);
+    }
+
+    /// <summary>
+    /// Количество рёбер
+    /// </summary>
+    uint64_t EdgeCount() const {
+        return h.edges;
+    }
+
+    /// <summary>
+    /// Кэш страниц (статистика попаданий и прочитанных байт)
+    /// </summary>
+    const PageCache& Cache() const {
+        return cache;
+    }
+
+    /// <summary>
+    /// Количество проходов по файлу рёбер в последнем BFS / BellmanFord
+    /// </summary>
+    int LastPasses() const {
+        return passes;
+    }
+
+    /// <summary>
+    /// Исходящие рёбра вершины u (произвольный доступ): f(v, w)
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) {
+        Check(u);
+        uint64_t range[2];
+        cache.Read(sizeof(h) + static_cast<uint64_t>(u) * sizeof(uint64_t), range, sizeof(range));
+        size_t deg = static_cast<size_t>(range[1] - range[0]);
+        rowTargets.resize(deg);
+        rowWeights.resize(deg);
+        if (deg == 0)
+            return;
+        cache.Read(targetsAt + range[0] * sizeof(I), rowTargets.data(), deg * sizeof(I));
+        cache.Read(weightsAt + range[0] * sizeof(W), rowWeights.data(), deg * sizeof(W));
+        for (size_t i = 0; i < deg; ++i)
+            f(rowTargets[i], rowWeights[i]);
+    }
+
+    /// <summary>
+    /// Проход по всем рёбрам подряд: f(u, v, w). Если withWeights = false, веса не читаются
+    /// и передаются как W().
+    /// Сложность: O(V + E) последовательного чтения
+    /// </summary>
+    template <typename F>
+    void ScanEdges(F f, bool withWeights = true) {
+        const size_t CHUNK = 4096;
+        vector<uint64_t> offs(CHUNK + 1);
+        vector<I> ts(CHUNK);
+        vector<W> ws(CHUNK);
+        uint64_t n = h.vertices;
+
+        uint64_t e = 0, bufStart = 0, bufEnd = 0;
+        auto load = [&](uint64_t from) {
+            bufStart = from;
+            bufEnd = min<uint64_t>(h.edges, from + CHUNK);
+            size_t cnt = static_cast<size_t>(bufEnd - bufStart);
+            if (cnt == 0)
+                return;
+            cache.Read(targetsAt + bufStart * sizeof(I), ts.data(), cnt * sizeof(I));
+            if (withWeights)
+                cache.Read(weightsAt + bufStart * sizeof(W), ws.data(), cnt * sizeof(W));
+        };
+
+        for (uint64_t u0 = 0; u0 < n; u0 += CHUNK) {
+            uint64_t cnt = min<uint64_t>(CHUNK, n - u0);
+            cache.Read(sizeof(h) + u0 * sizeof(uint64_t), offs.data(), static_cast<size_t>(cnt + 1) * sizeof(uint64_t));
+            for (uint64_t k = 0; k < cnt; ++k) {
+                I u = static_cast<I>(u0 + k);
+                for (; e < offs[static_cast<size_t>(k) + 1]; ++e) {
+                    if (e >= bufEnd)
+                        load(e);
+                    size_t at = static_cast<size_t>(e - bufStart);
+                    f(u, ts[at], withWeights ? ws[at] : W());
+                }
+            }
+        }
+    }
+
+    /// <summary>
+    /// Полувнешний BFS: уровни обрабатываются проходами по файлу рёбер;
+    /// за проход уровень L + 1 получают приёмники рёбер, выходящих из уровня L.
+    /// Сложность: O((V + E) * (глубина + 1)) последовательного чтения, O(V) памяти
+    /// </summary>
+    /// <param name="source">индекс начальной вершины</param>
+    /// <returns>число рёбер кратчайшего пути до каждой вершины, -1 - недостижима</returns>
+    /// <exception cref="runtime_error - вершина вне диапазона">
+    /// </exception>
+    vector<I> BFS(I source) {
+        Check(source);
+        vector<I> level(static_cast<size_t>(h.vertices), -1);
+        level[source] = 0;
+        passes = 0;
+        for (I cur = 0;; ++cur) {
+            bool grew = false;
+            ++passes;
+            ScanEdges([&](I u, I v, const W&) {
+                if (level[u] == cur && level[v] < 0) {
+                    level[v] = cur + 1;
+                    grew = true;
+                }
+            }, false);
+            if (!grew)
+                break;
+        }
+        return level;
+    }
+
+    /// <summary>
+    /// Полувнешний алгоритм Форда-Беллмана: релаксация всех рёбер за проход по файлу,
+    /// остановка после прохода без улучшений.
+    /// Сложность: O((V + E) * число проходов) последовательного чтения, не более V проходов
+    /// </summary>
+    /// <param name="source">индекс начальной вершины</param>
+    /// <param name="inf">обозначение недостижимой вершины</param>
+    /// <returns>длины кратчайших путей по индексам вершин</returns>
+    /// <exception cref="runtime_error - вершина вне диапазона или обнаруживается отрицательный цикл">
+    /// </exception>
+    vector<W> BellmanFord(I source, W inf) {
+        Check(source);
+        vector<W> dist(static_cast<size_t>(h.vertices), inf);
+        dist[source] = W(0);
+        passes = 0;
+        for (uint64_t k = 0; k < h.vertices; ++k) {
+            bool changed = false;
+            ++passes;
+            ScanEdges([&](I u, I v, const W& w) {
+                if (dist[u] != inf && dist[v] > dist[u] + w) {
+                    dist[v] = dist[u] + w;
+                    changed = true;
+                }
+            });
+            if (!changed)
+                return dist;
+        }
+        throw runtime_error("Обнаружен отрицательный цикл!");
+    }
+
+private:
+    PageCache cache;
+    external_detail::Header h;
+    uint64_t targetsAt = 0;
+    uint64_t weightsAt = 0;
+    int passes = 0;
+    vector<I> rowTargets;
+    vector<W> rowWeights;
+
+    void Check(I u) const {
+        if (u < 0 || static_cast<uint64_t>(u) >= h.vertices)
+            throw runtime_error("DiskGraph: вершина вне диапазона");
+    }
+};
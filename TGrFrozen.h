@@ -0,0 +1,331 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <stack>
+#include <algorithm>
+#include <stdexcept>
+#include "TGrIndex.h"
+
+using namespace std;
+
+/// <summary>
+/// Неизменяемый граф, оптимизированный для запросов (результат DGraph::Freeze).
+/// Рёбра хранятся в упакованном виде CSR: для вершины u её соседи лежат подряд
+/// в targets[offsets[u] .. offsets[u + 1]) по возрастанию индекса, веса - в отдельном
+/// массиве weights. Для GetNeighbors хранится также обратный CSR (входящие рёбра).
+/// Все методы константные и не имеют изменяемого состояния, поэтому
+/// граф можно без блокировок использовать из нескольких потоков.
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename T, typename W, typename I = int>
+class FrozenDGraph {
+private:
+
+    /// <summary>
+    /// список вершин (в порядке индексов исходного графа)
+    /// </summary>
+    vector<T> vertices;
+
+    /// <summary>
+    /// отображение вершины в индекс
+    /// </summary>
+    FlatIndex<T, I> indexMap;
+
+    /// <summary>
+    /// начала строк исходящих рёбер, размер V + 1
+    /// </summary>
+    vector<size_t> offsets;
+
+    /// <summary>
+    /// приёмники исходящих рёбер, по возрастанию внутри строки
+    /// </summary>
+    vector<I> targets;
+
+    /// <summary>
+    /// веса исходящих рёбер (параллельно targets)
+    /// </summary>
+    vector<W> weights;
+
+    /// <summary>
+    /// начала строк входящих рёбер, размер V + 1
+    /// </summary>
+    vector<size_t> inOffsets;
+
+    /// <summary>
+    /// источники входящих рёбер, по возрастанию внутри строки
+    /// </summary>
+    vector<I> sources;
+
+    /// <summary>
+    /// обозначение "нет ребра" / недостижимой вершины
+    /// </summary>
+    W INF;
+
+    /// <summary>
+    /// позиция ребра u->v в targets или -1
+    /// Сложность: O(log deg(u))
+    /// </summary>
+    long long Find(I u, I v) const {
+        auto first = targets.begin() + offsets[u];
+        auto last = targets.begin() + offsets[u + 1];
+        auto it = lower_bound(first, last, v);
+        if (it == last || *it != v)
+            return -1;
+        return static_cast<long long>(it - targets.begin());
+    }
+
+    I Require(const T& v, const char* what) const {
+        I i = indexMap.Find(v, vertices);
+        if (i < 0)
+            throw runtime_error(string(what) + ": вершина не найдена");
+        return i;
+    }
+
+public:
+
+    /// <summary>
+    /// Построение из готового CSR (используется DGraph::Freeze)
+    /// </summary>
+    /// <param name="keys">вершины</param>
+    /// <param name="offs">начала строк, размер V + 1</param>
+    /// <param name="targs">приёмники, по возрастанию внутри строки</param>
+    /// <param name="ws">веса</param>
+    /// <param name="inf">обозначение "нет ребра"</param>
+    FrozenDGraph(vector<T> keys, vector<size_t> offs, vector<I> targs, vector<W> ws, W inf)
+        : vertices(move(keys)), offsets(move(offs)), targets(move(targs)), weights(move(ws)), INF(inf) {
+        indexMap.Rebuild(vertices, vertices.size());
+
+        // обратный CSR подсчётом: источники в каждой строке получаются по возрастанию
+        size_t n = vertices.size();
+        inOffsets.assign(n + 1, 0);
+        for (I v : targets)
+            ++inOffsets[v + 1];
+        for (size_t i = 0; i < n; ++i)
+            inOffsets[i + 1] += inOffsets[i];
+        sources.resize(targets.size());
+        vector<size_t> pos(inOffsets.begin(), inOffsets.end() - 1);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offsets[u]; e < offsets[u + 1]; ++e)
+                sources[pos[targets[e]]++] = static_cast<I>(u);
+    }
+
+    /// <summary>
+    /// Размер графа
+    /// </summary>
+    /// <returns>количество вершин в графе</returns>
+    int Size() const {
+        return static_cast<int>(vertices.size());
+    }
+
+    /// <summary>
+    /// Количество рёбер
+    /// </summary>
+    size_t EdgeCount() const {
+        return targets.size();
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return vertices.capacity() * sizeof(T) + indexMap.MemoryBytes()
+            + (offsets.capacity() + inOffsets.capacity()) * sizeof(size_t)
+            + (targets.capacity() + sources.capacity()) * sizeof(I) + weights.capacity() * sizeof(W);
+    }
+
+    /// <summary>
+    /// Проверка существования вершины
+    /// </summary>
+    bool HasVert(const T& v) const {
+        return indexMap.Find(v, vertices) >= 0;
+    }
+
+    /// <summary>
+    /// Проверка существования ребра
+    /// Сложность: O(log deg(from))
+    /// </summary>
+    bool HasEdge(const T& from, const T& to) const {
+        I u = indexMap.Find(from, vertices);
+        I v = indexMap.Find(to, vertices);
+        if (u < 0 || v < 0)
+            return false;
+        return Find(u, v) >= 0;
+    }
+
+    /// <summary>
+    /// Вес ребра
+    /// Сложность: O(log deg(from))
+    /// </summary>
+    /// <exception cref="runtime_error - одна из вершин не существует или ребро не существует">
+    /// </exception>
+    W GetWeight(const T& from, const T& to) const {
+        I u = Require(from, "GetWeight");
+        I v = Require(to, "GetWeight");
+        long long e = Find(u, v);
+        if (e < 0)
+            throw runtime_error("GetWeight: ребро отсутствует");
+        return weights[e];
+    }
+
+    /// <summary>
+    /// Вес ребра (синоним GetWeight, как у DGraph)
+    /// </summary>
+    W GetEdge(const T& from, const T& to) const {
+        return GetWeight(from, to);
+    }
+
+    /// <summary>
+    /// Обход в ширину (BFS), порядок совпадает с DGraph::BFS
+    /// Сложность: O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> BFS(const T& start) const {
+        I s = Require(start, "BFS");
+        vector<char> seen(vertices.size(), 0);
+        vector<I> q;
+        q.reserve(vertices.size());
+        vector<T> order;
+
+        q.push_back(s);
+        seen[s] = 1;
+        for (size_t head = 0; head < q.size(); ++head) {
+            I u = q[head];
+            order.push_back(vertices[u]);
+            for (size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                I v = targets[e];
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    q.push_back(v);
+                }
+            }
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Обход в глубину (DFS), порядок совпадает с DGraph::DFS
+    /// Сложность: O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не существует">
+    /// </exception>
+    vector<T> DFS(const T& start) const {
+        I s = Require(start, "DFS");
+        vector<char> visited(vertices.size(), 0);
+        vector<I> st;
+        vector<T> order;
+
+        st.push_back(s);
+        while (!st.empty()) {
+            I u = st.back();
+            st.pop_back();
+            if (visited[u])
+                continue;
+            visited[u] = 1;
+            order.push_back(vertices[u]);
+            for (size_t e = offsets[u]; e < offsets[u + 1]; ++e)
+                if (!visited[targets[e]])
+                    st.push_back(targets[e]);
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Алгоритм Форда-Беллмана. Останавливается досрочно, если проход не улучшил ни одного расстояния.
+    /// Сложность: O(V * E)
+    /// </summary>
+    /// <returns>длины кратчайших путей по индексам вершин (INF - недостижима)</returns>
+    /// <exception cref="runtime_error - начальная вершина не существует или обнаруживается отрицательный цикл">
+    /// </exception>
+    vector<W> BellmanFord(const T& start) const {
+        I s = Require(start, "BellmanFord");
+        size_t n = vertices.size();
+        vector<W> dist(n, INF);
+        dist[s] = 0;
+
+        for (size_t k = 0; k + 1 < n; ++k) {
+            bool changed = false;
+            for (size_t u = 0; u < n; ++u) {
+                if (dist[u] == INF)
+                    continue;
+                for (size_t e = offsets[u]; e < offsets[u + 1]; ++e) {
+                    I v = targets[e];
+                    if (dist[v] > dist[u] + weights[e]) {
+                        dist[v] = dist[u] + weights[e];
+                        changed = true;
+                    }
+                }
+            }
+            if (!changed)
+                break;
+        }
+
+        for (size_t u = 0; u < n; ++u) {
+            if (dist[u] == INF)
+                continue;
+            for (size_t e = offsets[u]; e < offsets[u + 1]; ++e)
+                if (dist[targets[e]] > dist[u] + weights[e])
+                    throw runtime_error("Обнаружен отрицательный цикл!");
+        }
+        return dist;
+    }
+
+    /// <summary>
+    /// Соседи вершины в любом направлении, по возрастанию индекса (как DGraph::GetNeighbors)
+    /// Сложность: O(deg)
+    /// </summary>
+    /// <exception cref="runtime_error - вершина не существует">
+    /// </exception>
+    vector<T> GetNeighbors(const T& vertex) const {
+        I u = Require(vertex, "GetNeighbors");
+        vector<T> neighbors;
+        size_t a = offsets[u], aEnd = offsets[u + 1];
+        size_t b = inOffsets[u], bEnd = inOffsets[u + 1];
+        // слияние двух упорядоченных строк без повторов
+        while (a < aEnd || b < bEnd) {
+            I v;
+            if (b == bEnd || (a < aEnd && targets[a] < sources[b]))
+                v = targets[a++];
+            else if (a == aEnd || sources[b] < targets[a])
+                v = sources[b++];
+            else {
+                v = targets[a++];
+                ++b;
+            }
+            neighbors.push_back(vertices[v]);
+        }
+        return neighbors;
+    }
+
+    /// <summary>
+    /// Индекс вершины или -1
+    /// </summary>
+    I IndexOf(const T& v) const {
+        return indexMap.Find(v, vertices);
+    }
+
+    /// <summary>
+    /// Вершина по индексу
+    /// </summary>
+    const T& VertexAt(I i) const {
+        return vertices[i];
+    }
+
+    /// <summary>
+    /// Исходящие рёбра вершины с индексом u: приёмники и веса
+    /// </summary>
+    const I* OutBegin(I u) const {
+        return targets.data() + offsets[u];
+    }
+
+    const I* OutEnd(I u) const {
+        return targets.data() + offsets[u + 1];
+    }
+
+    const W* OutWeights(I u) const {
+        return weights.data() + offsets[u];
+    }
+};
@@ -0,0 +1,400 @@
+#pragma once
+
+#include <vector>
+#include <random>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include "TGr.h"
+
+using namespace std;
+
+/// <summary>
+/// Ребро, построенное генератором: индексы концов и вес
+/// </summary>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+template <typename W>
+struct GenEdge {
+    int from;
+    int to;
+    W weight;
+
+    bool operator==(const GenEdge& o) const {
+        return from == o.from && to == o.to && weight == o.weight;
+    }
+};
+
+/// <summary>
+/// Распределение весов рёбер.
+/// Вес выбирается равномерно из [minW, maxW]. Если potential > 0, каждой вершине
+/// назначается случайный потенциал p из [0, potential] и вес ребра u->v заменяется на
+/// w + p(u) - p(v): рёбра становятся отрицательными, но сумма по любому циклу
+/// не меняется, поэтому отрицательных циклов не возникает (для стресс-тестов BellmanFord).
+/// </summary>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+template <typename W>
+struct GenWeights {
+    W minW = W(1);
+    W maxW = W(1);
+    W potential = W(0);
+};
+
+/// <summary>
+/// Параметры генерации
+/// </summary>
+struct GenOptions {
+    /// <summary>
+    /// зерно генератора; одинаковое зерно даёт одинаковый граф при любом числе потоков
+    /// </summary>
+    uint64_t seed = 1;
+
+    /// <summary>
+    /// число потоков, 0 - по числу ядер
+    /// </summary>
+    unsigned threads = 0;
+};
+
+namespace gen_detail {
+
+    /// <summary>
+    /// Размер блока работы. Результат зависит только от номера блока,
+    /// а не от того, какой поток его выполнил.
+    /// </summary>
+    const int BLOCK = 4096;
+
+    /// <summary>
+    /// Перемешивание SplitMix64, из него получаются независимые зёрна блоков
+    /// </summary>
+    inline uint64_t SplitMix(uint64_t x) {
+        x += 0x9E3779B97F4A7C15ull;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+        return x ^ (x >> 31);
+    }
+
+    /// <summary>
+    /// Генератор случайных чисел для блока block потока stream
+    /// </summary>
+    inline mt19937_64 BlockRng(const GenOptions& opt, uint64_t stream, uint64_t block) {
+        return mt19937_64(SplitMix(SplitMix(opt.seed ^ (stream << 56)) + block));
+    }
+
+    inline unsigned Threads(const GenOptions& opt) {
+        unsigned t = opt.threads ? opt.threads : thread::hardware_concurrency();
+        return t ? t : 1;
+    }
+
+    /// <summary>
+    /// Выполняет f(block) для всех блоков [0, blocks) на нескольких потоках
+    /// </summary>
+    template <typename F>
+    void ParallelBlocks(int blocks, const GenOptions& opt, F f) {
+        unsigned t = min<unsigned>(Threads(opt), static_cast<unsigned>(max(blocks, 1)));
+        if (t <= 1) {
+            for (int b = 0; b < blocks; ++b)
+                f(b);
+            return;
+        }
+        atomic<int> next(0);
+        vector<thread> pool;
+        for (unsigned i = 0; i < t; ++i) {
+            pool.emplace_back([&]() {
+                for (int b = next++; b < blocks; b = next++)
+                    f(b);
+            });
+        }
+        for (auto& th : pool)
+            th.join();
+    }
+
+    /// <summary>
+    /// Склеивает результаты блоков в порядке их номеров
+    /// </summary>
+    template <typename W>
+    vector<GenEdge<W>> Concat(vector<vector<GenEdge<W>>>& parts) {
+        size_t total = 0;
+        for (auto& p : parts)
+            total += p.size();
+        vector<GenEdge<W>> edges;
+        edges.reserve(total);
+        for (auto& p : parts) {
+            edges.insert(edges.end(), p.begin(), p.end());
+            vector<GenEdge<W>>().swap(p);
+        }
+        return edges;
+    }
+
+    template <typename W>
+    W Uniform(mt19937_64& rng, W lo, W hi, true_type /*integral*/) {
+        return uniform_int_distribution<W>(lo, hi)(rng);
+    }
+
+    template <typename W>
+    W Uniform(mt19937_64& rng, W lo, W hi, false_type /*floating*/) {
+        return uniform_real_distribution<W>(lo, hi)(rng);
+    }
+
+    template <typename W>
+    W Uniform(mt19937_64& rng, W lo, W hi) {
+        if (!(lo < hi))
+            return lo;
+        return Uniform(rng, lo, hi, is_integral<W>());
+    }
+}
+
+/// <summary>
+/// Назначение весов рёбрам согласно распределению (параллельно по блокам рёбер)
+/// </summary>
+/// <param name="n">количество вершин</param>
+/// <param name="edges">рёбра, веса которых перезаписываются</param>
+/// <param name="weights">распределение весов</param>
+/// <param name="opt">параметры генерации</param>
+template <typename W>
+void GenAssignWeights(int n, vector<GenEdge<W>>& edges, const GenWeights<W>& weights, const GenOptions& opt) {
+    using namespace gen_detail;
+
+    // потенциалы вершин (если заданы)
+    vector<W> pot;
+    if (W(0) < weights.potential) {
+        pot.resize(n);
+        int vblocks = (n + BLOCK - 1) / BLOCK;
+        ParallelBlocks(vblocks, opt, [&](int b) {
+            mt19937_64 rng = BlockRng(opt, 2, b);
+            int end = min(n, (b + 1) * BLOCK);
+            for (int v = b * BLOCK; v < end; ++v)
+                pot[v] = Uniform(rng, W(0), weights.potential);
+        });
+    }
+
+    int m = static_cast<int>(edges.size());
+    int eblocks = (m + BLOCK - 1) / BLOCK;
+    ParallelBlocks(eblocks, opt, [&](int b) {
+        mt19937_64 rng = BlockRng(opt, 1, b);
+        int end = min(m, (b + 1) * BLOCK);
+        for (int i = b * BLOCK; i < end; ++i) {
+            GenEdge<W>& e = edges[i];
+            e.weight = Uniform(rng, weights.minW, weights.maxW);
+            if (!pot.empty())
+                e.weight = e.weight + pot[e.from] - pot[e.to];
+        }
+    });
+}
+
+/// <summary>
+/// Цепочка 0->1->...->n-1
+/// </summary>
+/// <param name="n">количество вершин</param>
+/// <returns>список рёбер</returns>
+template <typename W>
+vector<GenEdge<W>> GenChain(int n, const GenWeights<W>& weights = GenWeights<W>(), const GenOptions& opt = GenOptions()) {
+    vector<GenEdge<W>> edges;
+    for (int i = 0; i + 1 < n; ++i)
+        edges.push_back({ i, i + 1, W() });
+    GenAssignWeights(n, edges, weights, opt);
+    return edges;
+}
+
+/// <summary>
+/// Двумерная решётка rows x cols, вершина (r, c) имеет индекс r * cols + c.
+/// Рёбра ведут к соседям справа и снизу, при bidirectional - и в обратную сторону.
+/// </summary>
+/// <returns>список рёбер</returns>
+template <typename W>
+vector<GenEdge<W>> GenGrid(int rows, int cols, bool bidirectional = true,
+    const GenWeights<W>& weights = GenWeights<W>(), const GenOptions& opt = GenOptions()) {
+    vector<GenEdge<W>> edges;
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            int u = r * cols + c;
+            if (c + 1 < cols) {
+                edges.push_back({ u, u + 1, W() });
+                if (bidirectional)
+                    edges.push_back({ u + 1, u, W() });
+            }
+            if (r + 1 < rows) {
+                edges.push_back({ u, u + cols, W() });
+                if (bidirectional)
+                    edges.push_back({ u + cols, u, W() });
+            }
+        }
+    }
+    GenAssignWeights(rows * cols, edges, weights, opt);
+    return edges;
+}
+
+/// <summary>
+/// Случайный граф Эрдёша–Реньи G(n, p): каждое ребро u->v присутствует с вероятностью p.
+/// Используются геометрические пропуски, поэтому сложность O(n + m), а не O(n^2).
+/// Строки матрицы обрабатываются блоками параллельно.
+/// </summary>
+/// <param name="n">количество вершин</param>
+/// <param name="p">вероятность ребра</param>
+/// <param name="loops">разрешать петли u->u</param>
+/// <returns>список рёбер</returns>
+template <typename W>
+vector<GenEdge<W>> GenErdosRenyi(int n, double p, bool loops = false,
+    const GenWeights<W>& weights = GenWeights<W>(), const GenOptions& opt = GenOptions()) {
+    using namespace gen_detail;
+    if (n < 0 || p < 0.0 || p > 1.0)
+        throw runtime_error("GenErdosRenyi: неверные параметры");
+
+    int blocks = (n + BLOCK - 1) / BLOCK;
+    vector<vector<GenEdge<W>>> parts(blocks);
+    if (p > 0.0) {
+        double logq = log1p(-p);
+        ParallelBlocks(blocks, opt, [&](int b) {
+            mt19937_64 rng = BlockRng(opt, 0, b);
+            uniform_real_distribution<double> U(0.0, 1.0);
+            int end = min(n, (b + 1) * BLOCK);
+            for (int u = b * BLOCK; u < end; ++u) {
+                for (long long v = -1;;) {
+                    if (p >= 1.0)
+                        ++v;
+                    else
+                        v += 1 + static_cast<long long>(floor(log1p(-U(rng)) / logq));
+                    if (v >= n)
+                        break;
+                    if (v != u || loops)
+                        parts[b].push_back({ u, static_cast<int>(v), W() });
+                }
+            }
+        });
+    }
+    vector<GenEdge<W>> edges = Concat(parts);
+    GenAssignWeights(n, edges, weights, opt);
+    return edges;
+}
+
+/// <summary>
+/// R-MAT (рекурсивная матрица, частный случай графа Кронекера с затравкой 2x2).
+/// Вершин 2^scale, рёбер edgeFactor * 2^scale; на каждом уровне ребро попадает
+/// в квадрант a/b/c/d = 1-a-b-c. Даёт асимметричные степени, как у реальных графов.
+/// Дубликаты и петли не удаляются, см. GenSortUnique.
+/// </summary>
+/// <param name="scale">логарифм числа вершин</param>
+/// <param name="edgeFactor">среднее число рёбер на вершину</param>
+/// <returns>список рёбер</returns>
+template <typename W>
+vector<GenEdge<W>> GenRMAT(int scale, int edgeFactor, double a = 0.57, double b = 0.19, double c = 0.19,
+    const GenWeights<W>& weights = GenWeights<W>(), const GenOptions& opt = GenOptions()) {
+    using namespace gen_detail;
+    if (scale < 0 || scale > 30 || edgeFactor < 0 || a < 0 || b < 0 || c < 0 || a + b + c > 1.0)
+        throw runtime_error("GenRMAT: неверные параметры");
+
+    int n = 1 << scale;
+    long long m = static_cast<long long>(edgeFactor) * n;
+    if (m > numeric_limits<int>::max())
+        throw runtime_error("GenRMAT: слишком много рёбер");
+
+    int blocks = static_cast<int>((m + BLOCK - 1) / BLOCK);
+    vector<vector<GenEdge<W>>> parts(blocks);
+    ParallelBlocks(blocks, opt, [&](int blk) {
+        mt19937_64 rng = BlockRng(opt, 0, blk);
+        uniform_real_distribution<double> U(0.0, 1.0);
+        long long end = min<long long>(m, static_cast<long long>(blk + 1) * BLOCK);
+        parts[blk].reserve(static_cast<size_t>(end - static_cast<long long>(blk) * BLOCK));
+        for (long long i = static_cast<long long>(blk) * BLOCK; i < end; ++i) {
+            int u = 0, v = 0;
+            for (int level = 0; level < scale; ++level) {
+                double r = U(rng);
+                int bit = 1 << level;
+                if (r < a) {
+                }
+                else if (r < a + b) {
+                    v |= bit;
+                }
+                else if (r < a + b + c) {
+                    u |= bit;
+                }
+                else {
+                    u |= bit;
+                    v |= bit;
+                }
+            }
+            parts[blk].push_back({ u, v, W() });
+        }
+    });
+    vector<GenEdge<W>> edges = Concat(parts);
+    GenAssignWeights(n, edges, weights, opt);
+    return edges;
+}
+
+/// <summary>
+/// Модель Барабаши–Альберт (степенное распределение степеней).
+/// Начинается с m вершин, каждая новая вершина проводит m рёбер к различным
+/// существующим вершинам с вероятностью, пропорциональной их степени.
+/// Присоединение по своей природе последовательно; параллельно назначаются веса.
+/// </summary>
+/// <param name="n">количество вершин</param>
+/// <param name="m">число рёбер от каждой новой вершины</param>
+/// <returns>список рёбер (от новой вершины к старой)</returns>
+template <typename W>
+vector<GenEdge<W>> GenBarabasiAlbert(int n, int m,
+    const GenWeights<W>& weights = GenWeights<W>(), const GenOptions& opt = GenOptions()) {
+    using namespace gen_detail;
+    if (m < 1 || n < m)
+        throw runtime_error("GenBarabasiAlbert: неверные параметры");
+
+    mt19937_64 rng = BlockRng(opt, 0, 0);
+    vector<GenEdge<W>> edges;
+    edges.reserve(static_cast<size_t>(n - m) * m);
+
+    // каждая вершина встречается в repeated столько раз, какова её степень (+1 для начальных)
+    vector<int> repeated;
+    repeated.reserve(static_cast<size_t>(n - m) * m * 2 + m);
+    for (int v = 0; v < m; ++v)
+        repeated.push_back(v);
+
+    vector<int> targets;
+    for (int u = m; u < n; ++u) {
+        targets.clear();
+        while (static_cast<int>(targets.size()) < m) {
+            uniform_int_distribution<size_t> pick(0, repeated.size() - 1);
+            int v = repeated[pick(rng)];
+            if (find(targets.begin(), targets.end(), v) == targets.end())
+                targets.push_back(v);
+        }
+        for (int v : targets) {
+            edges.push_back({ u, v, W() });
+            repeated.push_back(u);
+            repeated.push_back(v);
+        }
+    }
+    GenAssignWeights(n, edges, weights, opt);
+    return edges;
+}
+
+/// <summary>
+/// Сортировка рёбер по (from, to) и удаление повторов (остаётся первое вхождение)
+/// </summary>
+template <typename W>
+void GenSortUnique(vector<GenEdge<W>>& edges) {
+    stable_sort(edges.begin(), edges.end(), [](const GenEdge<W>& x, const GenEdge<W>& y) {
+        return x.from != y.from ? x.from < y.from : x.to < y.to;
+    });
+    edges.erase(unique(edges.begin(), edges.end(), [](const GenEdge<W>& x, const GenEdge<W>& y) {
+        return x.from == y.from && x.to == y.to;
+    }), edges.end());
+}
+
+/// <summary>
+/// Построение DGraph с вершинами 0..n-1 по списку рёбер.
+/// При повторяющихся рёбрах остаётся вес последнего.
+/// </summary>
+/// <param name="n">количество вершин</param>
+/// <param name="edges">список рёбер</param>
+/// <param name="inf">обозначение "нет ребра"</param>
+/// <returns>граф</returns>
+template <typename W>
+DGraph<int, W> GenBuild(int n, const vector<GenEdge<W>>& edges, W inf) {
+    DGraph<int, W> g(inf);
+    for (int i = 0; i < n; ++i)
+        g.AddV(i);
+    for (const auto& e : edges)
+        g.AddE(e.from, e.to, e.weight);
+    return g;
+}
@@ -0,0 +1,484 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <functional>
+#include <ostream>
+#include <istream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TGR_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+/// <summary>
+/// Номер младшего установленного бита (mask != 0)
+/// </summary>
+inline int LowBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, mask);
+    return static_cast<int>(i);
+#else
+    return __builtin_ctz(mask);
+#endif
+}
+
+/// <summary>
+/// Плоская хеш-таблица с открытой адресацией (по схеме SwissTable).
+/// Хранит только индексы (handles) ключей, сами ключи лежат во внешнем массиве keys,
+/// поэтому каждый ключ хранится в памяти один раз.
+/// Для каждого слота есть управляющий байт: пусто, удалено или 7 бит хеша;
+/// группа из 16 байт сравнивается за одну SSE2-инструкцию.
+/// </summary>
+/// <typeparam name="K">тип ключа (должен поддерживаться hash и ==)</typeparam>
+/// <typeparam name="I">тип индекса</typeparam>
+/// <typeparam name="A">распределитель памяти</typeparam>
+template <typename K, typename I = int, typename A = allocator<char>>
+class FlatIndex {
+private:
+
+    template <typename U>
+    using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+
+    static constexpr int GROUP = 16;
+    static constexpr int8_t EMPTY = -128;
+    static constexpr int8_t DELETED = -2;
+
+    /// <summary>
+    /// управляющие байты слотов
+    /// </summary>
+    vector<int8_t, Alloc<int8_t>> ctrl;
+
+    /// <summary>
+    /// индексы ключей во внешнем массиве
+    /// </summary>
+    vector<I, Alloc<I>> slots;
+
+    /// <summary>
+    /// количество ключей
+    /// </summary>
+    size_t count = 0;
+
+    /// <summary>
+    /// количество занятых слотов, включая удалённые
+    /// </summary>
+    size_t used = 0;
+
+public:
+
+    explicit FlatIndex(const A& alloc = A()) : ctrl(Alloc<int8_t>(alloc)), slots(Alloc<I>(alloc)) {}
+
+    /// <summary>
+    /// Количество ключей
+    /// </summary>
+    size_t Size() const {
+        return count;
+    }
+
+    /// <summary>
+    /// Количество слотов
+    /// </summary>
+    size_t Capacity() const {
+        return ctrl.size();
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return ctrl.capacity() * sizeof(int8_t) + slots.capacity() * sizeof(I);
+    }
+
+    /// <summary>
+    /// Память сверх таблицы минимального размера под текущие ключи (освобождается ShrinkToFit)
+    /// </summary>
+    size_t SlackBytes() const {
+        size_t fit = count ? FitSlots(count) * (sizeof(int8_t) + sizeof(I)) : 0;
+        size_t bytes = MemoryBytes();
+        return bytes > fit ? bytes - fit : 0;
+    }
+
+    /// <summary>
+    /// Поиск ключа
+    /// Сложность: O(1) в среднем
+    /// </summary>
+    /// <param name="key">ключ</param>
+    /// <param name="keys">массив ключей, keys[i] - ключ с индексом i</param>
+    /// <returns>индекс ключа или -1</returns>
+    template <typename Keys>
+    I Find(const K& key, const Keys& keys) const {
+        if (ctrl.empty())
+            return I(-1);
+        size_t h = Hash(key);
+        int8_t h2 = H2(h);
+        size_t mask = ctrl.size() / GROUP - 1;
+        size_t g = H1(h) & mask;
+        for (size_t step = 1;; ++step) {
+            const int8_t* group = ctrl.data() + g * GROUP;
+            for (uint32_t m = Match(group, h2); m; m &= m - 1) {
+                size_t slot = g * GROUP + LowBit(m);
+                if (keys[slots[slot]] == key)
+                    return slots[slot];
+            }
+            if (MatchEmpty(group))
+                return I(-1);
+            g = (g + step) & mask;
+        }
+    }
+
+    /// <summary>
+    /// Вставка ключа, которого ещё нет в таблице
+    /// Сложность: O(1) амортизированно
+    /// </summary>
+    /// <param name="key">ключ</param>
+    /// <param name="idx">его индекс</param>
+    /// <param name="keys">массив ключей (нужен при перестройке)</param>
+    template <typename Keys>
+    void Insert(const K& key, I idx, const Keys& keys) {
+        if ((used + 1) * 8 > ctrl.size() * 7)
+            Rehash(count + 1 > used / 2 ? ctrl.size() * 2 : ctrl.size(), keys);
+        Place(Hash(key), idx);
+    }
+
+    /// <summary>
+    /// Удаление ключа
+    /// </summary>
+    /// <returns>True - ключ был в таблице</returns>
+    template <typename Keys>
+    bool Erase(const K& key, const Keys& keys) {
+        if (ctrl.empty())
+            return false;
+        size_t h = Hash(key);
+        int8_t h2 = H2(h);
+        size_t mask = ctrl.size() / GROUP - 1;
+        size_t g = H1(h) & mask;
+        for (size_t step = 1;; ++step) {
+            const int8_t* group = ctrl.data() + g * GROUP;
+            for (uint32_t m = Match(group, h2); m; m &= m - 1) {
+                size_t slot = g * GROUP + LowBit(m);
+                if (keys[slots[slot]] == key) {
+                    ctrl[slot] = DELETED;
+                    --count;
+                    return true;
+                }
+            }
+            if (MatchEmpty(group))
+                return false;
+            g = (g + step) & mask;
+        }
+    }
+
+    /// <summary>
+    /// Очистка с сохранением ёмкости
+    /// </summary>
+    void Clear() {
+        fill(ctrl.begin(), ctrl.end(), EMPTY);
+        count = used = 0;
+    }
+
+    /// <summary>
+    /// Перестройка по массиву ключей: keys[i] получает индекс i
+    /// Сложность: O(n)
+    /// </summary>
+    template <typename Keys>
+    void Rebuild(const Keys& keys, size_t n) {
+        Clear();
+        Reserve(n, keys);
+        for (size_t i = 0; i < n; ++i)
+            Place(Hash(keys[i]), static_cast<I>(i));
+    }
+
+    /// <summary>
+    /// Резервирование места под n ключей
+    /// </summary>
+    template <typename Keys>
+    void Reserve(size_t n, const Keys& keys) {
+        size_t need = FitSlots(n);
+        if (need > ctrl.size())
+            Rehash(need, keys);
+    }
+
+    /// <summary>
+    /// Уменьшение таблицы до минимального размера под текущие ключи
+    /// </summary>
+    template <typename Keys>
+    void ShrinkToFit(const Keys& keys) {
+        size_t need = FitSlots(count);
+        if (count == 0) {
+            vector<int8_t, Alloc<int8_t>>(ctrl.get_allocator()).swap(ctrl);
+            vector<I, Alloc<I>>(slots.get_allocator()).swap(slots);
+            used = 0;
+        }
+        else if (need != ctrl.size() || used != count) {
+            Rehash(need, keys);
+            ctrl.shrink_to_fit();
+            slots.shrink_to_fit();
+        }
+    }
+
+private:
+
+    /// <summary>
+    /// наименьшее число слотов (степень двойки, не меньше группы) для n ключей при заполнении до 7/8
+    /// </summary>
+    static size_t FitSlots(size_t n) {
+        size_t need = GROUP;
+        while (need * 7 < n * 8)
+            need *= 2;
+        return need;
+    }
+
+    static size_t Hash(const K& key) {
+        uint64_t h = static_cast<uint64_t>(hash<K>()(key));
+        // std::hash для целых - тождественное отображение, поэтому перемешиваем
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+
+    static int8_t H2(size_t h) {
+        return static_cast<int8_t>(h & 0x7F);
+    }
+
+    static size_t H1(size_t h) {
+        return h >> 7;
+    }
+
+    /// <summary>
+    /// маска слотов группы с данным h2
+    /// </summary>
+    static uint32_t Match(const int8_t* group, int8_t h2) {
+#ifdef TGR_SSE2
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(h2))));
+#else
+        uint32_t m = 0;
+        for (int i = 0; i < GROUP; ++i)
+            m |= static_cast<uint32_t>(group[i] == h2) << i;
+        return m;
+#endif
+    }
+
+    /// <summary>
+    /// маска пустых слотов группы
+    /// </summary>
+    static uint32_t MatchEmpty(const int8_t* group) {
+        return Match(group, EMPTY);
+    }
+
+    /// <summary>
+    /// маска свободных (пустых или удалённых) слотов группы: у них старший бит установлен
+    /// </summary>
+    static uint32_t MatchFree(const int8_t* group) {
+#ifdef TGR_SSE2
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return static_cast<uint32_t>(_mm_movemask_epi8(g));
+#else
+        uint32_t m = 0;
+        for (int i = 0; i < GROUP; ++i)
+            m |= static_cast<uint32_t>(group[i] < 0) << i;
+        return m;
+#endif
+    }
+
+    /// <summary>
+    /// запись индекса в первый свободный слот последовательности проб
+    /// </summary>
+    void Place(size_t h, I idx) {
+        size_t mask = ctrl.size() / GROUP - 1;
+        size_t g = H1(h) & mask;
+        for (size_t step = 1;; ++step) {
+            uint32_t m = MatchFree(ctrl.data() + g * GROUP);
+            if (m) {
+                size_t slot = g * GROUP + LowBit(m);
+                if (ctrl[slot] == EMPTY)
+                    ++used;
+                ctrl[slot] = H2(h);
+                slots[slot] = idx;
+                ++count;
+                return;
+            }
+            g = (g + step) & mask;
+        }
+    }
+
+    template <typename Keys>
+    void Rehash(size_t capacity, const Keys& keys) {
+        if (capacity < GROUP)
+            capacity = GROUP;
+        vector<int8_t, Alloc<int8_t>> oldCtrl(capacity, EMPTY, ctrl.get_allocator());
+        vector<I, Alloc<I>> oldSlots(capacity, I(), slots.get_allocator());
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        count = used = 0;
+        for (size_t i = 0; i < oldCtrl.size(); ++i)
+            if (oldCtrl[i] >= 0)
+                Place(Hash(keys[oldSlots[i]]), oldSlots[i]);
+    }
+};
+
+/// <summary>
+/// Интернированная строка: указатель на единственную копию строки в InternPool.
+/// Сравнение и хеширование - по указателю, без обращения к символам.
+/// </summary>
+class IStr {
+public:
+    IStr() : p(nullptr) {}
+
+    /// <summary>
+    /// Символы строки (с завершающим нулём)
+    /// </summary>
+    const char* c_str() const {
+        return p ? p : "";
+    }
+
+    /// <summary>
+    /// Длина строки
+    /// </summary>
+    size_t size() const {
+        if (!p)
+            return 0;
+        uint32_t len;
+        memcpy(&len, p - sizeof(uint32_t), sizeof(uint32_t));
+        return len;
+    }
+
+    string_view view() const {
+        return string_view(c_str(), size());
+    }
+
+    /// <summary>
+    /// True - строка не пустая (получена из пула)
+    /// </summary>
+    explicit operator bool() const {
+        return p != nullptr;
+    }
+
+    bool operator==(const IStr& o) const {
+        return p == o.p;
+    }
+
+    bool operator!=(const IStr& o) const {
+        return p != o.p;
+    }
+
+private:
+    friend class InternPool;
+    explicit IStr(const char* p) : p(p) {}
+
+    const char* p;
+};
+
+inline ostream& operator<<(ostream& os, const IStr& s) {
+    return os << s.view();
+}
+
+namespace std {
+    template <>
+    struct hash<IStr> {
+        size_t operator()(const IStr& s) const {
+            return hash<const void*>()(s.c_str());
+        }
+    };
+}
+
+/// <summary>
+/// Пул интернированных строк. Каждая строка хранится один раз в больших
+/// непрерывных блоках ([длина][символы][0]); блоки не перемещаются, поэтому
+/// IStr остаются действительными всё время жизни пула.
+/// Пример: DGraph&lt;IStr, double&gt; g(INF); g.AddV(pool.Intern("A"));
+/// </summary>
+class InternPool {
+public:
+
+    InternPool() {}
+    InternPool(const InternPool&) = delete;
+    InternPool& operator=(const InternPool&) = delete;
+
+    /// <summary>
+    /// Интернирование строки
+    /// Сложность: O(длина строки)
+    /// </summary>
+    /// <param name="s">строка</param>
+    /// <returns>единственный для этого содержимого IStr</returns>
+    IStr Intern(string_view s) {
+        int found = index.Find(s, Keys{ this });
+        if (found >= 0)
+            return IStr(strings[found]);
+
+        size_t need = sizeof(uint32_t) + s.size() + 1;
+        if (chunks.empty() || chunkUsed + need > chunkSize) {
+            size_t size = need > CHUNK ? need : CHUNK;
+            chunks.emplace_back(new char[size]);
+            chunkSize = size;
+            chunkUsed = 0;
+            reserved += size;
+        }
+        char* base = chunks.back().get() + chunkUsed;
+        uint32_t len = static_cast<uint32_t>(s.size());
+        memcpy(base, &len, sizeof(uint32_t));
+        memcpy(base + sizeof(uint32_t), s.data(), s.size());
+        base[sizeof(uint32_t) + s.size()] = 0;
+        chunkUsed += need;
+
+        strings.push_back(base + sizeof(uint32_t));
+        index.Insert(s, static_cast<int>(strings.size() - 1), Keys{ this });
+        return IStr(strings.back());
+    }
+
+    /// <summary>
+    /// Поиск без добавления
+    /// </summary>
+    /// <returns>IStr или пустой IStr, если строки нет в пуле</returns>
+    IStr Find(string_view s) const {
+        int found = index.Find(s, Keys{ this });
+        return found >= 0 ? IStr(strings[found]) : IStr();
+    }
+
+    /// <summary>
+    /// Количество различных строк
+    /// </summary>
+    size_t Size() const {
+        return strings.size();
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return reserved + strings.capacity() * sizeof(const char*) + index.MemoryBytes();
+    }
+
+private:
+
+    static constexpr size_t CHUNK = 64 * 1024;
+
+    /// <summary>
+    /// доступ к строке по номеру для FlatIndex
+    /// </summary>
+    struct Keys {
+        const InternPool* pool;
+        string_view operator[](int i) const {
+            return IStr(pool->strings[i]).view();
+        }
+    };
+
+    vector<unique_ptr<char[]>> chunks;
+    size_t chunkSize = 0;
+    size_t chunkUsed = 0;
+    size_t reserved = 0;
+    vector<const char*> strings;
+    FlatIndex<string_view, int> index;
+};
@@ -0,0 +1,683 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <chrono>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace std;
+
+/// <summary>
+/// Получатель изменений графа. DGraph вызывает его после проверки аргументов
+/// и до применения изменения (журнал упреждающей записи).
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+template <typename T, typename W>
+class MutationObserver {
+public:
+    virtual ~MutationObserver() {}
+    virtual void OnAddV(const T& v) = 0;
+    virtual void OnDeleteV(const T& v) = 0;
+    virtual void OnAddE(const T& from, const T& to, const W& w) = 0;
+    virtual void OnDeleteE(const T& from, const T& to) = 0;
+    virtual void OnClear() = 0;
+};
+
+/// <summary>
+/// Двоичная запись значений в журнал и снимок: тривиально копируемые типы побайтно,
+/// строки - длина и символы. Для других типов нужна своя специализация.
+/// </summary>
+template <typename X, typename = void>
+struct JournalCodec {
+    static_assert(is_trivially_copyable<X>::value, "JournalCodec: нужна специализация для этого типа");
+
+    static void Put(string& out, const X& x) {
+        out.append(reinterpret_cast<const char*>(&x), sizeof(X));
+    }
+
+    static bool Get(const char*& p, const char* end, X& x) {
+        if (static_cast<size_t>(end - p) < sizeof(X))
+            return false;
+        memcpy(&x, p, sizeof(X));
+        p += sizeof(X);
+        return true;
+    }
+};
+
+template <>
+struct JournalCodec<string> {
+    static void Put(string& out, const string& s) {
+        uint32_t len = static_cast<uint32_t>(s.size());
+        out.append(reinterpret_cast<const char*>(&len), sizeof(len));
+        out.append(s);
+    }
+
+    static bool Get(const char*& p, const char* end, string& s) {
+        uint32_t len;
+        if (!JournalCodec<uint32_t>::Get(p, end, len) || static_cast<size_t>(end - p) < len)
+            return false;
+        s.assign(p, len);
+        p += len;
+        return true;
+    }
+};
+
+/// <summary>
+/// Параметры журнала
+/// </summary>
+struct JournalOptions {
+    /// <summary>
+    /// наибольшая задержка групповой записи: накопленные записи сбрасываются на диск
+    /// одним fsync не реже, чем раз в этот интервал
+    /// </summary>
+    chrono::milliseconds groupInterval{ 5 };
+
+    /// <summary>
+    /// размер буфера, при достижении которого запись выполняется сразу
+    /// </summary>
+    size_t groupBytes = 1 << 16;
+
+    /// <summary>
+    /// fsync после каждой записи (без группировки)
+    /// </summary>
+    bool syncEachRecord = false;
+};
+
+namespace journal_detail {
+
+    enum Op : uint8_t { AddV = 1, DeleteV = 2, AddE = 3, DeleteE = 4, Clear = 5 };
+
+    const char SNAP_MAGIC[4] = { 'T', 'G', 'R', 'S' };
+    const char SNAP_END[4] = { 'E', 'N', 'D', '!' };
+
+    inline uint32_t Crc32(const char* data, size_t n) {
+        // таблица строится один раз (потокобезопасная инициализация статической переменной)
+        static const vector<uint32_t> table = []() {
+            vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; ++i) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; ++k)
+                    c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+        uint32_t c = 0xFFFFFFFFu;
+        for (size_t i = 0; i < n; ++i)
+            c = table[(c ^ static_cast<uint8_t>(data[i])) & 0xFF] ^ (c >> 8);
+        return c ^ 0xFFFFFFFFu;
+    }
+
+    /// <summary>
+    /// Сброс буферов файла на диск
+    /// </summary>
+    /// <returns>True - данные записаны</returns>
+    inline bool SyncFile(FILE* f) {
+        if (fflush(f) != 0)
+            return false;
+#ifdef _WIN32
+        return _commit(_fileno(f)) == 0;
+#else
+        return fsync(fileno(f)) == 0;
+#endif
+    }
+
+    /// <summary>
+    /// Сброс на диск каталога, содержащего path (запись о переименовании файла).
+    /// В Windows каталог так не синхронизируется, переименование считается надёжным.
+    /// </summary>
+    /// <returns>True - каталог записан</returns>
+    inline bool SyncDir(const string& path) {
+#ifdef _WIN32
+        (void)path;
+        return true;
+#else
+        string dir = std::filesystem::path(path).parent_path().string();
+        int fd = open(dir.empty() ? "." : dir.c_str(), O_RDONLY);
+        if (fd < 0)
+            return false;
+        bool ok = fsync(fd) == 0;
+        return close(fd) == 0 && ok;
+#endif
+    }
+
+    inline string ReadAll(const string& path) {
+        ifstream in(path, ios::binary);
+        ostringstream ss;
+        ss << in.rdbuf();
+        return ss.str();
+    }
+}
+
+/// <summary>
+/// Журнал изменений графа с восстановлением после сбоя.
+/// Каждое изменение (AddV, DeleteV, AddE, DeleteE) дописывается в конец двоичного журнала
+/// записью с длиной и контрольной суммой. Записи копятся в буфере и сбрасываются на диск
+/// группой: один fsync на много изменений (фоновым потоком раз в groupInterval или сразу
+/// при заполнении буфера). Стоимость сохранения пропорциональна числу изменений, а не размеру графа.
+///
+/// Файлы: base.snap.N - снимок поколения N, base.log.N - изменения после снимка N.
+/// Recover загружает последний целый снимок и повторяет журналы; оборванная последняя
+/// запись (сбой во время записи) отбрасывается. Compact записывает новый снимок в фоне
+/// и удаляет устаревшие файлы.
+/// Ошибка записи или fsync необратима: дальнейшие изменения графа, Sync и Compact
+/// выбрасывают её, пока журнал не открыт заново через Recover.
+/// </summary>
+/// <typeparam name="T">тип вершин</typeparam>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+template <typename T, typename W>
+class GraphJournal : public MutationObserver<T, W> {
+public:
+
+    /// <summary>
+    /// Конструктор. Файлы не открываются до Recover.
+    /// </summary>
+    /// <param name="base">путь и префикс имён файлов журнала</param>
+    /// <param name="opt">параметры групповой записи</param>
+    explicit GraphJournal(const string& base, const JournalOptions& opt = JournalOptions())
+        : base(base), opt(opt) {}
+
+    GraphJournal(const GraphJournal&) = delete;
+    GraphJournal& operator=(const GraphJournal&) = delete;
+
+    ~GraphJournal() {
+        {
+            lock_guard<mutex> lk(bufLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (flusher.joinable())
+            flusher.join();
+        WaitCompaction();
+        if (log) {
+            try {
+                Flush();
+            }
+            catch (...) {
+                // журнал уже отказал: незаписанные изменения теряются вместе с объектом
+            }
+            fclose(log);
+        }
+    }
+
+    /// <summary>
+    /// Восстановление графа: последний целый снимок и повтор журналов после него.
+    /// Граф должен быть пустым. После Recover журнал готов к записи и подключается к графу.
+    /// </summary>
+    /// <param name="g">граф (DGraph)</param>
+    /// <exception cref="runtime_error - журнал не согласован со снимком или не удаётся открыть файл">
+    /// </exception>
+    template <typename G>
+    void Recover(G& g) {
+        if (log)
+            throw runtime_error("GraphJournal: журнал уже открыт");
+        g.DetachJournal();
+
+        // последний снимок, прочитанный целиком
+        vector<uint64_t> snaps = Generations(".snap.");
+        uint64_t from = 0;
+        for (auto it = snaps.rbegin(); it != snaps.rend(); ++it) {
+            G candidate = g;
+            if (LoadSnapshot(SnapPath(*it), candidate)) {
+                g = move(candidate);
+                from = *it;
+                break;
+            }
+        }
+
+        // журналы начиная с поколения снимка
+        uint64_t last = from;
+        for (uint64_t gen : Generations(".log."))
+            if (gen >= from) {
+                Replay(LogPath(gen), g);
+                last = gen;
+            }
+
+        generation = last;
+        Open();
+        g.AttachJournal(this);
+    }
+
+    /// <summary>
+    /// Дождаться записи на диск всех изменений, сделанных до вызова
+    /// </summary>
+    /// <exception cref="runtime_error - запись журнала не удалась (сейчас или раньше, в том числе в фоне)">
+    /// </exception>
+    void Sync() {
+        Flush();
+    }
+
+    /// <summary>
+    /// Уплотнение: новый снимок состояния g и новый пустой журнал.
+    /// g должен отражать все записанные изменения (обычно это граф, к которому подключён журнал).
+    /// Снимок пишется фоновым потоком с копии графа; изменения в это время идут в новый журнал.
+    /// </summary>
+    /// <param name="g">текущее состояние графа</param>
+    /// <exception cref="runtime_error - журнал не открыт или отказал; если не открывается новый журнал,
+    /// журнал переходит в состояние ошибки">
+    /// </exception>
+    template <typename G>
+    void Compact(const G& g) {
+        WaitCompaction();
+        if (!log)
+            throw runtime_error("GraphJournal: журнал не открыт");
+        auto copy = make_shared<G>(g);
+        copy->DetachJournal();
+        uint64_t gen;
+        {
+            lock_guard<mutex> fl(fileLock);
+            FlushLocked();
+            fclose(log);
+            log = nullptr;
+            gen = ++generation;
+            try {
+                OpenLocked();
+            }
+            catch (const runtime_error& e) {
+                // без открытого журнала изменения записывать некуда
+                lock_guard<mutex> lk(bufLock);
+                failure = e.what();
+                throw;
+            }
+        }
+        compactor = thread([this, copy, gen]() {
+            try {
+                WriteSnapshot(*copy, gen);
+                // снимок надёжно записан: старые снимки и журналы больше не нужны
+                for (uint64_t old : Generations(".snap."))
+                    if (old < gen)
+                        remove(SnapPath(old).c_str());
+                for (uint64_t old : Generations(".log."))
+                    if (old < gen)
+                        remove(LogPath(old).c_str());
+            }
+            catch (...) {
+                // снимок не записан: восстановление пойдёт по старому снимку и журналам
+            }
+        });
+    }
+
+    /// <summary>
+    /// Дождаться окончания фонового уплотнения
+    /// </summary>
+    void WaitCompaction() {
+        if (compactor.joinable())
+            compactor.join();
+    }
+
+    /// <summary>
+    /// Номер текущего поколения (журнала, в который идут записи)
+    /// </summary>
+    uint64_t Generation() const {
+        return generation;
+    }
+
+    /// <summary>
+    /// Записей добавлено
+    /// </summary>
+    uint64_t Records() const {
+        lock_guard<mutex> lk(bufLock);
+        return records;
+    }
+
+    /// <summary>
+    /// Байт записано в журналы
+    /// </summary>
+    uint64_t BytesWritten() const {
+        lock_guard<mutex> fl(fileLock);
+        return bytesWritten;
+    }
+
+    /// <summary>
+    /// Выполнено fsync журнала
+    /// </summary>
+    uint64_t Syncs() const {
+        lock_guard<mutex> fl(fileLock);
+        return syncs;
+    }
+
+    void OnAddV(const T& v) override {
+        string r(1, static_cast<char>(journal_detail::AddV));
+        JournalCodec<T>::Put(r, v);
+        Append(r);
+    }
+
+    void OnDeleteV(const T& v) override {
+        string r(1, static_cast<char>(journal_detail::DeleteV));
+        JournalCodec<T>::Put(r, v);
+        Append(r);
+    }
+
+    void OnAddE(const T& from, const T& to, const W& w) override {
+        string r(1, static_cast<char>(journal_detail::AddE));
+        JournalCodec<T>::Put(r, from);
+        JournalCodec<T>::Put(r, to);
+        JournalCodec<W>::Put(r, w);
+        Append(r);
+    }
+
+    void OnDeleteE(const T& from, const T& to) override {
+        string r(1, static_cast<char>(journal_detail::DeleteE));
+        JournalCodec<T>::Put(r, from);
+        JournalCodec<T>::Put(r, to);
+        Append(r);
+    }
+
+    void OnClear() override {
+        Append(string(1, static_cast<char>(journal_detail::Clear)));
+    }
+
+private:
+    string base;
+    JournalOptions opt;
+
+    FILE* log = nullptr;
+    uint64_t generation = 0;
+
+    /// <summary>
+    /// порядок блокировок: fileLock, затем bufLock
+    /// </summary>
+    mutable mutex fileLock;
+    mutable mutex bufLock;
+    condition_variable wake;
+    string pending;
+    uint64_t records = 0;
+    uint64_t bytesWritten = 0;
+    uint64_t syncs = 0;
+    bool stopping = false;
+
+    /// <summary>
+    /// ошибка записи; после неё журнал отказывает в Append, Sync и Compact,
+    /// незаписанная группа остаётся в pending
+    /// </summary>
+    string failure;
+
+    thread flusher;
+    thread compactor;
+
+    string SnapPath(uint64_t gen) const {
+        return base + ".snap." + to_string(gen);
+    }
+
+    string LogPath(uint64_t gen) const {
+        return base + ".log." + to_string(gen);
+    }
+
+    /// <summary>
+    /// Номера поколений существующих файлов base + kind + N по возрастанию
+    /// </summary>
+    vector<uint64_t> Generations(const string& kind) const {
+        namespace fs = std::filesystem;
+        fs::path prefix(base + kind);
+        fs::path dir = prefix.parent_path().empty() ? fs::path(".") : prefix.parent_path();
+        string stem = prefix.filename().string();
+        vector<uint64_t> gens;
+        error_code ec;
+        for (const auto& entry : fs::directory_iterator(dir, ec)) {
+            string name = entry.path().filename().string();
+            if (name.size() <= stem.size() || name.compare(0, stem.size(), stem) != 0)
+                continue;
+            string num = name.substr(stem.size());
+            if (num.find_first_not_of("0123456789") == string::npos)
+                gens.push_back(stoull(num));
+        }
+        sort(gens.begin(), gens.end());
+        return gens;
+    }
+
+    void Open() {
+        lock_guard<mutex> fl(fileLock);
+        OpenLocked();
+        if (!flusher.joinable())
+            flusher = thread([this]() { FlushLoop(); });
+    }
+
+    void OpenLocked() {
+        log = fopen(LogPath(generation).c_str(), "ab");
+        if (!log)
+            throw runtime_error("GraphJournal: не удалось открыть " + LogPath(generation));
+    }
+
+    /// <summary>
+    /// Запись: длина, контрольная сумма, тело
+    /// </summary>
+    void Append(const string& body) {
+        uint32_t len = static_cast<uint32_t>(body.size());
+        uint32_t crc = journal_detail::Crc32(body.data(), body.size());
+        bool now;
+        {
+            lock_guard<mutex> lk(bufLock);
+            if (stopping)
+                throw runtime_error("GraphJournal: журнал закрыт");
+            if (!failure.empty())
+                throw runtime_error(failure);
+            pending.append(reinterpret_cast<const char*>(&len), sizeof(len));
+            pending.append(reinterpret_cast<const char*>(&crc), sizeof(crc));
+            pending.append(body);
+            ++records;
+            now = opt.syncEachRecord || pending.size() >= opt.groupBytes;
+        }
+        if (now)
+            Flush();
+    }
+
+    void Flush() {
+        lock_guard<mutex> fl(fileLock);
+        FlushLocked();
+    }
+
+    void FlushLocked() {
+        string batch;
+        {
+            lock_guard<mutex> lk(bufLock);
+            if (!failure.empty())
+                throw runtime_error(failure);
+            if (pending.empty())
+                return;
+            if (!log) {
+                failure = "GraphJournal: журнал не открыт";
+                throw runtime_error(failure);
+            }
+            batch.swap(pending);
+        }
+        if (fwrite(batch.data(), 1, batch.size(), log) != batch.size() || !journal_detail::SyncFile(log)) {
+            // часть группы могла попасть в файл: повтор дал бы повреждённую запись посреди журнала,
+            // поэтому группа возвращается в буфер, а журнал переходит в состояние ошибки
+            lock_guard<mutex> lk(bufLock);
+            pending.insert(0, batch);
+            failure = "GraphJournal: ошибка записи журнала " + LogPath(generation);
+            throw runtime_error(failure);
+        }
+        bytesWritten += batch.size();
+        ++syncs;
+    }
+
+    /// <summary>
+    /// Фоновая групповая запись
+    /// </summary>
+    void FlushLoop() {
+        unique_lock<mutex> lk(bufLock);
+        while (!stopping) {
+            wake.wait_for(lk, opt.groupInterval);
+            if (pending.empty() || !failure.empty())
+                continue;
+            lk.unlock();
+            try {
+                Flush();
+            }
+            catch (...) {
+                // ошибка сохранена в failure и выбрасывается при Sync и следующих изменениях
+            }
+            lk.lock();
+        }
+    }
+
+    /// <summary>
+    /// Повтор журнала; оборванный или повреждённый хвост отрезается
+    /// </summary>
+    template <typename G>
+    void Replay(const string& path, G& g) {
+        string data = journal_detail::ReadAll(path);
+        const char* p = data.data();
+        const char* end = p + data.size();
+        size_t good = 0;
+        while (static_cast<size_t>(end - p) >= 8) {
+            uint32_t len, crc;
+            memcpy(&len, p, 4);
+            memcpy(&crc, p + 4, 4);
+            if (static_cast<size_t>(end - p - 8) < len || journal_detail::Crc32(p + 8, len) != crc)
+                break;
+            if (!Apply(p + 8, p + 8 + len, g))
+                throw runtime_error("GraphJournal: неизвестная запись в " + path);
+            p += 8 + len;
+            good = static_cast<size_t>(p - data.data());
+        }
+        if (good != data.size())
+            std::filesystem::resize_file(path, good);
+    }
+
+    template <typename G>
+    static bool Apply(const char* p, const char* end, G& g) {
+        uint8_t op = static_cast<uint8_t>(*p++);
+        T a, b;
+        W w;
+        try {
+            switch (op) {
+            case journal_detail::AddV:
+                if (!JournalCodec<T>::Get(p, end, a))
+                    return false;
+                g.AddV(a);
+                return true;
+            case journal_detail::DeleteV:
+                if (!JournalCodec<T>::Get(p, end, a))
+                    return false;
+                g.DeleteV(a);
+                return true;
+            case journal_detail::AddE:
+                if (!JournalCodec<T>::Get(p, end, a) || !JournalCodec<T>::Get(p, end, b) || !JournalCodec<W>::Get(p, end, w))
+                    return false;
+                g.AddE(a, b, w);
+                return true;
+            case journal_detail::DeleteE:
+                if (!JournalCodec<T>::Get(p, end, a) || !JournalCodec<T>::Get(p, end, b))
+                    return false;
+                g.DeleteE(a, b);
+                return true;
+            case journal_detail::Clear:
+                g.Clear();
+                return true;
+            }
+        }
+        catch (const runtime_error& e) {
+            throw runtime_error(string("GraphJournal: журнал не согласован со снимком: ") + e.what());
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Снимок: вершины по индексам, затем рёбра (индексы и вес), в конце контрольная сумма.
+    /// Пишется во временный файл и переименовывается, поэтому снимок либо целый, либо отсутствует.
+    /// </summary>
+    template <typename G>
+    void WriteSnapshot(const G& g, uint64_t gen) const {
+        string body;
+        body.append(journal_detail::SNAP_MAGIC, 4);
+        JournalCodec<uint64_t>::Put(body, gen);
+        using Idx = decltype(g.IndexOf(declval<const T&>()));
+        uint64_t n = static_cast<uint64_t>(g.Size());
+        JournalCodec<uint64_t>::Put(body, n);
+        for (uint64_t i = 0; i < n; ++i)
+            JournalCodec<T>::Put(body, g.VertexAt(static_cast<Idx>(i)));
+        string edges;
+        uint64_t m = 0;
+        for (uint64_t u = 0; u < n; ++u)
+            g.ForEachOut(static_cast<Idx>(u), [&](auto v, const W& w) {
+                JournalCodec<uint64_t>::Put(edges, u);
+                JournalCodec<uint64_t>::Put(edges, static_cast<uint64_t>(v));
+                JournalCodec<W>::Put(edges, w);
+                ++m;
+            });
+        JournalCodec<uint64_t>::Put(body, m);
+        body += edges;
+        JournalCodec<uint32_t>::Put(body, journal_detail::Crc32(body.data(), body.size()));
+        body.append(journal_detail::SNAP_END, 4);
+
+        string tmp = SnapPath(gen) + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f)
+            throw runtime_error("GraphJournal: не удалось создать снимок");
+        bool ok = fwrite(body.data(), 1, body.size(), f) == body.size();
+        ok = ok && journal_detail::SyncFile(f);
+        ok = (fclose(f) == 0) && ok;
+        if (!ok || rename(tmp.c_str(), SnapPath(gen).c_str()) != 0) {
+            remove(tmp.c_str());
+            throw runtime_error("GraphJournal: ошибка записи снимка");
+        }
+        // старые поколения удаляются только после надёжной записи переименования
+        if (!journal_detail::SyncDir(SnapPath(gen)))
+            throw runtime_error("GraphJournal: ошибка записи каталога снимка");
+    }
+
+    /// <summary>
+    /// Загрузка снимка в пустой граф; false, если снимок неполный или повреждён
+    /// </summary>
+    template <typename G>
+    static bool LoadSnapshot(const string& path, G& g) {
+        string data = journal_detail::ReadAll(path);
+        if (data.size() < 4 + 8 + 8 + 8 + 4 + 4 || memcmp(data.data(), journal_detail::SNAP_MAGIC, 4) != 0
+            || memcmp(data.data() + data.size() - 4, journal_detail::SNAP_END, 4) != 0)
+            return false;
+        size_t bodyLen = data.size() - 8;
+        uint32_t crc;
+        memcpy(&crc, data.data() + bodyLen, 4);
+        if (journal_detail::Crc32(data.data(), bodyLen) != crc)
+            return false;
+
+        const char* p = data.data() + 4;
+        const char* end = data.data() + bodyLen;
+        uint64_t gen, n, m;
+        if (!JournalCodec<uint64_t>::Get(p, end, gen) || !JournalCodec<uint64_t>::Get(p, end, n))
+            return false;
+        vector<T> keys;
+        keys.reserve(static_cast<size_t>(n));
+        for (uint64_t i = 0; i < n; ++i) {
+            T v;
+            if (!JournalCodec<T>::Get(p, end, v))
+                return false;
+            keys.push_back(v);
+            g.AddV(v);
+        }
+        if (!JournalCodec<uint64_t>::Get(p, end, m))
+            return false;
+        for (uint64_t e = 0; e < m; ++e) {
+            uint64_t u, v;
+            W w;
+            if (!JournalCodec<uint64_t>::Get(p, end, u) || !JournalCodec<uint64_t>::Get(p, end, v)
+                || !JournalCodec<W>::Get(p, end, w) || u >= n || v >= n)
+                return false;
+            g.AddE(keys[u], keys[v], w);
+        }
+        return true;
+    }
+};
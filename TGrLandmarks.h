@@ -0,0 +1,344 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include <stdexcept>
+#include "TGrPool.h"
+#include "TGrComponents.h"
+
+using namespace std;
+
+/// <summary>
+/// Способ выбора ориентиров
+/// </summary>
+enum class LandmarkSelection : unsigned char {
+    Random,    // случайные вершины
+    Farthest,  // каждая следующая - самая далёкая от уже выбранных
+    Avoid      // вершины, "закрывающие" плохо оцениваемые поддеревья кратчайших путей
+};
+
+/// <summary>
+/// Статистика одного запроса AStar
+/// </summary>
+struct AStarStats {
+    /// <summary>
+    /// вершин извлечено из очереди окончательно
+    /// </summary>
+    size_t settled = 0;
+
+    /// <summary>
+    /// успешных релаксаций рёбер
+    /// </summary>
+    size_t relaxed = 0;
+
+    /// <summary>
+    /// вершин, отброшенных оценкой как не достигающих цели
+    /// </summary>
+    size_t pruned = 0;
+};
+
+namespace alt_detail {
+
+    /// <summary>
+    /// Алгоритм Дейкстры по CSR; dist заполняется значениями inf для недостижимых вершин.
+    /// parent (если не nullptr) - предок в дереве кратчайших путей или -1.
+    /// </summary>
+    template <typename W, typename I>
+    void Dijkstra(const vector<size_t>& offs, const vector<I>& targs, const vector<W>& ws,
+        I s, W inf, vector<W>& dist, vector<I>* parent = nullptr) {
+        size_t n = offs.size() - 1;
+        dist.assign(n, inf);
+        if (parent)
+            parent->assign(n, -1);
+        vector<pair<W, I>> heap;
+        auto later = [](const pair<W, I>& a, const pair<W, I>& b) { return a.first > b.first; };
+        dist[s] = W();
+        heap.emplace_back(W(), s);
+        while (!heap.empty()) {
+            pop_heap(heap.begin(), heap.end(), later);
+            W d = heap.back().first;
+            I u = heap.back().second;
+            heap.pop_back();
+            if (d > dist[u])
+                continue;
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e) {
+                I v = targs[e];
+                W nd = d + ws[e];
+                if (dist[v] == inf || nd < dist[v]) {
+                    dist[v] = nd;
+                    if (parent)
+                        (*parent)[v] = u;
+                    heap.emplace_back(nd, v);
+                    push_heap(heap.begin(), heap.end(), later);
+                }
+            }
+        }
+    }
+}
+
+/// <summary>
+/// Ориентиры для поиска ALT (A*, landmarks, triangle inequality).
+/// Для k ориентиров L хранятся расстояния d(L, v) и d(v, L) до каждой вершины;
+/// по неравенству треугольника d(v, t) >= max(d(L, t) - d(L, v), d(v, L) - d(t, L)) -
+/// допустимая и согласованная оценка для A*. Кроме того, если L достигает v, но не t,
+/// или t достигает L, а v нет, то t из v недостижима.
+/// Память: 2 * k * V * sizeof(W). Веса должны быть неотрицательны.
+/// Индекс соответствует графу на момент построения.
+/// </summary>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename W, typename I>
+class LandmarkIndex {
+public:
+
+    /// <summary>
+    /// Построение по взвешенному CSR. Ориентиры выбираются последовательно
+    /// (Farthest и Avoid используют прямые расстояния от уже выбранных),
+    /// затем 2k расстояний от и до ориентиров вычисляются параллельно.
+    /// Сложность: O(k * (V + E) log V)
+    /// </summary>
+    /// <param name="offs">смещения строк</param>
+    /// <param name="targs">приёмники рёбер</param>
+    /// <param name="ws">веса рёбер</param>
+    /// <param name="inf">обозначение "недостижима"</param>
+    /// <param name="k">число ориентиров (не больше числа вершин)</param>
+    /// <param name="sel">способ выбора</param>
+    /// <param name="pool">пул потоков или nullptr</param>
+    /// <param name="seed">зерно случайного выбора</param>
+    LandmarkIndex(const vector<size_t>& offs, const vector<I>& targs, const vector<W>& ws, W inf,
+        size_t k, LandmarkSelection sel = LandmarkSelection::Avoid, ThreadPool* pool = nullptr, uint32_t seed = 1)
+        : n(offs.size() - 1), inf(inf) {
+        k = min(k, n);
+        for (const W& w : ws)
+            if (w < W())
+                throw runtime_error("LandmarkIndex: ребро отрицательного веса");
+
+        mt19937 rng(seed);
+        Select(offs, targs, ws, k, sel, rng);
+
+        // обратный граф для расстояний до ориентиров
+        vector<size_t> rOffs;
+        vector<I> rTargs;
+        comp_detail::Reverse(offs, targs, rOffs, rTargs);
+        vector<W> rWs(ws.size());
+        {
+            vector<size_t> at(rOffs.begin(), rOffs.end() - 1);
+            for (size_t u = 0; u < n; ++u)
+                for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                    rWs[at[targs[e]]++] = ws[e];
+        }
+
+        size_t m = marks.size();
+        fwd.assign(n * m, inf);
+        bwd.assign(n * m, inf);
+        auto run = [&](size_t task, unsigned) {
+            size_t i = task / 2;
+            vector<W> dist;
+            if (task % 2 == 0)
+                alt_detail::Dijkstra(offs, targs, ws, marks[i], inf, dist);
+            else
+                alt_detail::Dijkstra(rOffs, rTargs, rWs, marks[i], inf, dist);
+            vector<W>& out = task % 2 == 0 ? fwd : bwd;
+            for (size_t v = 0; v < n; ++v)
+                out[v * m + i] = dist[v];
+        };
+        if (pool)
+            pool->ParallelFor(0, 2 * m, 1, run);
+        else
+            for (size_t t = 0; t < 2 * m; ++t)
+                run(t, 0);
+    }
+
+    /// <summary>
+    /// Нижняя оценка расстояния от v до t; inf, если t из v заведомо недостижима
+    /// </summary>
+    W Bound(I v, I t) const {
+        size_t m = marks.size();
+        const W* fv = fwd.data() + static_cast<size_t>(v) * m;
+        const W* ft = fwd.data() + static_cast<size_t>(t) * m;
+        const W* bv = bwd.data() + static_cast<size_t>(v) * m;
+        const W* bt = bwd.data() + static_cast<size_t>(t) * m;
+        W best = W();
+        for (size_t i = 0; i < m; ++i) {
+            // d(L, t) - d(L, v)
+            if (fv[i] != inf) {
+                if (ft[i] == inf)
+                    return inf;
+                if (ft[i] > fv[i] && ft[i] - fv[i] > best)
+                    best = ft[i] - fv[i];
+            }
+            // d(v, L) - d(t, L)
+            if (bt[i] != inf) {
+                if (bv[i] == inf)
+                    return inf;
+                if (bv[i] > bt[i] && bv[i] - bt[i] > best)
+                    best = bv[i] - bt[i];
+            }
+        }
+        return best;
+    }
+
+    /// <summary>
+    /// Индексы вершин-ориентиров
+    /// </summary>
+    const vector<I>& Landmarks() const {
+        return marks;
+    }
+
+    /// <summary>
+    /// Количество вершин графа, для которого построен индекс
+    /// </summary>
+    size_t Size() const {
+        return n;
+    }
+
+    /// <summary>
+    /// Обозначение "недостижима"
+    /// </summary>
+    W Inf() const {
+        return inf;
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return (fwd.capacity() + bwd.capacity()) * sizeof(W) + marks.capacity() * sizeof(I);
+    }
+
+private:
+    size_t n;
+    W inf;
+    vector<I> marks;
+
+    /// <summary>
+    /// fwd[v * k + i] = d(L_i, v), bwd[v * k + i] = d(v, L_i): оценка для вершины
+    /// читает по k подряд идущих значений из каждого массива
+    /// </summary>
+    vector<W> fwd;
+    vector<W> bwd;
+
+    void Select(const vector<size_t>& offs, const vector<I>& targs, const vector<W>& ws,
+        size_t k, LandmarkSelection sel, mt19937& rng) {
+        if (k == 0)
+            return;
+        if (sel == LandmarkSelection::Random) {
+            vector<I> all(n);
+            for (size_t v = 0; v < n; ++v)
+                all[v] = static_cast<I>(v);
+            shuffle(all.begin(), all.end(), rng);
+            marks.assign(all.begin(), all.begin() + k);
+            return;
+        }
+
+        // прямые расстояния от выбранных ориентиров (только для выбора)
+        vector<vector<W>> from;
+        vector<char> chosen(n, 0);
+        auto add = [&](I v) {
+            marks.push_back(v);
+            chosen[v] = 1;
+            from.emplace_back();
+            alt_detail::Dijkstra(offs, targs, ws, v, inf, from.back());
+        };
+
+        if (sel == LandmarkSelection::Farthest) {
+            // первый - самая далёкая вершина от случайной; далее максимум наименьшего
+            // расстояния до выбранных (недостижимые вершины считаются самыми далёкими)
+            vector<W> d0;
+            alt_detail::Dijkstra(offs, targs, ws, static_cast<I>(rng() % n), inf, d0);
+            add(Farthest(d0, chosen));
+            vector<W> nearest = from.back();
+            while (marks.size() < k) {
+                add(Farthest(nearest, chosen));
+                for (size_t v = 0; v < n; ++v)
+                    if (from.back()[v] != inf && (nearest[v] == inf || from.back()[v] < nearest[v]))
+                        nearest[v] = from.back()[v];
+            }
+            return;
+        }
+
+        // Avoid (Goldberg, Werneck): дерево кратчайших путей из случайного корня r,
+        // вес вершины - ошибка оценки d(r, v) - h(r, v) по выбранным ориентирам,
+        // размер - сумма весов поддерева (0, если в поддереве есть ориентир);
+        // спуск от корня к потомку наибольшего размера до листа даёт новый ориентир
+        vector<W> dist;
+        vector<I> parent;
+        while (marks.size() < k) {
+            I r = static_cast<I>(rng() % n);
+            alt_detail::Dijkstra(offs, targs, ws, r, inf, dist, &parent);
+            // порядок дерева от корня (предки раньше потомков, в том числе при нулевых весах)
+            vector<size_t> cOffs(n + 1, 0);
+            vector<I> kids;
+            for (size_t v = 0; v < n; ++v)
+                if (parent[v] >= 0)
+                    ++cOffs[parent[v] + 1];
+            for (size_t v = 0; v < n; ++v)
+                cOffs[v + 1] += cOffs[v];
+            kids.resize(cOffs[n]);
+            {
+                vector<size_t> at(cOffs.begin(), cOffs.end() - 1);
+                for (size_t v = 0; v < n; ++v)
+                    if (parent[v] >= 0)
+                        kids[at[parent[v]]++] = static_cast<I>(v);
+            }
+            vector<I> order(1, r);
+            for (size_t head = 0; head < order.size(); ++head)
+                for (size_t e = cOffs[order[head]]; e < cOffs[order[head] + 1]; ++e)
+                    order.push_back(kids[e]);
+
+            vector<double> size(n, 0.0);
+            vector<char> covered(n, 0);
+            vector<I> bestChild(n, -1);
+            for (auto it = order.rbegin(); it != order.rend(); ++it) {
+                I v = *it;
+                if (chosen[v])
+                    covered[v] = 1;
+                if (covered[v])
+                    size[v] = 0;
+                else {
+                    W h = W();
+                    for (size_t i = 0; i < from.size(); ++i)
+                        if (from[i][r] != inf && from[i][v] != inf && from[i][v] > from[i][r] && from[i][v] - from[i][r] > h)
+                            h = from[i][v] - from[i][r];
+                    size[v] += static_cast<double>(dist[v] - h) + 1e-9;
+                }
+                I p = parent[v];
+                if (p >= 0) {
+                    if (covered[v])
+                        covered[p] = 1;
+                    size[p] += size[v];
+                    if (bestChild[p] < 0 || size[v] > size[bestChild[p]])
+                        bestChild[p] = v;
+                }
+            }
+            I leaf = r;
+            while (bestChild[leaf] >= 0 && size[bestChild[leaf]] > 0)
+                leaf = bestChild[leaf];
+            if (chosen[leaf]) {
+                // всё дерево уже покрыто: берём любую невыбранную вершину
+                for (size_t v = 0; v < n; ++v)
+                    if (!chosen[v]) {
+                        leaf = static_cast<I>(v);
+                        break;
+                    }
+            }
+            add(leaf);
+        }
+    }
+
+    /// <summary>
+    /// Невыбранная вершина с наибольшим расстоянием (inf - наибольшее)
+    /// </summary>
+    I Farthest(const vector<W>& d, const vector<char>& chosen) const {
+        I best = -1;
+        for (size_t v = 0; v < n; ++v) {
+            if (chosen[v])
+                continue;
+            if (best < 0 || (d[best] != inf && (d[v] == inf || d[v] > d[best])))
+                best = static_cast<I>(v);
+        }
+        return best;
+    }
+};
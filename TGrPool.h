@@ -0,0 +1,207 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <algorithm>
+#include <chrono>
+#include <exception>
+
+using namespace std;
+
+/// <summary>
+/// Пул потоков с перехватом задач (work stealing).
+/// У каждого рабочего потока своя очередь: свои задачи он берёт с конца,
+/// а простаивая, забирает задачи из начала чужих очередей.
+/// Пул создаётся один раз и переиспользуется всеми пакетными запросами.
+/// </summary>
+class ThreadPool {
+public:
+
+    /// <summary>
+    /// Конструктор
+    /// </summary>
+    /// <param name="threads">число рабочих потоков, 0 - по числу ядер</param>
+    explicit ThreadPool(unsigned threads = 0) {
+        if (threads == 0)
+            threads = max(1u, thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i)
+            queues.emplace_back(new WorkQueue());
+        for (unsigned i = 0; i < threads; ++i)
+            workers.emplace_back([this, i]() { Run(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            lock_guard<mutex> lk(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& t : workers)
+            t.join();
+    }
+
+    /// <summary>
+    /// Количество рабочих потоков
+    /// </summary>
+    unsigned Workers() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    /// <summary>
+    /// Постановка задачи в очередь
+    /// </summary>
+    void Submit(function<void()> task) {
+        unsigned q = current.pool == this ? current.index
+            : static_cast<unsigned>(next.fetch_add(1, memory_order_relaxed) % queues.size());
+        {
+            lock_guard<mutex> lk(queues[q]->lock);
+            queues[q]->tasks.push_back(move(task));
+        }
+        pending.fetch_add(1, memory_order_release);
+        {
+            lock_guard<mutex> lk(sleepLock);
+        }
+        wake.notify_one();
+    }
+
+    /// <summary>
+    /// Параллельный цикл: f(i, slot) для i из [begin, end), блоками по grain.
+    /// Блоки разбирают вызывающий поток и до Workers() исполнителей, поставленных в пул;
+    /// каждый участник получает свой slot из [0, Workers()] на время вызова, поэтому
+    /// slot - индекс в массиве рабочих областей размера Workers() + 1, не общий ни с кем,
+    /// даже если ParallelFor одновременно вызывают несколько потоков или задачи пула.
+    /// Вызывающий поток выполняет только блоки своего вызова.
+    /// Первое исключение из f пробрасывается вызывающему после завершения всех блоков.
+    /// </summary>
+    template <typename F>
+    void ParallelFor(size_t begin, size_t end, size_t grain, F f) {
+        if (begin >= end)
+            return;
+        grain = max<size_t>(grain, 1);
+        auto call = make_shared<Call>();
+        call->chunks = (end - begin + grain - 1) / grain;
+        call->left = call->chunks;
+
+        // исполнитель: занимает номер, затем разбирает блоки, пока они есть;
+        // опоздавший исполнитель блоков не получает и к f не обращается
+        auto work = [call, begin, end, grain, &f]() {
+            unsigned slot = call->slots.fetch_add(1, memory_order_relaxed);
+            for (;;) {
+                size_t c = call->next.fetch_add(1, memory_order_relaxed);
+                if (c >= call->chunks)
+                    return;
+                size_t lo = begin + c * grain;
+                size_t hi = min(end, lo + grain);
+                try {
+                    for (size_t i = lo; i < hi; ++i)
+                        f(i, slot);
+                }
+                catch (...) {
+                    lock_guard<mutex> lk(call->errorLock);
+                    if (!call->error)
+                        call->error = current_exception();
+                }
+                call->left.fetch_sub(1, memory_order_acq_rel);
+            }
+        };
+        size_t helpers = min<size_t>(call->chunks - 1, Workers());
+        for (size_t h = 0; h < helpers; ++h)
+            Submit(work);
+        work();
+        // блоки, взятые исполнителями, завершатся без нашего участия
+        while (call->left.load(memory_order_acquire) != 0)
+            this_thread::yield();
+        if (call->error)
+            rethrow_exception(call->error);
+    }
+
+private:
+
+    struct WorkQueue {
+        mutex lock;
+        deque<function<void()>> tasks;
+    };
+
+    /// <summary>
+    /// Состояние одного вызова ParallelFor (разделяется с исполнителями в очередях)
+    /// </summary>
+    struct Call {
+        size_t chunks = 0;
+        atomic<size_t> next{ 0 };
+        atomic<size_t> left{ 0 };
+        atomic<unsigned> slots{ 0 };
+        mutex errorLock;
+        exception_ptr error;
+    };
+
+    vector<unique_ptr<WorkQueue>> queues;
+    vector<thread> workers;
+    atomic<size_t> pending{ 0 };
+    atomic<size_t> next{ 0 };
+    mutex sleepLock;
+    condition_variable wake;
+    bool stopping = false;
+
+    /// <summary>
+    /// описание текущего потока (чей он и под каким номером)
+    /// </summary>
+    struct Current {
+        const ThreadPool* pool;
+        unsigned index;
+    };
+    static thread_local Current current;
+
+    /// <summary>
+    /// Взять задачу: сначала из своей очереди (с конца), затем украсть из чужих (с начала)
+    /// </summary>
+    bool RunOne(unsigned self) {
+        function<void()> task;
+        {
+            WorkQueue& own = *queues[self];
+            lock_guard<mutex> lk(own.lock);
+            if (!own.tasks.empty()) {
+                task = move(own.tasks.back());
+                own.tasks.pop_back();
+            }
+        }
+        for (size_t k = 1; !task && k < queues.size(); ++k) {
+            WorkQueue& victim = *queues[(self + k) % queues.size()];
+            lock_guard<mutex> lk(victim.lock);
+            if (!victim.tasks.empty()) {
+                task = move(victim.tasks.front());
+                victim.tasks.pop_front();
+            }
+        }
+        if (!task)
+            return false;
+        pending.fetch_sub(1, memory_order_acq_rel);
+        task();
+        return true;
+    }
+
+    void Run(unsigned index) {
+        current.pool = this;
+        current.index = index;
+        for (;;) {
+            if (RunOne(index))
+                continue;
+            unique_lock<mutex> lk(sleepLock);
+            wake.wait_for(lk, chrono::milliseconds(50), [this]() {
+                return stopping || pending.load(memory_order_acquire) != 0;
+            });
+            if (stopping && pending.load(memory_order_acquire) == 0)
+                return;
+        }
+    }
+};
+
+inline thread_local ThreadPool::Current ThreadPool::current = { nullptr, 0 };
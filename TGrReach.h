@@ -0,0 +1,335 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+#include "TGrPool.h"
+#include "TGrComponents.h"
+#include "TGrWorkspace.h"
+
+using namespace std;
+
+/// <summary>
+/// Параметры индекса достижимости
+/// </summary>
+struct ReachOptions {
+    /// <summary>
+    /// наибольший размер транзитивного замыкания (битовых строк), байт;
+    /// при большем числе компонент используется интервальная разметка
+    /// </summary>
+    size_t maxBitsetBytes = size_t(64) << 20;
+
+    /// <summary>
+    /// число интервальных разметок (больше - реже нужен поиск при отрицательном ответе)
+    /// </summary>
+    unsigned labelings = 3;
+
+    /// <summary>
+    /// зерно случайного порядка обхода разметок
+    /// </summary>
+    uint32_t seed = 1;
+};
+
+/// <summary>
+/// Индекс достижимости "существует ли путь из u в v".
+/// Граф сжимается до ациклического графа сильно связных компонент (вершины одной
+/// компоненты взаимно достижимы), затем:
+/// - если замыкание помещается в maxBitsetBytes - для каждой компоненты хранится
+///   битовая строка достижимых компонент, запрос O(1);
+/// - иначе - топологические номера и несколько интервальных разметок (GRAIL):
+///   u не достигает v, если интервал v не вложен в интервал u хотя бы в одной разметке.
+///   Отрицательные ответы обычно даются за O(k), остальные - обходом с тем же отсечением.
+/// Построение параллельно при наличии пула (SCC, уровни замыкания, разметки).
+/// Индекс не меняется после построения; запросы безопасны из нескольких потоков.
+/// </summary>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename I>
+class ReachabilityIndex {
+public:
+
+    /// <summary>
+    /// Построение по CSR: рёбра вершины u - targs[offs[u] .. offs[u + 1])
+    /// Сложность: O(V + E + C * C / 64) с замыканием, O(k * (V + E)) с разметкой
+    /// </summary>
+    /// <param name="offs">смещения строк</param>
+    /// <param name="targs">приёмники рёбер</param>
+    /// <param name="pool">пул потоков или nullptr</param>
+    /// <param name="opt">параметры</param>
+    ReachabilityIndex(const vector<size_t>& offs, const vector<I>& targs,
+        ThreadPool* pool = nullptr, const ReachOptions& opt = ReachOptions()) {
+        ::Components<I> scc = pool ? SccForwardBackward(offs, targs, *pool) : SccTarjan(offs, targs);
+        comp = move(scc.id);
+        size_t c = scc.Count();
+        BuildDag(offs, targs, c);
+        BuildTopo(c);
+
+        words = (c + 63) / 64;
+        if (c * words * sizeof(uint64_t) <= opt.maxBitsetBytes)
+            BuildClosure(c, pool);
+        else
+            BuildLabels(c, pool, opt);
+    }
+
+    /// <summary>
+    /// Достижима ли вершина v из вершины u (по индексам; вершина достижима из себя).
+    /// Индексы за пределами построенного графа считаются изолированными вершинами.
+    /// </summary>
+    bool CanReach(I u, I v) const {
+        if (u == v)
+            return true;
+        size_t n = comp.size();
+        if (static_cast<size_t>(u) >= n || static_cast<size_t>(v) >= n)
+            return false;
+        I a = comp[u], b = comp[v];
+        if (a == b)
+            return true;
+        if (!bits.empty())
+            return (bits[static_cast<size_t>(a) * words + b / 64] >> (b % 64)) & 1;
+        if (!Contains(a, b))
+            return false;
+
+        // поиск в графе компонент с отсечением по топологическому номеру и интервалам
+        static thread_local TraversalWorkspace<char, I> ws;
+        ws.Begin(pos.size());
+        vector<I>& st = ws.Frontier();
+        st.push_back(a);
+        ws.Visit(a);
+        while (!st.empty()) {
+            I x = st.back();
+            st.pop_back();
+            for (size_t e = dOffs[x]; e < dOffs[x + 1]; ++e) {
+                I y = dTargs[e];
+                if (y == b)
+                    return true;
+                if (ws.Visited(y) || !Contains(y, b))
+                    continue;
+                ws.Visit(y);
+                st.push_back(y);
+            }
+        }
+        return false;
+    }
+
+    /// <summary>
+    /// Количество вершин, для которых построен индекс
+    /// </summary>
+    size_t Size() const {
+        return comp.size();
+    }
+
+    /// <summary>
+    /// Количество сильно связных компонент
+    /// </summary>
+    size_t Components() const {
+        return pos.size();
+    }
+
+    /// <summary>
+    /// Используется ли полное замыкание (иначе интервальная разметка)
+    /// </summary>
+    bool UsesClosure() const {
+        return !bits.empty() || pos.empty();
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return comp.capacity() * sizeof(I) + dOffs.capacity() * sizeof(size_t)
+            + dTargs.capacity() * sizeof(I) + pos.capacity() * sizeof(I)
+            + bits.capacity() * sizeof(uint64_t) + labels.capacity() * sizeof(uint32_t);
+    }
+
+private:
+
+    /// <summary>
+    /// компонента каждой вершины
+    /// </summary>
+    vector<I> comp;
+
+    /// <summary>
+    /// граф компонент (CSR без повторных рёбер)
+    /// </summary>
+    vector<size_t> dOffs;
+    vector<I> dTargs;
+
+    /// <summary>
+    /// номер компоненты в топологическом порядке
+    /// </summary>
+    vector<I> pos;
+
+    /// <summary>
+    /// замыкание: words слов на компоненту
+    /// </summary>
+    size_t words = 0;
+    vector<uint64_t> bits;
+
+    /// <summary>
+    /// разметки: для компоненты c и разметки j - пара (low, post) по адресу (c * k + j) * 2
+    /// </summary>
+    unsigned k = 0;
+    vector<uint32_t> labels;
+
+    /// <summary>
+    /// Может ли компонента a достигать компоненты b по топологическому номеру и разметкам
+    /// </summary>
+    bool Contains(I a, I b) const {
+        if (pos[a] > pos[b])
+            return false;
+        const uint32_t* la = labels.data() + static_cast<size_t>(a) * k * 2;
+        const uint32_t* lb = labels.data() + static_cast<size_t>(b) * k * 2;
+        for (unsigned j = 0; j < k; ++j)
+            if (lb[2 * j] < la[2 * j] || lb[2 * j + 1] > la[2 * j + 1])
+                return false;
+        return true;
+    }
+
+    void BuildDag(const vector<size_t>& offs, const vector<I>& targs, size_t c) {
+        size_t n = offs.size() - 1;
+        vector<pair<I, I>> arcs;
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                if (comp[u] != comp[targs[e]])
+                    arcs.emplace_back(comp[u], comp[targs[e]]);
+        sort(arcs.begin(), arcs.end());
+        arcs.erase(unique(arcs.begin(), arcs.end()), arcs.end());
+        dOffs.assign(c + 1, 0);
+        dTargs.resize(arcs.size());
+        for (size_t i = 0; i < arcs.size(); ++i) {
+            ++dOffs[arcs[i].first + 1];
+            dTargs[i] = arcs[i].second;
+        }
+        for (size_t i = 0; i < c; ++i)
+            dOffs[i + 1] += dOffs[i];
+    }
+
+    /// <summary>
+    /// Топологический порядок графа компонент (алгоритм Кана)
+    /// </summary>
+    void BuildTopo(size_t c) {
+        vector<I> indeg(c, 0), order;
+        order.reserve(c);
+        for (I v : dTargs)
+            ++indeg[v];
+        for (size_t v = 0; v < c; ++v)
+            if (indeg[v] == 0)
+                order.push_back(static_cast<I>(v));
+        for (size_t head = 0; head < order.size(); ++head) {
+            I u = order[head];
+            for (size_t e = dOffs[u]; e < dOffs[u + 1]; ++e)
+                if (--indeg[dTargs[e]] == 0)
+                    order.push_back(dTargs[e]);
+        }
+        pos.resize(c);
+        for (size_t i = 0; i < c; ++i)
+            pos[order[i]] = static_cast<I>(i);
+    }
+
+    /// <summary>
+    /// Замыкание по уровням высоты: компоненты одного уровня зависят только от нижних
+    /// уровней и обрабатываются параллельно
+    /// </summary>
+    void BuildClosure(size_t c, ThreadPool* pool) {
+        vector<I> order(c);
+        for (size_t v = 0; v < c; ++v)
+            order[pos[v]] = static_cast<I>(v);
+        vector<I> height(c, 0);
+        I top = 0;
+        for (size_t i = c; i-- > 0;) {
+            I u = order[i];
+            for (size_t e = dOffs[u]; e < dOffs[u + 1]; ++e)
+                height[u] = max(height[u], static_cast<I>(height[dTargs[e]] + 1));
+            top = max(top, height[u]);
+        }
+        vector<vector<I>> levels(c ? static_cast<size_t>(top) + 1 : 0);
+        for (size_t v = 0; v < c; ++v)
+            levels[height[v]].push_back(static_cast<I>(v));
+
+        bits.assign(c * words, 0);
+        for (const vector<I>& level : levels) {
+            auto fill = [&](size_t i, unsigned) {
+                I u = level[i];
+                uint64_t* row = bits.data() + static_cast<size_t>(u) * words;
+                row[u / 64] |= uint64_t(1) << (u % 64);
+                for (size_t e = dOffs[u]; e < dOffs[u + 1]; ++e) {
+                    const uint64_t* src = bits.data() + static_cast<size_t>(dTargs[e]) * words;
+                    for (size_t w = 0; w < words; ++w)
+                        row[w] |= src[w];
+                }
+            };
+            if (pool && level.size() > 1)
+                pool->ParallelFor(0, level.size(), 8, fill);
+            else
+                for (size_t i = 0; i < level.size(); ++i)
+                    fill(i, 0);
+        }
+    }
+
+    /// <summary>
+    /// Интервальные разметки: обход в глубину в случайном порядке, post - номер
+    /// завершения, low - наименьший post среди потомков. Разметки независимы
+    /// и строятся параллельно.
+    /// </summary>
+    void BuildLabels(size_t c, ThreadPool* pool, const ReachOptions& opt) {
+        k = max(1u, opt.labelings);
+        labels.assign(c * k * 2, 0);
+        vector<I> roots;
+        vector<char> hasIn(c, 0);
+        for (I v : dTargs)
+            hasIn[v] = 1;
+        for (size_t v = 0; v < c; ++v)
+            if (!hasIn[v])
+                roots.push_back(static_cast<I>(v));
+
+        auto label = [&](size_t j, unsigned) {
+            mt19937 rng(opt.seed + static_cast<uint32_t>(j));
+            vector<I> rs = roots;
+            shuffle(rs.begin(), rs.end(), rng);
+            vector<char> done(c, 0);
+            vector<pair<I, size_t>> frames; // компонента и число просмотренных рёбер
+            vector<size_t> shift(c);
+            for (size_t v = 0; v < c; ++v) {
+                size_t deg = dOffs[v + 1] - dOffs[v];
+                shift[v] = deg ? rng() % deg : 0;
+            }
+            uint32_t rank = 0;
+            for (I r : rs) {
+                frames.emplace_back(r, 0);
+                done[r] = 1;
+                labels[(static_cast<size_t>(r) * k + j) * 2] = UINT32_MAX;
+                while (!frames.empty()) {
+                    I u = frames.back().first;
+                    size_t& seen = frames.back().second;
+                    size_t deg = dOffs[u + 1] - dOffs[u];
+                    uint32_t* lu = labels.data() + (static_cast<size_t>(u) * k + j) * 2;
+                    if (seen < deg) {
+                        // рёбра в порядке со случайным сдвигом
+                        I v = dTargs[dOffs[u] + (shift[u] + seen) % deg];
+                        ++seen;
+                        if (!done[v]) {
+                            done[v] = 1;
+                            labels[(static_cast<size_t>(v) * k + j) * 2] = UINT32_MAX;
+                            frames.emplace_back(v, 0);
+                        }
+                        else
+                            lu[0] = min(lu[0], labels[(static_cast<size_t>(v) * k + j) * 2]);
+                        continue;
+                    }
+                    lu[1] = rank++;
+                    lu[0] = min(lu[0], lu[1]);
+                    frames.pop_back();
+                    if (!frames.empty()) {
+                        uint32_t* lp = labels.data() + (static_cast<size_t>(frames.back().first) * k + j) * 2;
+                        lp[0] = min(lp[0], lu[0]);
+                    }
+                }
+            }
+        };
+        if (pool && k > 1)
+            pool->ParallelFor(0, k, 1, label);
+        else
+            for (size_t j = 0; j < k; ++j)
+                label(j, 0);
+    }
+};
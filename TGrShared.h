@@ -0,0 +1,182 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <utility>
+#include <cstdint>
+#include "TGr.h"
+
+using namespace std;
+
+/// <summary>
+/// Граф для одновременного чтения и записи с изоляцией снимков (в стиле RCU).
+/// Читатели получают неизменяемый снимок графа и работают с ним без блокировок;
+/// писатель копирует текущую версию, применяет пакет изменений и атомарно
+/// публикует новую версию. Старая версия освобождается, когда её отпустит
+/// последний читатель (подсчёт ссылок shared_ptr).
+/// </summary>
+/// <typeparam name="G">тип графа, например DGraph&lt;string, double&gt;</typeparam>
+template <typename G>
+class SharedDGraph {
+private:
+
+    /// <summary>
+    /// текущая опубликованная версия (доступ через atomic_load / atomic_store)
+    /// </summary>
+    shared_ptr<const G> current;
+
+    /// <summary>
+    /// номер версии; читатели сверяют его, чтобы не трогать общий счётчик ссылок без нужды
+    /// </summary>
+    atomic<uint64_t> version;
+
+    /// <summary>
+    /// писатели выполняются по одному
+    /// </summary>
+    mutex writeLock;
+
+public:
+
+    /// <summary>
+    /// Конструктор
+    /// </summary>
+    /// <param name="initial">начальная версия графа</param>
+    explicit SharedDGraph(G initial)
+        : current(make_shared<const G>(move(initial))), version(1) {}
+
+    SharedDGraph(const SharedDGraph&) = delete;
+    SharedDGraph& operator=(const SharedDGraph&) = delete;
+
+    /// <summary>
+    /// Текущий снимок. Снимок не меняется, пока на него есть ссылка.
+    /// </summary>
+    shared_ptr<const G> Snapshot() const {
+        return atomic_load(&current);
+    }
+
+    /// <summary>
+    /// Номер опубликованной версии
+    /// </summary>
+    uint64_t Version() const {
+        return version.load(memory_order_acquire);
+    }
+
+    /// <summary>
+    /// Читатель, принадлежащий одному потоку. Хранит свою ссылку на снимок и
+    /// обновляет её только при смене версии, поэтому в установившемся режиме
+    /// чтение не пишет в общую память и масштабируется по ядрам.
+    /// </summary>
+    class Reader {
+    public:
+        explicit Reader(const SharedDGraph& owner)
+            : owner(owner), seen(owner.Version()), snap(owner.Snapshot()) {}
+
+        /// <summary>
+        /// Актуальный снимок графа
+        /// </summary>
+        const G& Get() {
+            uint64_t v = owner.Version();
+            if (v != seen) {
+                snap = owner.Snapshot();
+                seen = v;
+            }
+            return *snap;
+        }
+
+        /// <summary>
+        /// Номер версии последнего полученного снимка
+        /// </summary>
+        uint64_t Version() const {
+            return seen;
+        }
+
+    private:
+        const SharedDGraph& owner;
+        uint64_t seen;
+        shared_ptr<const G> snap;
+    };
+
+    /// <summary>
+    /// Пакет изменений. Держит блокировку писателя и рабочую копию графа;
+    /// изменения видны читателям только после Publish.
+    /// </summary>
+    class Writer {
+    public:
+        explicit Writer(SharedDGraph& owner)
+            : owner(&owner), lock(owner.writeLock), draft(new G(*owner.Snapshot())) {}
+
+        Writer(Writer&&) = default;
+
+        /// <summary>
+        /// Рабочая копия графа для произвольных изменений
+        /// </summary>
+        G& Graph() {
+            Check();
+            return *draft;
+        }
+
+        template <typename V>
+        void AddV(const V& value) {
+            Graph().AddV(value);
+        }
+
+        template <typename V>
+        void DeleteV(const V& value) {
+            Graph().DeleteV(value);
+        }
+
+        template <typename V, typename Wt>
+        void AddE(const V& from, const V& to, Wt weight) {
+            Graph().AddE(from, to, weight);
+        }
+
+        template <typename V>
+        void DeleteE(const V& from, const V& to) {
+            Graph().DeleteE(from, to);
+        }
+
+        /// <summary>
+        /// Атомарная публикация новой версии. После неё писатель недействителен.
+        /// </summary>
+        /// <returns>номер опубликованной версии</returns>
+        uint64_t Publish() {
+            Check();
+            shared_ptr<const G> next(draft.release());
+            atomic_store(&owner->current, move(next));
+            uint64_t v = owner->version.fetch_add(1, memory_order_acq_rel) + 1;
+            lock.unlock();
+            return v;
+        }
+
+    private:
+        void Check() const {
+            if (!draft)
+                throw runtime_error("SharedDGraph: пакет уже опубликован");
+        }
+
+        SharedDGraph* owner;
+        unique_lock<mutex> lock;
+        unique_ptr<G> draft;
+    };
+
+    /// <summary>
+    /// Начало пакета изменений (копирование текущей версии)
+    /// Сложность: O(размер графа)
+    /// </summary>
+    Writer BeginWrite() {
+        return Writer(*this);
+    }
+
+    /// <summary>
+    /// Изменение графа одной функцией f(G&) с публикацией результата.
+    /// Если f бросает исключение, ничего не публикуется.
+    /// </summary>
+    /// <returns>номер опубликованной версии</returns>
+    template <typename F>
+    uint64_t Update(F f) {
+        Writer w(*this);
+        f(w.Graph());
+        return w.Publish();
+    }
+};
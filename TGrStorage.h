@@ -0,0 +1,633 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include "TGrIndex.h"
+
+using namespace std;
+
+/// <summary>
+/// Тип весов для невзвешенного графа: вес не хранится вовсе.
+/// Пример: DGraph&lt;int, Unweighted, allocator&lt;char&gt;, DenseBitmap&gt; g(Unweighted());
+/// </summary>
+struct Unweighted {
+    bool operator==(const Unweighted&) const {
+        return true;
+    }
+    bool operator!=(const Unweighted&) const {
+        return false;
+    }
+};
+
+inline ostream& operator<<(ostream& os, const Unweighted&) {
+    return os << 1;
+}
+
+inline istream& operator>>(istream& is, Unweighted&) {
+    double ignored;
+    return is >> ignored;
+}
+
+/// <summary>
+/// Номер младшего установленного бита 64-битного слова (mask != 0)
+/// </summary>
+inline int LowBit64(uint64_t mask) {
+#ifdef _MSC_VER
+    unsigned long i;
+#ifdef _M_X64
+    _BitScanForward64(&i, mask);
+    return static_cast<int>(i);
+#else
+    if (static_cast<uint32_t>(mask)) {
+        _BitScanForward(&i, static_cast<uint32_t>(mask));
+        return static_cast<int>(i);
+    }
+    _BitScanForward(&i, static_cast<uint32_t>(mask >> 32));
+    return static_cast<int>(i) + 32;
+#endif
+#else
+    return __builtin_ctzll(mask);
+#endif
+}
+
+/// <summary>
+/// Память хранилища рёбер, байт
+/// </summary>
+struct StorageMemory {
+    /// <summary>
+    /// структура: заголовки строк, битовые карты, приёмники списков
+    /// </summary>
+    size_t adjacency = 0;
+
+    /// <summary>
+    /// веса (у матрицы с INF - все ячейки, у списков - с выравниванием элемента)
+    /// </summary>
+    size_t weights = 0;
+
+    /// <summary>
+    /// выделено сверх используемого, освобождается ShrinkToFit; входит в adjacency и weights
+    /// </summary>
+    size_t slack = 0;
+};
+
+namespace storage_detail {
+
+    /// <summary>
+    /// Память массива строк: заголовки прибавляются к headers, элементы - к cells,
+    /// ёмкость сверх размера - к slack
+    /// </summary>
+    template <typename Rows>
+    void RowsMemory(const Rows& rows, size_t& headers, size_t& cells, size_t& slack) {
+        using Row = typename Rows::value_type;
+        using X = typename Row::value_type;
+        headers += rows.capacity() * sizeof(Row);
+        slack += (rows.capacity() - rows.size()) * sizeof(Row);
+        for (const Row& r : rows) {
+            cells += r.capacity() * sizeof(X);
+            slack += (r.capacity() - r.size()) * sizeof(X);
+        }
+    }
+
+    /// <summary>
+    /// Освобождение ёмкости массива строк и каждой строки
+    /// </summary>
+    template <typename Rows>
+    void ShrinkRows(Rows& rows) {
+        rows.shrink_to_fit();
+        for (auto& r : rows)
+            r.shrink_to_fit();
+    }
+}
+
+/// <summary>
+/// Плотная матрица смежности с обозначением "нет ребра" = INF.
+/// Стоимость: sizeof(W) на ячейку. Поведение DGraph по умолчанию.
+/// </summary>
+template <typename W, typename I, typename A>
+class SentinelMatrix {
+    static_assert(!is_same<W, Unweighted>::value, "SentinelMatrix: для невзвешенного графа используйте DenseBitmap");
+
+    template <typename U>
+    using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+    using Row = vector<W, Alloc<W>>;
+
+    /// <summary>
+    /// adj[i][j] = вес ребра, направленного из i в j
+    /// </summary>
+    vector<Row, Alloc<Row>> adj;
+
+    W INF;
+
+public:
+
+    SentinelMatrix(W inf, const A& alloc) : adj(Alloc<Row>(alloc)), INF(inf) {}
+
+    I Size() const {
+        return static_cast<I>(adj.size());
+    }
+
+    void AddVertex() {
+        // Добавляем столбец INF в каждую существующую строку
+        for (size_t i = 0; i < adj.size(); ++i)
+            adj[i].push_back(INF);
+        // Добавляем новую строку (все INF)
+        adj.push_back(Row(adj.size() + 1, INF, Alloc<W>(adj.get_allocator())));
+    }
+
+    void EraseVertex(I idx) {
+        adj.erase(adj.begin() + idx);
+        for (size_t i = 0; i < adj.size(); ++i)
+            adj[i].erase(adj[i].begin() + idx);
+    }
+
+    void Clear() {
+        adj.clear();
+    }
+
+    StorageMemory Memory() const {
+        StorageMemory m;
+        storage_detail::RowsMemory(adj, m.adjacency, m.weights, m.slack);
+        return m;
+    }
+
+    void ShrinkToFit() {
+        storage_detail::ShrinkRows(adj);
+    }
+
+    /// <summary>
+    /// Перенумерация вершин: вершина u получает индекс to[u]
+    /// </summary>
+    void Permute(const vector<I>& to) {
+        size_t n = adj.size();
+        vector<Row, Alloc<Row>> fresh(adj.get_allocator());
+        fresh.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            fresh.push_back(Row(n, INF, Alloc<W>(adj.get_allocator())));
+        for (size_t u = 0; u < n; ++u)
+            for (size_t v = 0; v < n; ++v)
+                fresh[to[u]][to[v]] = adj[u][v];
+        adj.swap(fresh);
+    }
+
+    bool Has(I u, I v) const {
+        return adj[u][v] != INF;
+    }
+
+    W Get(I u, I v) const {
+        return adj[u][v];
+    }
+
+    void Set(I u, I v, W w) {
+        adj[u][v] = w;
+    }
+
+    void Reset(I u, I v) {
+        adj[u][v] = INF;
+    }
+
+    /// <summary>
+    /// Применение изменений строки u; [first, last) упорядочены по to, элемент: to, w, erase
+    /// </summary>
+    template <typename It>
+    void MergeRow(I u, It first, It last) {
+        W* row = adj[u].data();
+        for (; first != last; ++first)
+            row[first->to] = first->erase ? INF : first->w;
+    }
+
+    /// <summary>
+    /// Обход исходящих рёбер u по возрастанию индекса: f(v, w)
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        const W* row = adj[u].data();
+        I n = Size();
+        for (I v = 0; v < n; ++v)
+            if (row[v] != INF)
+                f(v, row[v]);
+    }
+
+    /// <summary>
+    /// Количество элементов, просматриваемых ForEachOut(u)
+    /// </summary>
+    size_t ScanCost(I) const {
+        return adj.size();
+    }
+};
+
+namespace storage_detail {
+
+    /// <summary>
+    /// Удаление бита idx из битовой строки длины nbits со сдвигом старших битов вниз
+    /// </summary>
+    template <typename Words>
+    void EraseBit(Words& row, size_t idx, size_t nbits) {
+        size_t word = idx / 64;
+        size_t bit = idx % 64;
+        uint64_t low = bit ? (row[word] & ((uint64_t(1) << bit) - 1)) : 0;
+        uint64_t high = bit < 63 ? (row[word] >> (bit + 1)) << bit : 0;
+        row[word] = low | high;
+        for (size_t w = word + 1; w < row.size(); ++w) {
+            row[w - 1] |= (row[w] & 1) << 63;
+            row[w] >>= 1;
+        }
+        size_t words = (nbits - 1 + 63) / 64;
+        row.resize(words);
+    }
+
+    /// <summary>
+    /// Столбец весов плотной матрицы
+    /// </summary>
+    template <typename W, typename I, typename A>
+    class DenseWeights {
+        template <typename U>
+        using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+        using Row = vector<W, Alloc<W>>;
+        vector<Row, Alloc<Row>> w;
+
+    public:
+        explicit DenseWeights(const A& alloc) : w(Alloc<Row>(alloc)) {}
+
+        void AddVertex() {
+            for (size_t i = 0; i < w.size(); ++i)
+                w[i].push_back(W());
+            w.push_back(Row(w.size() + 1, W(), Alloc<W>(w.get_allocator())));
+        }
+
+        void EraseVertex(I idx) {
+            w.erase(w.begin() + idx);
+            for (size_t i = 0; i < w.size(); ++i)
+                w[i].erase(w[i].begin() + idx);
+        }
+
+        void Clear() {
+            w.clear();
+        }
+
+        void Memory(StorageMemory& m) const {
+            RowsMemory(w, m.adjacency, m.weights, m.slack);
+        }
+
+        void ShrinkToFit() {
+            ShrinkRows(w);
+        }
+
+        void Permute(const vector<I>& to) {
+            size_t n = w.size();
+            vector<Row, Alloc<Row>> fresh(w.get_allocator());
+            fresh.reserve(n);
+            for (size_t i = 0; i < n; ++i)
+                fresh.push_back(Row(n, W(), Alloc<W>(w.get_allocator())));
+            for (size_t u = 0; u < n; ++u)
+                for (size_t v = 0; v < n; ++v)
+                    fresh[to[u]][to[v]] = w[u][v];
+            w.swap(fresh);
+        }
+
+        W Get(I u, I v) const {
+            return w[u][v];
+        }
+
+        void Set(I u, I v, W x) {
+            w[u][v] = x;
+        }
+    };
+
+    /// <summary>
+    /// Невзвешенный граф: веса не хранятся
+    /// </summary>
+    template <typename I, typename A>
+    class DenseWeights<Unweighted, I, A> {
+    public:
+        explicit DenseWeights(const A&) {}
+        void AddVertex() {}
+        void EraseVertex(I) {}
+        void Clear() {}
+        void Memory(StorageMemory&) const {}
+        void ShrinkToFit() {}
+        void Permute(const vector<I>&) {}
+        Unweighted Get(I, I) const {
+            return Unweighted();
+        }
+        void Set(I, I, Unweighted) {}
+    };
+}
+
+/// <summary>
+/// Плотная матрица с битовой картой наличия рёбер и отдельными весами.
+/// Наличие ребра проверяется по биту, а не сравнением с INF, поэтому любое
+/// значение W допустимо как вес. Для W = Unweighted веса не хранятся:
+/// 1 бит на ячейку вместо sizeof(W) байт.
+/// </summary>
+template <typename W, typename I, typename A>
+class BitmapMatrix {
+    template <typename U>
+    using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+    using Bits = vector<uint64_t, Alloc<uint64_t>>;
+
+    /// <summary>
+    /// bits[i] - битовая строка исходящих рёбер вершины i
+    /// </summary>
+    vector<Bits, Alloc<Bits>> bits;
+
+    storage_detail::DenseWeights<W, I, A> weights;
+
+public:
+
+    BitmapMatrix(W, const A& alloc) : bits(Alloc<Bits>(alloc)), weights(alloc) {}
+
+    I Size() const {
+        return static_cast<I>(bits.size());
+    }
+
+    void AddVertex() {
+        size_t n = bits.size() + 1;
+        size_t words = (n + 63) / 64;
+        for (size_t i = 0; i < bits.size(); ++i)
+            bits[i].resize(words, 0);
+        bits.push_back(Bits(words, 0, Alloc<uint64_t>(bits.get_allocator())));
+        weights.AddVertex();
+    }
+
+    void EraseVertex(I idx) {
+        size_t n = bits.size();
+        bits.erase(bits.begin() + idx);
+        for (size_t i = 0; i < bits.size(); ++i)
+            storage_detail::EraseBit(bits[i], static_cast<size_t>(idx), n);
+        weights.EraseVertex(idx);
+    }
+
+    void Clear() {
+        bits.clear();
+        weights.Clear();
+    }
+
+    StorageMemory Memory() const {
+        StorageMemory m;
+        storage_detail::RowsMemory(bits, m.adjacency, m.adjacency, m.slack);
+        weights.Memory(m);
+        return m;
+    }
+
+    void ShrinkToFit() {
+        storage_detail::ShrinkRows(bits);
+        weights.ShrinkToFit();
+    }
+
+    void Permute(const vector<I>& to) {
+        size_t n = bits.size();
+        size_t words = (n + 63) / 64;
+        vector<Bits, Alloc<Bits>> fresh(bits.get_allocator());
+        fresh.reserve(n);
+        for (size_t i = 0; i < n; ++i)
+            fresh.push_back(Bits(words, 0, Alloc<uint64_t>(bits.get_allocator())));
+        for (size_t u = 0; u < n; ++u) {
+            for (size_t w = 0; w < bits[u].size(); ++w) {
+                for (uint64_t m = bits[u][w]; m; m &= m - 1) {
+                    size_t v = to[w * 64 + LowBit64(m)];
+                    fresh[to[u]][v / 64] |= uint64_t(1) << (v % 64);
+                }
+            }
+        }
+        bits.swap(fresh);
+        weights.Permute(to);
+    }
+
+    bool Has(I u, I v) const {
+        return (bits[u][v / 64] >> (v % 64)) & 1;
+    }
+
+    W Get(I u, I v) const {
+        return weights.Get(u, v);
+    }
+
+    void Set(I u, I v, W w) {
+        bits[u][v / 64] |= uint64_t(1) << (v % 64);
+        weights.Set(u, v, w);
+    }
+
+    void Reset(I u, I v) {
+        bits[u][v / 64] &= ~(uint64_t(1) << (v % 64));
+    }
+
+    template <typename It>
+    void MergeRow(I u, It first, It last) {
+        for (; first != last; ++first) {
+            if (first->erase)
+                Reset(u, first->to);
+            else
+                Set(u, first->to, first->w);
+        }
+    }
+
+    /// <summary>
+    /// Обход исходящих рёбер u по возрастанию индекса: f(v, w).
+    /// Пустые слова битовой строки пропускаются целиком.
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        const Bits& row = bits[u];
+        for (size_t w = 0; w < row.size(); ++w) {
+            for (uint64_t m = row[w]; m; m &= m - 1) {
+                I v = static_cast<I>(w * 64 + LowBit64(m));
+                f(v, weights.Get(u, v));
+            }
+        }
+    }
+
+    size_t ScanCost(I u) const {
+        return bits[u].size();
+    }
+};
+
+namespace storage_detail {
+
+    /// <summary>
+    /// Элемент списка смежности
+    /// </summary>
+    template <typename W, typename I>
+    struct ListEntry {
+        I to;
+        W w;
+        ListEntry(I to, W w) : to(to), w(w) {}
+        W Weight() const {
+            return w;
+        }
+        void SetWeight(W x) {
+            w = x;
+        }
+    };
+
+    /// <summary>
+    /// Элемент списка смежности невзвешенного графа: только номер вершины
+    /// </summary>
+    template <typename I>
+    struct ListEntry<Unweighted, I> {
+        I to;
+        ListEntry(I to, Unweighted) : to(to) {}
+        Unweighted Weight() const {
+            return Unweighted();
+        }
+        void SetWeight(Unweighted) {}
+    };
+}
+
+/// <summary>
+/// Списки смежности, упорядоченные по номеру вершины-приёмника.
+/// Память O(V + E); обходы стоят O(V + E) вместо O(V ^ 2);
+/// Has/Get - двоичный поиск в строке.
+/// </summary>
+template <typename W, typename I, typename A>
+class AdjacencyLists {
+    template <typename U>
+    using Alloc = typename allocator_traits<A>::template rebind_alloc<U>;
+    using Entry = storage_detail::ListEntry<W, I>;
+    using List = vector<Entry, Alloc<Entry>>;
+
+    vector<List, Alloc<List>> lists;
+
+    typename List::const_iterator Find(I u, I v) const {
+        const List& l = lists[u];
+        return lower_bound(l.begin(), l.end(), v, [](const Entry& e, I x) { return e.to < x; });
+    }
+
+public:
+
+    AdjacencyLists(W, const A& alloc) : lists(Alloc<List>(alloc)) {}
+
+    I Size() const {
+        return static_cast<I>(lists.size());
+    }
+
+    void AddVertex() {
+        lists.push_back(List(Alloc<Entry>(lists.get_allocator())));
+    }
+
+    void EraseVertex(I idx) {
+        lists.erase(lists.begin() + idx);
+        for (List& l : lists) {
+            auto it = lower_bound(l.begin(), l.end(), idx, [](const Entry& e, I x) { return e.to < x; });
+            if (it != l.end() && it->to == idx)
+                it = l.erase(it);
+            for (; it != l.end(); ++it)
+                --it->to;
+        }
+    }
+
+    void Clear() {
+        lists.clear();
+    }
+
+    /// <summary>
+    /// Элемент списка делится на приёмник (adjacency) и остаток с весом (weights)
+    /// </summary>
+    StorageMemory Memory() const {
+        StorageMemory m;
+        size_t entries = 0;
+        storage_detail::RowsMemory(lists, m.adjacency, entries, m.slack);
+        m.weights = entries / sizeof(Entry) * (sizeof(Entry) - sizeof(I));
+        m.adjacency += entries - m.weights;
+        return m;
+    }
+
+    void ShrinkToFit() {
+        storage_detail::ShrinkRows(lists);
+    }
+
+    void Permute(const vector<I>& to) {
+        vector<List, Alloc<List>> fresh(lists.size(), List(Alloc<Entry>(lists.get_allocator())), lists.get_allocator());
+        for (size_t u = 0; u < lists.size(); ++u) {
+            List& l = fresh[to[u]];
+            l.reserve(lists[u].size());
+            for (const Entry& e : lists[u])
+                l.push_back(Entry(to[e.to], e.Weight()));
+            sort(l.begin(), l.end(), [](const Entry& a, const Entry& b) { return a.to < b.to; });
+        }
+        lists.swap(fresh);
+    }
+
+    bool Has(I u, I v) const {
+        auto it = Find(u, v);
+        return it != lists[u].end() && it->to == v;
+    }
+
+    W Get(I u, I v) const {
+        return Find(u, v)->Weight();
+    }
+
+    void Set(I u, I v, W w) {
+        List& l = lists[u];
+        auto it = l.begin() + (Find(u, v) - l.cbegin());
+        if (it != l.end() && it->to == v)
+            it->SetWeight(w);
+        else
+            l.insert(it, Entry(v, w));
+    }
+
+    void Reset(I u, I v) {
+        List& l = lists[u];
+        auto it = l.begin() + (Find(u, v) - l.cbegin());
+        if (it != l.end() && it->to == v)
+            l.erase(it);
+    }
+
+    /// <summary>
+    /// Слияние строки u с упорядоченными изменениями за один проход:
+    /// O(|строка| + |изменения|) вместо вставки со сдвигом на каждое ребро
+    /// </summary>
+    template <typename It>
+    void MergeRow(I u, It first, It last) {
+        List& l = lists[u];
+        List merged(l.get_allocator());
+        merged.reserve(l.size() + static_cast<size_t>(last - first));
+        auto it = l.begin();
+        for (; first != last; ++first) {
+            for (; it != l.end() && it->to < first->to; ++it)
+                merged.push_back(*it);
+            if (it != l.end() && it->to == first->to)
+                ++it;
+            if (!first->erase)
+                merged.push_back(Entry(first->to, first->w));
+        }
+        merged.insert(merged.end(), it, l.end());
+        l.swap(merged);
+    }
+
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        for (const Entry& e : lists[u])
+            f(e.to, e.Weight());
+    }
+
+    size_t ScanCost(I u) const {
+        return lists[u].size();
+    }
+};
+
+/// <summary>
+/// Политика хранения: плотная матрица, "нет ребра" = INF (по умолчанию)
+/// </summary>
+struct DenseSentinel {
+    template <typename W, typename I, typename A>
+    using Storage = SentinelMatrix<W, I, A>;
+};
+
+/// <summary>
+/// Политика хранения: плотная матрица с битовой картой наличия рёбер
+/// (с W = Unweighted - только битовая карта)
+/// </summary>
+struct DenseBitmap {
+    template <typename W, typename I, typename A>
+    using Storage = BitmapMatrix<W, I, A>;
+};
+
+/// <summary>
+/// Политика хранения: упорядоченные списки смежности для разреженных графов
+/// </summary>
+struct AdjacencyList {
+    template <typename W, typename I, typename A>
+    using Storage = AdjacencyLists<W, I, A>;
+};
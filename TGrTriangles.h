@@ -0,0 +1,311 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include <type_traits>
+#include "TGrPool.h"
+#include "TGrIndex.h"
+
+using namespace std;
+
+/// <summary>
+/// Параметры подсчёта треугольников
+/// </summary>
+struct TriangleOptions {
+    /// <summary>
+    /// пересечение строк векторными инструкциями (SSE2, для 32-битных индексов)
+    /// </summary>
+    bool simd = true;
+
+    /// <summary>
+    /// строки не короче этого порога пересекаются через битовую карту:
+    /// строка отмечается один раз, соседи проверяются за O(1)
+    /// </summary>
+    size_t bitmapDegree = 256;
+};
+
+namespace tri_detail {
+
+    /// <summary>
+    /// Пересечение возрастающих массивов без повторов слиянием: emit(x) для каждого общего x
+    /// </summary>
+    template <typename I, typename F>
+    void IntersectScalar(const I* a, size_t na, const I* b, size_t nb, F emit) {
+        size_t i = 0, j = 0;
+        while (i < na && j < nb) {
+            if (a[i] < b[j])
+                ++i;
+            else if (b[j] < a[i])
+                ++j;
+            else {
+                emit(a[i]);
+                ++i;
+                ++j;
+            }
+        }
+    }
+
+    /// <summary>
+    /// Пересечение блоками по 4: каждый элемент блока a сравнивается со всеми
+    /// четырьмя элементами блока b (три циклических сдвига), затем сдвигается
+    /// блок с меньшим последним элементом. Хвосты - слиянием.
+    /// </summary>
+    template <typename I, typename F>
+    void Intersect(const I* a, size_t na, const I* b, size_t nb, bool simd, F emit) {
+#ifdef TGR_SSE2
+        if constexpr (sizeof(I) == 4 && is_integral<I>::value) {
+            if (simd) {
+                size_t i = 0, j = 0;
+                while (i + 4 <= na && j + 4 <= nb) {
+                    __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+                    __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+                    __m128i m = _mm_cmpeq_epi32(va, vb);
+                    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+                    m = _mm_or_si128(m, _mm_cmpeq_epi32(va, vb));
+                    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+                    m = _mm_or_si128(m, _mm_cmpeq_epi32(va, vb));
+                    vb = _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1));
+                    m = _mm_or_si128(m, _mm_cmpeq_epi32(va, vb));
+                    uint32_t mask = static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(m)));
+                    for (; mask; mask &= mask - 1)
+                        emit(a[i + LowBit(mask)]);
+                    I amax = a[i + 3], bmax = b[j + 3];
+                    if (!(bmax < amax))
+                        i += 4;
+                    if (!(amax < bmax))
+                        j += 4;
+                }
+                IntersectScalar(a + i, na - i, b + j, nb - j, emit);
+                return;
+            }
+        }
+#endif
+        (void)simd;
+        IntersectScalar(a, na, b, nb, emit);
+    }
+}
+
+/// <summary>
+/// Подсчёт треугольников и коэффициентов кластеризации.
+/// Направление рёбер не учитывается, петли и повторные рёбра отбрасываются:
+/// треугольник - три вершины, попарно связанные в любом направлении.
+///
+/// Вершины перенумеровываются по возрастанию степени, у каждой остаются только
+/// соседи с большим номером (ориентация по степени): каждый треугольник находится
+/// ровно один раз, а длина строки не превышает sqrt(2E) даже у вершин-концентраторов.
+/// Строки упорядочены, треугольники через ребро u -> v - пересечение строк u и v.
+/// Строки раздаются пулу мелкими частями (перехват задач выравнивает неравномерную
+/// нагрузку степенных графов), у каждого потока свои счётчики.
+/// </summary>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename I>
+class TriangleEngine {
+public:
+
+    /// <summary>
+    /// Построение по CSR ориентированного графа
+    /// Сложность: O(E log E)
+    /// </summary>
+    /// <param name="offs">смещения строк</param>
+    /// <param name="targs">приёмники рёбер</param>
+    /// <param name="pool">пул потоков</param>
+    /// <param name="opt">параметры</param>
+    TriangleEngine(const vector<size_t>& offs, const vector<I>& targs, ThreadPool& pool,
+        const TriangleOptions& opt = TriangleOptions())
+        : pool(pool), opt(opt) {
+        size_t n = offs.size() - 1;
+
+        // неориентированные строки: каждое ребро в обе стороны, затем сортировка и удаление повторов
+        vector<size_t> sOffs(n + 1, 0);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e)
+                if (targs[e] != static_cast<I>(u)) {
+                    ++sOffs[u + 1];
+                    ++sOffs[targs[e] + 1];
+                }
+        for (size_t v = 0; v < n; ++v)
+            sOffs[v + 1] += sOffs[v];
+        vector<I> sTargs(sOffs[n]);
+        vector<size_t> pos(sOffs.begin(), sOffs.end() - 1);
+        for (size_t u = 0; u < n; ++u)
+            for (size_t e = offs[u]; e < offs[u + 1]; ++e) {
+                I v = targs[e];
+                if (v == static_cast<I>(u))
+                    continue;
+                sTargs[pos[u]++] = v;
+                sTargs[pos[v]++] = static_cast<I>(u);
+            }
+        degree.assign(n, 0);
+        pool.ParallelFor(0, n, 256, [&](size_t u, unsigned) {
+            auto first = sTargs.begin() + sOffs[u], last = sTargs.begin() + sOffs[u + 1];
+            sort(first, last);
+            degree[u] = static_cast<size_t>(unique(first, last) - first);
+        });
+
+        // номера по возрастанию (степень, индекс)
+        label.resize(n);
+        for (size_t v = 0; v < n; ++v)
+            label[v] = static_cast<I>(v);
+        sort(label.begin(), label.end(), [&](I a, I b) {
+            return degree[a] != degree[b] ? degree[a] < degree[b] : a < b;
+        });
+        rank.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            rank[label[i]] = static_cast<I>(i);
+
+        // ориентированные строки в новых номерах
+        oOffs.assign(n + 1, 0);
+        for (size_t v = 0; v < n; ++v)
+            for (size_t e = sOffs[v]; e < sOffs[v] + degree[v]; ++e)
+                if (rank[sTargs[e]] > rank[v])
+                    ++oOffs[rank[v] + 1];
+        for (size_t i = 0; i < n; ++i)
+            oOffs[i + 1] += oOffs[i];
+        oTargs.resize(oOffs[n]);
+        pool.ParallelFor(0, n, 256, [&](size_t v, unsigned) {
+            I* out = oTargs.data() + oOffs[rank[v]];
+            size_t k = 0;
+            for (size_t e = sOffs[v]; e < sOffs[v] + degree[v]; ++e)
+                if (rank[sTargs[e]] > rank[v])
+                    out[k++] = rank[sTargs[e]];
+            sort(out, out + k);
+        });
+    }
+
+    /// <summary>
+    /// Количество вершин
+    /// </summary>
+    size_t Size() const {
+        return degree.size();
+    }
+
+    /// <summary>
+    /// Число различных соседей в любом направлении (без петель) по индексам вершин
+    /// </summary>
+    const vector<size_t>& Degrees() const {
+        return degree;
+    }
+
+    /// <summary>
+    /// Общее число треугольников
+    /// Сложность: O(E * sqrt(E) / потоки) в худшем случае
+    /// </summary>
+    uint64_t Count() const {
+        vector<Scratch> scratch(pool.Workers() + 1);
+        Run(scratch, [](Scratch& sc, I, I, I) { ++sc.total; });
+        uint64_t total = 0;
+        for (const Scratch& sc : scratch)
+            total += sc.total;
+        return total;
+    }
+
+    /// <summary>
+    /// Число треугольников, содержащих вершину, по индексам вершин
+    /// </summary>
+    vector<uint64_t> PerVertex() const {
+        size_t n = Size();
+        vector<Scratch> scratch(pool.Workers() + 1);
+        Run(scratch, [n](Scratch& sc, I u, I v, I w) {
+            if (sc.counts.empty())
+                sc.counts.assign(n, 0);
+            ++sc.counts[u];
+            ++sc.counts[v];
+            ++sc.counts[w];
+        });
+        vector<uint64_t> res(n, 0);
+        for (const Scratch& sc : scratch)
+            if (!sc.counts.empty())
+                for (size_t i = 0; i < n; ++i)
+                    res[label[i]] += sc.counts[i];
+        return res;
+    }
+
+    /// <summary>
+    /// Локальные коэффициенты кластеризации: 2 * T(v) / (d(v) * (d(v) - 1)),
+    /// 0 при d(v) меньше 2; по индексам вершин
+    /// </summary>
+    vector<double> Clustering() const {
+        vector<uint64_t> t = PerVertex();
+        vector<double> res(t.size(), 0.0);
+        for (size_t v = 0; v < t.size(); ++v) {
+            double d = static_cast<double>(degree[v]);
+            if (degree[v] >= 2)
+                res[v] = 2.0 * static_cast<double>(t[v]) / (d * (d - 1));
+        }
+        return res;
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return degree.capacity() * sizeof(size_t) + (label.capacity() + rank.capacity()) * sizeof(I)
+            + oOffs.capacity() * sizeof(size_t) + oTargs.capacity() * sizeof(I);
+    }
+
+private:
+    ThreadPool& pool;
+    TriangleOptions opt;
+
+    /// <summary>
+    /// степени и перенумерация: label[новый] = исходный, rank[исходный] = новый
+    /// </summary>
+    vector<size_t> degree;
+    vector<I> label, rank;
+
+    /// <summary>
+    /// строки ориентированного графа в новых номерах, по возрастанию
+    /// </summary>
+    vector<size_t> oOffs;
+    vector<I> oTargs;
+
+    /// <summary>
+    /// Счётчики и битовая карта потока
+    /// </summary>
+    struct Scratch {
+        uint64_t total = 0;
+        vector<uint64_t> counts;
+        vector<uint64_t> bits;
+    };
+
+    /// <summary>
+    /// Перебор треугольников u &lt; v &lt; w (новые номера): found(sc, u, v, w)
+    /// </summary>
+    template <typename F>
+    void Run(vector<Scratch>& scratch, F found) const {
+        size_t n = Size();
+        pool.ParallelFor(0, n, 32, [&](size_t ui, unsigned slot) {
+            Scratch& sc = scratch[slot];
+            I u = static_cast<I>(ui);
+            const I* a = oTargs.data() + oOffs[u];
+            size_t na = oOffs[u + 1] - oOffs[u];
+            if (na < 2)
+                return;
+            if (na >= opt.bitmapDegree) {
+                // длинная строка: отметить её соседей, проверять соседей соседей по карте
+                if (sc.bits.empty())
+                    sc.bits.assign((n + 63) / 64, 0);
+                for (size_t i = 0; i < na; ++i)
+                    sc.bits[a[i] / 64] |= uint64_t(1) << (a[i] % 64);
+                for (size_t i = 0; i < na; ++i) {
+                    I v = a[i];
+                    for (size_t e = oOffs[v]; e < oOffs[v + 1]; ++e) {
+                        I w = oTargs[e];
+                        if ((sc.bits[w / 64] >> (w % 64)) & 1)
+                            found(sc, u, v, w);
+                    }
+                }
+                for (size_t i = 0; i < na; ++i)
+                    sc.bits[a[i] / 64] = 0;
+                return;
+            }
+            for (size_t i = 0; i < na; ++i) {
+                I v = a[i];
+                // соседи w строки u, большие v, - после v в строке u
+                tri_detail::Intersect(a + i + 1, na - i - 1, oTargs.data() + oOffs[v], oOffs[v + 1] - oOffs[v],
+                    opt.simd, [&](I w) { found(sc, u, v, w); });
+            }
+        });
+    }
+};
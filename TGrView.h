@@ -0,0 +1,394 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <functional>
+#include <stdexcept>
+#include "TGrBatch.h"
+
+using namespace std;
+
+/// <summary>
+/// Представление графа без копирования хранилища: подграф, порождённый множеством вершин,
+/// фильтр рёбер по условию и обращение направления рёбер. Представления комбинируются:
+/// g.View().Induced(region).Filter(cheap).Reverse().
+///
+/// Представление хранит указатель на граф, маску вершин (бит на вершину) и условие,
+/// рёбра читаются из хранилища графа при каждом запросе. Граф должен существовать
+/// и не изменяться, пока используется представление. Индексы вершин - индексы графа.
+/// Materialize строит компактный граф только из видимых вершин и рёбер.
+/// </summary>
+/// <typeparam name="G">тип графа (DGraph)</typeparam>
+template <typename G>
+class GraphView {
+public:
+    using T = typename G::Vertex;
+    using W = typename G::Weight;
+    using I = typename G::Index;
+
+    /// <summary>
+    /// Условие на ребро: (начало, конец, вес) в направлении исходного графа
+    /// </summary>
+    using EdgePredicate = function<bool(const T&, const T&, const W&)>;
+
+    /// <summary>
+    /// Всё граф целиком
+    /// </summary>
+    explicit GraphView(const G& graph) : g(&graph) {}
+
+    /// <summary>
+    /// Подграф, порождённый вершинами keep (пересечение с уже видимыми)
+    /// Сложность: O(V + |keep|)
+    /// </summary>
+    /// <exception cref="runtime_error - одна из вершин не существует">
+    /// </exception>
+    GraphView Induced(const vector<T>& keep) const {
+        vector<bool> bitmap(g->Size(), false);
+        for (const T& v : keep) {
+            I i = g->IndexOf(v);
+            if (i < 0)
+                throw runtime_error("GraphView::Induced: вершина не найдена");
+            bitmap[i] = true;
+        }
+        return Induced(bitmap);
+    }
+
+    /// <summary>
+    /// Подграф, порождённый вершинами с bitmap[индекс] == true (пересечение с уже видимыми)
+    /// Сложность: O(V)
+    /// </summary>
+    /// <exception cref="runtime_error - размер bitmap не равен числу вершин графа">
+    /// </exception>
+    GraphView Induced(const vector<bool>& bitmap) const {
+        size_t n = static_cast<size_t>(g->Size());
+        if (bitmap.size() != n)
+            throw runtime_error("GraphView::Induced: размер маски не равен числу вершин");
+        auto m = make_shared<vector<uint64_t>>((n + 63) / 64, 0);
+        for (size_t v = 0; v < n; ++v)
+            if (bitmap[v] && Visible(static_cast<I>(v)))
+                (*m)[v / 64] |= uint64_t(1) << (v % 64);
+        GraphView r(*this);
+        r.mask = move(m);
+        return r;
+    }
+
+    /// <summary>
+    /// Только рёбра, для которых pred(начало, конец, вес) истинно (вместе с уже действующими условиями).
+    /// Начало и конец - в направлении исходного графа, независимо от Reverse.
+    /// </summary>
+    GraphView Filter(EdgePredicate pred) const {
+        GraphView r(*this);
+        if (predicate) {
+            EdgePredicate prev = predicate;
+            r.predicate = [prev, pred](const T& a, const T& b, const W& w) { return prev(a, b, w) && pred(a, b, w); };
+        }
+        else
+            r.predicate = move(pred);
+        return r;
+    }
+
+    /// <summary>
+    /// Обращение направления всех рёбер (транспонирование)
+    /// </summary>
+    GraphView Reverse() const {
+        GraphView r(*this);
+        r.reversed = !reversed;
+        return r;
+    }
+
+    /// <summary>
+    /// Количество видимых вершин
+    /// Сложность: O(V / 64)
+    /// </summary>
+    int Size() const {
+        if (!mask)
+            return g->Size();
+        size_t c = 0;
+        for (uint64_t word : *mask)
+            for (; word; word &= word - 1)
+                ++c;
+        return static_cast<int>(c);
+    }
+
+    /// <summary>
+    /// Видна ли вершина
+    /// </summary>
+    bool HasVert(const T& v) const {
+        I i = g->IndexOf(v);
+        return i >= 0 && Visible(i);
+    }
+
+    /// <summary>
+    /// Есть ли ребро from -> to в представлении
+    /// </summary>
+    bool HasEdge(const T& from, const T& to) const {
+        I u = g->IndexOf(from);
+        I v = g->IndexOf(to);
+        if (u < 0 || v < 0 || !Visible(u) || !Visible(v))
+            return false;
+        if (reversed)
+            swap(u, v);
+        return g->HasEdgeAt(u, v) && Pass(u, v, g->EdgeAt(u, v));
+    }
+
+    /// <summary>
+    /// Вес ребра from -> to в представлении
+    /// </summary>
+    /// <exception cref="runtime_error - вершина не видна или ребро отсутствует">
+    /// </exception>
+    W GetWeight(const T& from, const T& to) const {
+        if (!HasEdge(from, to))
+            throw runtime_error("GraphView::GetWeight: ребро отсутствует");
+        return reversed ? g->EdgeAt(g->IndexOf(to), g->IndexOf(from)) : g->EdgeAt(g->IndexOf(from), g->IndexOf(to));
+    }
+
+    /// <summary>
+    /// Перебор рёбер представления из вершины с индексом u: f(индекс соседа, вес).
+    /// Для обращённого представления - просмотр входящих рёбер по всем видимым вершинам.
+    /// Сложность: как у исходящих рёбер графа; для Reverse - O(V) проверок ребра
+    /// </summary>
+    template <typename F>
+    void ForEachOut(I u, F f) const {
+        if (!reversed) {
+            g->ForEachOut(u, [&](I v, const W& w) {
+                if (Visible(v) && Pass(u, v, w))
+                    f(v, w);
+            });
+            return;
+        }
+        I n = static_cast<I>(g->Size());
+        for (I v = 0; v < n; ++v)
+            if (Visible(v) && g->HasEdgeAt(v, u)) {
+                W w = g->EdgeAt(v, u);
+                if (Pass(v, u, w))
+                    f(v, w);
+            }
+    }
+
+    /// <summary>
+    /// Обход в ширину, порядок совпадает с BFS материализованного графа
+    /// Сложность: O(V + E) (для Reverse - с построением обратных строк за один просмотр рёбер)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не видна">
+    /// </exception>
+    vector<T> BFS(const T& start) const {
+        I s = Require(start, "BFS");
+        Rows rows = Build();
+        vector<char> seen(g->Size(), 0);
+        vector<I> q;
+        vector<T> order;
+        q.push_back(s);
+        seen[s] = 1;
+        for (size_t head = 0; head < q.size(); ++head) {
+            I u = q[head];
+            order.push_back(g->VertexAt(u));
+            Scan(rows, u, [&](I v, const W&) {
+                if (!seen[v]) {
+                    seen[v] = 1;
+                    q.push_back(v);
+                }
+            });
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Обход в глубину, порядок совпадает с DFS материализованного графа
+    /// Сложность: O(V + E)
+    /// </summary>
+    /// <exception cref="runtime_error - начальная вершина не видна">
+    /// </exception>
+    vector<T> DFS(const T& start) const {
+        I s = Require(start, "DFS");
+        Rows rows = Build();
+        vector<char> visited(g->Size(), 0);
+        vector<I> st;
+        vector<T> order;
+        st.push_back(s);
+        while (!st.empty()) {
+            I u = st.back();
+            st.pop_back();
+            if (visited[u])
+                continue;
+            visited[u] = 1;
+            order.push_back(g->VertexAt(u));
+            Scan(rows, u, [&](I v, const W&) {
+                if (!visited[v])
+                    st.push_back(v);
+            });
+        }
+        return order;
+    }
+
+    /// <summary>
+    /// Алгоритм Форда-Беллмана по рёбрам представления. Обращению строки не нужны:
+    /// ребро u -> v графа релаксируется как v -> u. Останавливается досрочно,
+    /// если проход ничего не улучшил.
+    /// Сложность: O(V * E)
+    /// </summary>
+    /// <returns>длины кратчайших путей по индексам графа (INF - недостижима или не видна)</returns>
+    /// <exception cref="runtime_error - начальная вершина не видна или обнаруживается отрицательный цикл">
+    /// </exception>
+    vector<W> BellmanFord(const T& start) const {
+        I s = Require(start, "BellmanFord");
+        W INF = g->Inf();
+        I n = static_cast<I>(g->Size());
+        vector<W> dist(n, INF);
+        dist[s] = 0;
+        // relax(u, v, w): ребро графа u -> v, в представлении a -> b
+        auto relax = [&](I u, I v, const W& w) {
+            I a = reversed ? v : u, b = reversed ? u : v;
+            if (dist[a] != INF && dist[b] > dist[a] + w) {
+                dist[b] = dist[a] + w;
+                return true;
+            }
+            return false;
+        };
+        bool changed = true;
+        for (I k = 0; k < n && changed; ++k) {
+            changed = false;
+            ForEachEdge([&](I u, I v, const W& w) {
+                changed |= relax(u, v, w);
+            });
+        }
+        if (changed)
+            throw runtime_error("Обнаружен отрицательный цикл!");
+        return dist;
+    }
+
+    /// <summary>
+    /// Видимые соседи вершины в любом направлении, по возрастанию индекса (как DGraph::GetNeighbors)
+    /// Сложность: O(V) проверок ребра
+    /// </summary>
+    /// <exception cref="runtime_error - вершина не видна">
+    /// </exception>
+    vector<T> GetNeighbors(const T& vertex) const {
+        I u = Require(vertex, "GetNeighbors");
+        vector<T> neighbors;
+        I n = static_cast<I>(g->Size());
+        for (I j = 0; j < n; ++j) {
+            if (!Visible(j))
+                continue;
+            if ((g->HasEdgeAt(u, j) && Pass(u, j, g->EdgeAt(u, j)))
+                || (g->HasEdgeAt(j, u) && Pass(j, u, g->EdgeAt(j, u))))
+                neighbors.push_back(g->VertexAt(j));
+        }
+        return neighbors;
+    }
+
+    /// <summary>
+    /// Построение компактного графа из видимых вершин (в порядке индексов) и рёбер представления
+    /// одним пакетом изменений (DGraph::Apply)
+    /// Сложность: O(V + E) просмотра плюс построение графа Out
+    /// </summary>
+    /// <typeparam name="Out">тип результата, по умолчанию тип исходного графа</typeparam>
+    template <typename Out = G>
+    Out Materialize() const {
+        Out res(g->Inf());
+        MutationBatch<T, W> batch;
+        I n = static_cast<I>(g->Size());
+        for (I v = 0; v < n; ++v)
+            if (Visible(v))
+                batch.AddV(g->VertexAt(v));
+        ForEachEdge([&](I u, I v, const W& w) {
+            if (reversed)
+                batch.AddE(g->VertexAt(v), g->VertexAt(u), w);
+            else
+                batch.AddE(g->VertexAt(u), g->VertexAt(v), w);
+        });
+        res.Apply(batch);
+        return res;
+    }
+
+private:
+    const G* g;
+
+    /// <summary>
+    /// маска видимых вершин (nullptr - все); общая для копий представления
+    /// </summary>
+    shared_ptr<const vector<uint64_t>> mask;
+
+    /// <summary>
+    /// условие на рёбра (пусто - все)
+    /// </summary>
+    EdgePredicate predicate;
+
+    bool reversed = false;
+
+    /// <summary>
+    /// Строки обращённого представления (для обхода), пусты без Reverse
+    /// </summary>
+    struct Rows {
+        vector<size_t> offs;
+        vector<I> targs;
+        vector<W> ws;
+    };
+
+    bool Visible(I v) const {
+        return !mask || (((*mask)[v / 64] >> (v % 64)) & 1);
+    }
+
+    bool Pass(I u, I v, const W& w) const {
+        return !predicate || predicate(g->VertexAt(u), g->VertexAt(v), w);
+    }
+
+    I Require(const T& v, const char* what) const {
+        I i = g->IndexOf(v);
+        if (i < 0 || !Visible(i))
+            throw runtime_error(string("GraphView::") + what + ": вершина не найдена");
+        return i;
+    }
+
+    /// <summary>
+    /// Все видимые рёбра в направлении графа: f(u, v, w) по возрастанию u, затем v
+    /// </summary>
+    template <typename F>
+    void ForEachEdge(F f) const {
+        I n = static_cast<I>(g->Size());
+        for (I u = 0; u < n; ++u) {
+            if (!Visible(u))
+                continue;
+            g->ForEachOut(u, [&](I v, const W& w) {
+                if (Visible(v) && Pass(u, v, w))
+                    f(u, v, w);
+            });
+        }
+    }
+
+    /// <summary>
+    /// Для обращённого представления - входящие строки подсчётом за один просмотр рёбер
+    /// (источники в строке по возрастанию, как в материализованном графе)
+    /// </summary>
+    Rows Build() const {
+        Rows r;
+        if (!reversed)
+            return r;
+        size_t n = static_cast<size_t>(g->Size());
+        r.offs.assign(n + 1, 0);
+        ForEachEdge([&](I, I v, const W&) { ++r.offs[v + 1]; });
+        for (size_t i = 0; i < n; ++i)
+            r.offs[i + 1] += r.offs[i];
+        r.targs.resize(r.offs[n]);
+        r.ws.resize(r.offs[n]);
+        vector<size_t> pos(r.offs.begin(), r.offs.end() - 1);
+        ForEachEdge([&](I u, I v, const W& w) {
+            size_t p = pos[v]++;
+            r.targs[p] = u;
+            r.ws[p] = w;
+        });
+        return r;
+    }
+
+    template <typename F>
+    void Scan(const Rows& rows, I u, F f) const {
+        if (!reversed) {
+            g->ForEachOut(u, [&](I v, const W& w) {
+                if (Visible(v) && Pass(u, v, w))
+                    f(v, w);
+            });
+            return;
+        }
+        for (size_t e = rows.offs[u]; e < rows.offs[u + 1]; ++e)
+            f(rows.targs[e], rows.ws[e]);
+    }
+};
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+using namespace std;
+
+/// <summary>
+/// Рабочие массивы обходов для многократного использования.
+/// Отметки "посещена" и "в очереди" хранят номер эпохи: новая эпоха делает все
+/// отметки недействительными за O(1), без обнуления массивов размера V.
+/// Расстояния и длины путей считаются действительными только для вершин,
+/// отмеченных в текущей эпохе, поэтому тоже не заполняются заново.
+/// Память выделяется только при росте графа.
+///
+/// Рабочая область не потокобезопасна: заводится по одной на поток.
+/// После обхода результат доступен до следующего обхода с этой рабочей областью.
+/// </summary>
+/// <typeparam name="W">тип весов рёбер</typeparam>
+/// <typeparam name="I">тип индекса вершины</typeparam>
+template <typename W, typename I = int>
+class TraversalWorkspace {
+public:
+
+    /// <summary>
+    /// Подготовка к обходу графа из n вершин: новая эпоха, при необходимости рост массивов
+    /// </summary>
+    /// <returns>True - массивы пришлось увеличить</returns>
+    bool Begin(size_t n) {
+        bool grown = false;
+        if (visited.size() < n) {
+            visited.resize(n, 0);
+            queued.resize(n, 0);
+            dist.resize(n);
+            hops.resize(n);
+            grown = true;
+        }
+        if (++epoch == 0) {
+            // переполнение счётчика эпох: единственный случай полной очистки
+            fill(visited.begin(), visited.end(), 0);
+            fill(queued.begin(), queued.end(), 0);
+            epoch = 1;
+        }
+        order.clear();
+        frontier.clear();
+        return grown;
+    }
+
+    /// <summary>
+    /// Вершина достигнута последним обходом
+    /// </summary>
+    bool Reached(I v) const {
+        return static_cast<size_t>(v) < visited.size() && visited[v] == epoch;
+    }
+
+    /// <summary>
+    /// Расстояние до вершины, найденное последним BellmanFord (только для Reached(v))
+    /// </summary>
+    const W& Dist(I v) const {
+        return dist[v];
+    }
+
+    /// <summary>
+    /// Индексы достигнутых вершин в порядке обхода
+    /// (для BellmanFord - в порядке первого достижения)
+    /// </summary>
+    const vector<I>& Order() const {
+        return order;
+    }
+
+    /// <summary>
+    /// Вместимость массивов (число вершин)
+    /// </summary>
+    size_t Capacity() const {
+        return visited.size();
+    }
+
+    /// <summary>
+    /// Занимаемая память, байт
+    /// </summary>
+    size_t MemoryBytes() const {
+        return visited.capacity() * sizeof(uint32_t) + queued.capacity() * sizeof(uint32_t)
+            + dist.capacity() * sizeof(W) + hops.capacity() * sizeof(I)
+            + order.capacity() * sizeof(I) + frontier.capacity() * sizeof(I);
+    }
+
+    /// <summary>
+    /// Отметить вершину посещённой; false, если уже посещена в этой эпохе
+    /// </summary>
+    bool Visit(I v) {
+        if (visited[v] == epoch)
+            return false;
+        visited[v] = epoch;
+        return true;
+    }
+
+    bool Visited(I v) const {
+        return visited[v] == epoch;
+    }
+
+    /// <summary>
+    /// Отметить вершину поставленной в очередь; false, если уже в очереди
+    /// </summary>
+    bool Enqueue(I v) {
+        if (queued[v] == epoch)
+            return false;
+        queued[v] = epoch;
+        return true;
+    }
+
+    /// <summary>
+    /// Снять отметку "в очереди" (для повторной постановки)
+    /// </summary>
+    void Dequeue(I v) {
+        queued[v] = 0;
+    }
+
+    W& DistRef(I v) {
+        return dist[v];
+    }
+
+    I& Hops(I v) {
+        return hops[v];
+    }
+
+    vector<I>& OrderRef() {
+        return order;
+    }
+
+    /// <summary>
+    /// Очередь или стек обхода
+    /// </summary>
+    vector<I>& Frontier() {
+        return frontier;
+    }
+
+private:
+    uint32_t epoch = 0;
+    vector<uint32_t> visited;
+    vector<uint32_t> queued;
+    vector<W> dist;
+    vector<I> hops;
+    vector<I> order;
+    vector<I> frontier;
+};